@@ -17,12 +17,21 @@
 /// templates implement the std::allocator concept and can be used with
 /// std:: containers by specifying them in the container's template parameter.
 ///
+namespace ircd::ctx
+{
+	struct ctx;
+}
+
 namespace ircd::allocator
 {
 	struct state;
+	struct arena;
 	template<class T = char> struct dynamic;
 	template<class T = char, size_t = 512> struct fixed;
 	template<class T> struct node;
+
+	arena &attached(ctx::ctx &);         // defined in ctx.cc
+	arena *scratch() noexcept;
 };
 
 /// Internal state structure for some of these tools. This is a very small and
@@ -460,3 +469,148 @@ const
 
 	return ret - n;
 }
+
+/// Bump allocator for short-lived scratch memory.
+///
+/// Each context has one of these (see attached()), which is only used while
+/// an arena::scope is open on that context's stack. Such scopes are opened
+/// around units of work whose scratch memory is all garbage by the time they
+/// return, i.e client::handle_request() and m::vm::eval. Allocation is an
+/// alignment and a bounds check on the current block; a free is ignored
+/// unless it was the last allocation. Nested scopes only count depth and
+/// nothing is released until the outermost scope closes, when all but the
+/// first block go back to the heap: a container from an outer scope may
+/// grow while an inner one is open, so an inner scope can't rewind.
+///
+/// Memory is only taken from the arena by asking for it: pass scratch() to
+/// a unique_buffer or use arena::allocator for a container. scratch() is
+/// null when no scope is open (or on the main stack), in which case these
+/// fall back to the heap. Nothing allocated this way can outlive the scope.
+///
+struct ircd::allocator::arena
+{
+	struct block;
+	struct mark;
+	struct scope;
+	template<class T> struct allocator;
+
+	std::vector<block> blocks;
+	size_t cur {0};                    ///< Index of the block being bumped
+	size_t depth {0};                  ///< Number of scopes open
+	size_t block_size;                 ///< Size of a block from the heap
+
+  public:
+	size_t allocated() const;          ///< Bytes held from the heap
+	size_t used() const;               ///< Bytes handed out (with padding)
+
+	void *allocate(const size_t &size, const size_t &align = alignof(std::max_align_t));
+	void deallocate(void *const &ptr, const size_t &size) noexcept;
+
+	mark tell() const noexcept;
+	void rewind(const mark &) noexcept;
+	void reset() noexcept;
+
+	arena(const size_t &block_size);
+	arena();
+	arena(arena &&) = delete;
+	arena(const arena &) = delete;
+	arena &operator=(arena &&) = delete;
+	arena &operator=(const arena &) = delete;
+	~arena() noexcept;
+};
+
+struct ircd::allocator::arena::block
+{
+	std::unique_ptr<uint8_t[]> buf;
+	size_t size {0};
+	size_t used {0};
+};
+
+/// Position in an arena to rewind() to.
+struct ircd::allocator::arena::mark
+{
+	size_t block {0};
+	size_t used {0};
+};
+
+/// Open on the stack around a unit of work to give the current context's
+/// arena to scratch() for its duration. Everything allocated from the arena
+/// is released when the outermost scope on the context closes.
+struct ircd::allocator::arena::scope
+{
+	arena *a {nullptr};
+
+  public:
+	scope();
+	scope(scope &&) = delete;
+	scope(const scope &) = delete;
+	scope &operator=(scope &&) = delete;
+	scope &operator=(const scope &) = delete;
+	~scope() noexcept;
+};
+
+/// The template passed to containers for using an arena. Default constructed
+/// it uses scratch(), and the heap if that is null.
+///
+///     std::vector<json::value, allocator::arena::allocator<json::value>> v;
+///
+template<class T>
+struct ircd::allocator::arena::allocator
+{
+	using value_type         = T;
+	using pointer            = T *;
+	using const_pointer      = const T *;
+	using reference          = T &;
+	using const_reference    = const T &;
+	using size_type          = std::size_t;
+	using difference_type    = std::ptrdiff_t;
+
+	arena *a;
+
+  public:
+	template<class U> struct rebind
+	{
+		using other = arena::allocator<U>;
+	};
+
+	size_type max_size() const                   { return std::numeric_limits<size_t>::max() / sizeof(T); }
+
+	pointer allocate(const size_type &n, const const_pointer &hint = nullptr)
+	{
+		return a?
+			reinterpret_cast<pointer>(a->allocate(n * sizeof(T), alignof(T))):
+			std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(const pointer &p, const size_type &n)
+	{
+		if(a)
+			a->deallocate(p, n * sizeof(T));
+		else
+			std::allocator<T>().deallocate(p, n);
+	}
+
+	template<class U>
+	allocator(const arena::allocator<U> &s) noexcept
+	:a{s.a}
+	{}
+
+	allocator(arena *const &a = scratch()) noexcept
+	:a{a}
+	{}
+
+	allocator(allocator &&) noexcept = default;
+	allocator(const allocator &) = default;
+	allocator &operator=(allocator &&) noexcept = default;
+	allocator &operator=(const allocator &) = default;
+
+	friend bool operator==(const allocator &a, const allocator &b)
+	{
+		return a.a == b.a;
+	}
+
+	friend bool operator!=(const allocator &a, const allocator &b)
+	{
+		return a.a != b.a;
+	}
+};
@@ -20,6 +20,16 @@ namespace boost::asio
 	struct mutable_buffer;
 }
 
+// Forward declarations for unique_buffer memory from a scratch arena (see
+// allocator.h) because that is included after this.
+namespace ircd::allocator
+{
+	struct arena;
+
+	void *allocate(arena &, const size_t &size, const size_t &align);
+	void deallocate(arena &, void *const &, const size_t &size) noexcept;
+}
+
 /// Lightweight buffer interface compatible with boost::asio IO buffers and vectors
 ///
 /// A const_buffer is a pair of iterators like `const char *` meant for sending
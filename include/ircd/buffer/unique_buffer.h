@@ -13,12 +13,20 @@
 
 /// Like unique_ptr, this template holds ownership of an allocated buffer
 ///
+/// The buffer can instead be taken from a scratch arena (see allocator.h)
+/// by passing allocator::scratch() at construction; it is given back to the
+/// arena on destruction. If that is null the heap is used as usual. Such a
+/// buffer must not outlive the arena::scope it was allocated in.
+///
 template<class buffer,
          uint alignment>
 struct ircd::buffer::unique_buffer
 :buffer
 {
+	allocator::arena *arena {nullptr};
+
 	unique_buffer(std::unique_ptr<uint8_t[]> &&, const size_t &size);
+	unique_buffer(const size_t &size, allocator::arena *const &);
 	unique_buffer(const size_t &size);
 	unique_buffer();
 	unique_buffer(unique_buffer &&) noexcept;
@@ -67,6 +75,22 @@ ircd::buffer::unique_buffer<buffer, alignment>::unique_buffer(const size_t &size
 	assert(alignment == 16);
 }
 
+template<class buffer,
+         uint alignment>
+ircd::buffer::unique_buffer<buffer, alignment>::unique_buffer(const size_t &size,
+                                                              allocator::arena *const &arena)
+:buffer
+{
+	arena?
+		typename buffer::iterator(allocator::allocate(*arena, size, alignment)):
+		typename buffer::iterator(new __attribute__((aligned(16))) uint8_t[size]),
+	size
+}
+,arena{arena}
+{
+	assert(alignment == 16);
+}
+
 template<class buffer,
          uint alignment>
 ircd::buffer::unique_buffer<buffer, alignment>::unique_buffer(unique_buffer &&other)
@@ -75,6 +99,10 @@ noexcept
 {
 	std::move(static_cast<buffer &>(other))
 }
+,arena
+{
+	std::move(other.arena)
+}
 {
 	get<0>(other) = nullptr;
 }
@@ -88,6 +116,7 @@ noexcept
 	this->~unique_buffer();
 
 	static_cast<buffer &>(*this) = std::move(static_cast<buffer &>(other));
+	arena = std::move(other.arena);
 	get<0>(other) = nullptr;
 
 	return *this;
@@ -98,5 +127,8 @@ template<class buffer,
 ircd::buffer::unique_buffer<buffer, alignment>::~unique_buffer()
 noexcept
 {
-	delete[] data(*this);
+	if(arena && data(*this))
+		allocator::deallocate(*arena, data(*this), size(*this));
+	else
+		delete[] data(*this);
 }
@@ -30,6 +30,8 @@ struct ircd::client
 	struct conf;
 	struct settings;
 	struct request;
+	struct stats;
+	struct lane;
 
 	static struct settings settings;
 	static struct conf default_conf;
@@ -46,16 +48,23 @@ struct ircd::client
 	std::shared_ptr<socket> sock;
 	uint64_t id {++ctr};
 	ctx::ctx *reqctx {nullptr};
+	ctx::pool::prio prio {ctx::pool::NORMAL};
+	steady_point queued;
+	nanoseconds queue_wait {0ns};
 	ircd::timer timer;
 	size_t head_length {0};
 	size_t content_consumed {0};
 	resource::request request;
+	compress::type encoding {compress::NONE};
+	int8_t encoding_level {0};
 
+	size_t write_all(const vector_view<const const_buffer> &);
 	size_t write_all(const const_buffer &);
 	void close(const net::close_opts &, net::close_callback);
 	ctx::future<void> close(const net::close_opts & = {});
 
 	void discard_unconsumed(const http::request::head &);
+	void admit(lane &);
 	bool resource_request(const http::request::head &);
 	bool handle_request(parse::capstan &pc);
 	bool main() noexcept;
@@ -100,6 +109,52 @@ struct ircd::client::settings
 {
 	static ircd::conf::item<size_t> stack_size;
 	static ircd::conf::item<size_t> pool_size;
+	static ircd::conf::item<size_t> pool_max;
+	static ircd::conf::item<milliseconds> pool_grow_wait;
+	static ircd::conf::item<seconds> pool_idle;
+	static ircd::conf::item<milliseconds> pool_starve;
+};
+
+/// Metrics for all clients; see ircd::stats
+struct ircd::client::stats
+{
+	static ircd::stats::counter accepted;
+	static ircd::stats::gauge connected;
+	static ircd::stats::counter requests;
+	static ircd::stats::histogram request_time;
+	static ircd::stats::histogram queue_wait;
+};
+
+/// Admission control for the request pool by class of traffic.
+///
+/// Every request is assigned a lane by its path once its head has been read.
+/// It is refused with a 503 before any handler runs when it waited longer
+/// than the lane's wait_max for a context (the pool is saturated and this
+/// request would only add to the backlog), or when the lane already has
+/// active_max requests underway (i.e long media transfers can't occupy the
+/// contexts federation needs). Zero disables either check.
+///
+struct ircd::client::lane
+{
+	static lane federation;
+	static lane media;
+	static lane clients;
+
+	string_view name;
+	ircd::conf::item<milliseconds> wait_max;
+	ircd::conf::item<size_t> active_max;
+	ircd::stats::counter rejected;
+	size_t active {0};
+
+	static lane &find(const string_view &path);
+
+	lane(const string_view &name,
+	     const json::members &wait_max,
+	     const json::members &active_max,
+	     const string_view &rejected);
+
+	lane(lane &&) = delete;
+	lane(const lane &) = delete;
 };
 
 struct ircd::client::init
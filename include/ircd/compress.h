@@ -0,0 +1,101 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_COMPRESS_H
+
+/// Streaming content compression for HTTP (Content-Encoding). The libraries
+/// are optional at build time; an encoding which isn't available is never
+/// negotiated and find() of it returns NONE.
+namespace ircd::compress
+{
+	enum type :uint8_t;
+	struct deflater;
+	struct inflater;
+
+	IRCD_EXCEPTION(ircd::error, error)
+
+	using sink = std::function<void (const const_buffer &)>;
+
+	// Content-Encoding token for type; "identity" for NONE.
+	string_view reflect(const type &);
+
+	// Available type for a Content-Encoding token, or NONE.
+	type find(const string_view &coding);
+
+	// Best available type in an Accept-Encoding header value, or NONE.
+	type negotiate(const string_view &accept_encoding);
+
+	// Accept-Encoding header value listing what we can decode.
+	string_view accepted();
+
+	// Maximum output of compressing size bytes in one call with finish.
+	size_t bound(const type &, const size_t &size);
+
+	// One-shot compression; out must be at least bound() in size.
+	const_buffer deflate(const mutable_buffer &out, const const_buffer &in, const type &, const int &level);
+}
+
+enum ircd::compress::type
+:uint8_t
+{
+	NONE,
+	GZIP,
+	ZSTD,
+};
+
+/// Compresses a stream of input buffers. Output is passed to the sink as
+/// it becomes available; it may be called zero or more times for each
+/// input and for finish(). The buffer given to the sink is only valid
+/// for that call.
+struct ircd::compress::deflater
+{
+	struct state;
+
+	enum type type {NONE};
+	std::unique_ptr<state> s;
+
+  public:
+	size_t in {0};                     ///< Total bytes consumed
+	size_t out {0};                    ///< Total bytes given to the sink
+
+	void operator()(const const_buffer &, const sink &);
+	void finish(const sink &);
+
+	deflater(const enum type &, const int &level);
+	deflater();
+	deflater(deflater &&) noexcept;
+	deflater(const deflater &) = delete;
+	deflater &operator=(deflater &&) noexcept;
+	deflater &operator=(const deflater &) = delete;
+	~deflater() noexcept;
+};
+
+/// Decompresses a stream of input buffers; see deflater.
+struct ircd::compress::inflater
+{
+	struct state;
+
+	enum type type {NONE};
+	std::unique_ptr<state> s;
+
+  public:
+	size_t in {0};
+	size_t out {0};
+
+	void operator()(const const_buffer &, const sink &);
+
+	inflater(const enum type &);
+	inflater(inflater &&) noexcept;
+	inflater(const inflater &) = delete;
+	inflater &operator=(inflater &&) noexcept;
+	inflater &operator=(const inflater &) = delete;
+	~inflater() noexcept;
+};
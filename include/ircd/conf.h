@@ -26,6 +26,8 @@ namespace ircd::conf
 	template<class T> struct value;        // abstraction for carrying item value
 	template<class T> struct lex_castable; // abstraction for lex_cast compatible
 
+	using set_cb = std::function<void ()>;
+
 	IRCD_EXCEPTION(ircd::error, error)
 	IRCD_EXCEPTION(error, not_found)
 	IRCD_EXCEPTION(error, bad_value)
@@ -48,11 +50,12 @@ struct ircd::conf::item<void>
 	json::strung feature_;
 	json::object feature;
 	string_view name;
+	conf::set_cb set_cb;
 
 	virtual string_view get(const mutable_buffer &) const;
 	virtual bool set(const string_view &);
 
-	item(const json::members &);
+	item(const json::members &, conf::set_cb = {});
 	item(item &&) = delete;
 	item(const item &) = delete;
 	virtual ~item() noexcept;
@@ -95,8 +98,8 @@ struct ircd::conf::lex_castable
 		return true;
 	}
 
-	lex_castable(const json::members &members)
-	:conf::item<>{members}
+	lex_castable(const json::members &members, conf::set_cb set_cb = {})
+	:conf::item<>{members, std::move(set_cb)}
 	,conf::value<T>(feature.get("default", long(0)))
 	{}
 };
@@ -122,8 +125,8 @@ struct ircd::conf::item<std::string>
 		return true;
 	}
 
-	item(const json::members &members)
-	:conf::item<>{members}
+	item(const json::members &members, conf::set_cb set_cb = {})
+	:conf::item<>{members, std::move(set_cb)}
 	,value{unquote(feature.get("default"))}
 	{}
 };
@@ -70,9 +70,22 @@ namespace ircd::ctx
 	void yield(ctx &);                           // Direct context switch to arg
 }
 
+/// Metrics for all contexts; see ircd::stats
+namespace ircd::ctx::stats
+{
+	extern ircd::stats::counter spawned;
+	extern ircd::stats::gauge contexts;
+	extern ircd::stats::counter yields;
+	extern ircd::stats::counter slice_cycles;
+	extern ircd::stats::gauge stack_mapped;
+	extern ircd::stats::gauge stack_pooled;
+	extern ircd::stats::counter stack_reused;
+}
+
 #include "this_ctx.h"
 #include "context.h"
 #include "prof.h"
+#include "stack.h"
 #include "list.h"
 #include "dock.h"
 #include "queue.h"
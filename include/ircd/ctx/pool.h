@@ -16,9 +16,48 @@ namespace ircd::ctx
 	struct pool;
 }
 
+/// A pool of contexts which execute queued closures.
+///
+/// By default the pool has a fixed size controlled with add() and del(). When
+/// opts.max is set the pool is elastic: a context is added when a closure has
+/// been waiting in the queue for opts.grow_wait with nothing available to
+/// run it, up to opts.max; a context which finds nothing to do for opts.idle
+/// exits while the pool is larger than opts.min. Growth is checked when a
+/// closure is queued, when a context takes one, and by a watcher context
+/// while closures wait with every context busy.
+///
+/// Closures are queued by priority class. Classes are served in proportion
+/// to opts.weight (i.e with the defaults up to eight HIGH closures are run
+/// for each BULK closure while both are waiting) rather than strictly, and
+/// the oldest closure which has waited longer than opts.starve is run ahead
+/// of its class, at most every other dispatch.
+///
 struct ircd::ctx::pool
 {
+	enum prio :uint8_t;
 	using closure = std::function<void ()>;
+	static constexpr const size_t PRIOS {3};
+
+	struct opts
+	{
+		/// Contexts retained when idle; an elastic pool won't shrink below this.
+		size_t min {0};
+
+		/// Limit to growth; zero for a pool of fixed size.
+		size_t max {0};
+
+		/// Queueing delay tolerated before another context is added.
+		milliseconds grow_wait {0ms};
+
+		/// Time a context above min waits for work before it exits.
+		seconds idle {60s};
+
+		/// Share of dispatches for each priority class when all are waiting.
+		std::array<uint, PRIOS> weight {{ 8, 4, 1 }};
+
+		/// Queueing delay after which a closure is run ahead of any class.
+		milliseconds starve {2500ms};
+	};
 
   private:
 	const char *name;
@@ -26,19 +65,30 @@ struct ircd::ctx::pool
 	size_t running;
 	size_t working;
 	struct dock dock;
-	std::deque<closure> queue;
+	std::array<std::deque<std::pair<closure, steady_point>>, PRIOS> queue;
+	std::array<uint, PRIOS> credit {{0}};
+	bool promoted {false};
 	std::vector<context> ctxs;
+	context watcher;
 
-	void next();
+	size_t select();
+	void grow();
+	bool retire();
+	bool next();
+	void watch() noexcept;
 	void main() noexcept;
 
   public:
+	struct opts opts;
+
 	// indicators
 	auto size() const                            { return ctxs.size();                             }
-	auto queued() const                          { return queue.size();                            }
+	size_t queued(const prio &) const;
+	size_t queued() const;
 	auto active() const                          { return working;                                 }
 	auto avail() const                           { return running - working;                       }
 	auto pending() const                         { return active() + queued();                     }
+	nanoseconds delay() const;                   // time the oldest queued closure has waited
 
 	// control panel
 	void add(const size_t & = 1);
@@ -47,8 +97,12 @@ struct ircd::ctx::pool
 	void join();
 
 	// dispatch function to pool
+	void operator()(closure, const prio &);
 	void operator()(closure);
 
+	// wait in the queue of a class from within a closure on this pool
+	bool requeue(const prio &, const milliseconds &timeout);
+
 	// dispatch function std async style
 	template<class F, class... A> future_void<F, A...> async(F&&, A&&...);
 	template<class F, class... A> future_value<F, A...> async(F&&, A&&...);
@@ -66,6 +120,21 @@ struct ircd::ctx::pool
 	friend void debug_stats(const pool &);
 };
 
+/// Priority class of a closure queued to the pool.
+enum ircd::ctx::pool::prio
+:uint8_t
+{
+	HIGH,            ///< Interactive; i.e a user waiting on the result.
+	NORMAL,          ///< Default.
+	BULK,            ///< Throughput; i.e backfill, transfers, long-polls.
+};
+
+inline void
+ircd::ctx::pool::operator()(closure closure)
+{
+	operator()(std::move(closure), NORMAL);
+}
+
 template<class F,
          class... A>
 ircd::ctx::future_value<F, A...>
@@ -0,0 +1,41 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_CTX_STACK_H
+
+/// Allocator for context stacks.
+///
+/// Stacks are anonymous mappings with a guard page below the lowest usable
+/// address; an overflow faults immediately rather than corrupting whatever
+/// was adjacent in the heap. The kernel only commits pages of the mapping as
+/// they are touched so a large nominal stack costs what the context uses.
+///
+/// A released stack is kept on a free list for the next spawn of the same
+/// size. This saves the mmap/mprotect/munmap calls and the page faults for
+/// the region near the top of the stack which every context touches. When
+/// a stack is pooled, everything below its top `trim` bytes is released back
+/// to the kernel with madvise(MADV_DONTNEED) so an idle stack retains only
+/// that much resident memory however deep it once went.
+///
+namespace ircd::ctx::stack
+{
+	extern conf::item<size_t> pool_max;
+	extern conf::item<size_t> trim;
+
+	extern const size_t &page_size;
+
+	size_t pooled();                             // stacks on the free list
+	size_t mapped();                             // bytes mapped (in use and pooled)
+	size_t clear();                              // unmap all pooled stacks
+
+	mutable_buffer allocate(const size_t &size);
+	void deallocate(const mutable_buffer &) noexcept;
+}
@@ -21,6 +21,15 @@
 
 namespace ircd::db
 {
+	// Limit on the sum of the capacities of all column block caches in all
+	// databases. When the columns' configured sizes exceed this they are
+	// scaled down proportionally. This is not a shared cache; each column
+	// keeps its own. 0 is unlimited.
+	extern conf::item<size_t> cache_budget;
+
+	// Capacity of each database's row cache. 0 retains nothing.
+	extern conf::item<size_t> row_cache_size;
+
 	// Get capacity
 	size_t capacity(const rocksdb::Cache &);
 	size_t capacity(const rocksdb::Cache *const &);
@@ -31,6 +31,11 @@ namespace ircd::db
 	template<> prop_int property(const column &, const string_view &name);
 	template<> prop_map property(const column &, const string_view &name);
 
+	// Compression of each table file: the closure is given the file name,
+	// compression name, raw bytes of keys and values, and stored data bytes.
+	using compression_closure = std::function<bool (const string_view &, const string_view &, const size_t &, const size_t &)>;
+	bool for_each_compression(const column &, const compression_closure &);
+
 	// Access to the column's caches (see cache.h interface)
 	const rocksdb::Cache *cache_compressed(const column &);
 	const rocksdb::Cache *cache(const column &);
@@ -59,6 +64,7 @@ namespace ircd::db
 	void setopt(column &, const string_view &key, const string_view &val);
 	void compact(column &, const std::pair<string_view, string_view> &, const int &to_level = -1);
 	void compact(column &, const int &level = -1);
+	void recompress(column &);
 	void sort(column &, const bool &blocking = false);
 }
 
@@ -37,9 +37,21 @@ struct ircd::db::database::column final
 	database::descriptor descriptor;
 	comparator cmp;
 	prefix_transform prefix;
+	filter_policy filter;
 	rocksdb::BlockBasedTableOptions table_opts;
 	custom_ptr<rocksdb::ColumnFamilyHandle> handle;
 
+	// Tunables initialized from the descriptor. Stored values are only loaded
+	// after the column is open, so each is applied when it is set. Bloom bits
+	// have no effect on a column described without a filter.
+	conf::item<size_t> cache_size;
+	conf::item<size_t> cache_size_comp;
+	conf::item<size_t> bloom_bits;
+	conf::item<size_t> block_size;
+	conf::item<std::string> compression;
+	conf::item<size_t> compression_dict;
+	conf::item<size_t> compression_dict_train;
+
   public:
 	operator const rocksdb::ColumnFamilyOptions &();
 	operator const rocksdb::ColumnFamilyHandle *() const;
@@ -80,6 +80,7 @@ struct ircd::db::database
 	struct snapshot;
 	struct comparator;
 	struct prefix_transform;
+	struct filter_policy;
 	struct column;
 	struct env;
 
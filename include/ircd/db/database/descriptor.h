@@ -38,7 +38,9 @@ struct ircd::db::database::descriptor
 	/// User given prefix extractor.
 	db::prefix_transform prefix {};
 
-	/// Size of the LRU cache for uncompressed blocks
+	/// Size of the LRU cache for uncompressed blocks. This and the items
+	/// below through compression are defaults for the column's conf items
+	/// named ircd.db.<dbname>.<column>.*; see database::column.
 	size_t cache_size { 16_MiB };
 
 	/// Size of the LRU cache for compressed blocks
@@ -53,4 +55,18 @@ struct ircd::db::database::descriptor
 	/// were first found from values in another column, where if the first
 	/// column missed there'd be no reason to query this column.
 	bool expect_queries_hit { false };
+
+	/// Size of data blocks before compression; 0 for the RocksDB default.
+	size_t block_size { 0 };
+
+	/// Compression algorithm by name: none, snappy, zlib, bzip2, lz4, lz4hc,
+	/// xpress or zstd; empty for the RocksDB default. May list several
+	/// separated by ';' of which the first RocksDB supports is used.
+	std::string compression {};
+
+	/// Maximum size of a compression dictionary for this column; 0 disables.
+	/// Dictionaries are built from a sample of each bottommost compaction's
+	/// output and stored in the table file; they're only used by zlib, lz4
+	/// and zstd. Worthwhile for columns of many small, similar values.
+	size_t compression_dict { 0 };
 };
@@ -0,0 +1,39 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_DB_DATABASE_FILTER_POLICY_H
+
+// This file is not part of the standard include stack because it requires
+// RocksDB symbols which we cannot forward declare. It is used internally
+// and does not need to be included by general users of IRCd.
+
+/// Bloom filter for a column whose bits per key can be changed while the
+/// column is open. RocksDB holds on to the filter policy it was opened with,
+/// so this forwards to the builtin bloom policy last set(); every policy ever
+/// set is kept because RocksDB threads may still be using one. The bits only
+/// matter when a filter is built, so a change applies to files written
+/// afterward and existing filters remain readable.
+struct ircd::db::database::filter_policy final
+:rocksdb::FilterPolicy
+{
+	using Slice = rocksdb::Slice;
+
+	std::list<std::unique_ptr<const rocksdb::FilterPolicy>> policies;
+	std::atomic<const rocksdb::FilterPolicy *> policy {nullptr};
+
+	void set(const size_t &bits);
+
+	const char *Name() const noexcept override;
+	void CreateFilter(const Slice *keys, int n, std::string *dst) const override;
+	bool KeyMayMatch(const Slice &key, const Slice &filter) const override;
+	rocksdb::FilterBitsBuilder *GetFilterBitsBuilder() const override;
+	rocksdb::FilterBitsReader *GetFilterBitsReader(const Slice &contents) const override;
+};
@@ -76,6 +76,7 @@ enum class ircd::db::pos
 #include "index.h"
 #include "json.h"
 #include "txn.h"
+#include "jobs.h"
 
 //
 // Misc utils
@@ -0,0 +1,55 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_DB_JOBS_H
+
+// Interface to the background work (flushes and compactions) which RocksDB
+// hands to database::env::Schedule(). These are shared by all databases in
+// two pools: flushes, which relieve memtables and must never wait behind a
+// compaction; and compactions, which are IO-deprioritized and rate limited
+// against foreground read latency. Each job blocks on IO for its entire
+// duration so the pools are OS threads rather than ircd::ctx.
+
+namespace ircd::db::jobs
+{
+	struct job;
+	using closure = std::function<bool (const job &)>;
+
+	extern conf::item<size_t> flush_threads;
+	extern conf::item<size_t> compaction_threads;
+	extern conf::item<int64_t> compaction_ioprio;
+	extern conf::item<size_t> rate_max;
+	extern conf::item<size_t> rate_min;
+	extern conf::item<microseconds> rate_target;
+	extern conf::item<milliseconds> rate_interval;
+
+	// Current compaction write rate in bytes per second; 0 is unlimited.
+	size_t rate();
+
+	// Jobs waiting and executing in the named pool, or all pools if empty.
+	size_t queued(const string_view &pool = {});
+	size_t running(const string_view &pool = {});
+	size_t threads(const string_view &pool = {});
+
+	// Closure is called with the pool locked; it must not yield.
+	bool for_each(const closure &);
+}
+
+/// Descriptor of a scheduled background job. started is zero while the job
+/// is still queued.
+struct ircd::db::jobs::job
+{
+	uint64_t id {0};
+	string_view pool;
+	string_view dbname;
+	steady_point queued;
+	steady_point started;
+};
@@ -67,6 +67,7 @@ namespace ircd::fs
 
 	const char *get(index) noexcept;
 	const char *name(index) noexcept;
+	void set(const index &, const string_view &path);
 
 	std::string make_path(const std::initializer_list<string_view> &);
 
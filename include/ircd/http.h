@@ -255,6 +255,7 @@ struct ircd::http::request::head
 	string_view connection;
 	string_view content_type;
 	string_view user_agent;
+	string_view accept_encoding;
 	size_t content_length {0};
 
 	string_view uri;       // full view of (path, query, fragmet)
@@ -291,6 +292,7 @@ struct ircd::http::response::head
 	size_t content_length {0};
 	string_view content_type;
 	string_view transfer_encoding;
+	string_view content_encoding;
 	string_view server;
 
 	string_view headers;
@@ -61,6 +61,7 @@ struct ircd::json::object
 {
 	struct member;
 	struct const_iterator;
+	struct index;
 
 	using key_type = string_view;
 	using mapped_type = string_view;
@@ -178,6 +179,126 @@ struct ircd::json::object::const_iterator
 	friend bool operator>(const const_iterator &, const const_iterator &);
 };
 
+/// Structural index of a JSON object.
+///
+/// Lookups on a json::object reparse its text from the beginning every
+/// time. When one object is queried for several keys it is cheaper to scan
+/// it once into this index: the offsets of each key and value are recorded,
+/// and sorted by key, so each lookup afterward is a binary search which does
+/// not touch the text again except to compare keys. Building the index costs
+/// an allocation and a sort, so for a couple of lookups on an ordinary event
+/// the plain object::find() is cheaper; it pays off for large objects or
+/// many lookups.
+///
+/// The scan does not use the spirit grammar; it looks only for the
+/// structural characters needed to find the borders of each member and it
+/// skips over strings and nested values a vector at a time where the
+/// platform allows. Values are not validated beyond their structure (i.e
+/// a malformed number is indexed as-is) and nesting must balance, otherwise
+/// parse_error is thrown.
+///
+/// The index holds a view of the object and does not own it. Duplicate keys
+/// resolve to the first occurrence, as with object::find().
+///
+struct ircd::json::object::index
+{
+	struct entry;
+
+	string_view source;
+	std::vector<entry> idx;
+
+	member operator()(const entry &) const;
+	const entry *find(const string_view &key) const;
+
+  public:
+	size_t count() const                         { return idx.size();                              }
+	bool empty() const                           { return idx.empty();                             }
+	bool has(const string_view &key) const       { return find(key) != nullptr;                    }
+
+	// returns value or default
+	template<class T> T get(const string_view &key, const T &def = T{}) const;
+	string_view get(const string_view &key, const string_view &def = {}) const;
+
+	// returns value or throws not_found
+	template<class T = string_view> T at(const string_view &key) const;
+
+	// returns value or empty
+	string_view operator[](const string_view &key) const;
+
+	// iterate all members in key order
+	bool for_each(const std::function<bool (const member &)> &) const;
+
+	index(const object &);
+	index() = default;
+};
+
+struct ircd::json::object::index::entry
+{
+	uint32_t key {0};
+	uint32_t key_len {0};
+	uint32_t val {0};
+	uint32_t val_len {0};
+};
+
+inline ircd::string_view
+ircd::json::object::index::operator[](const string_view &key)
+const
+{
+	const auto *const entry(find(key));
+	return entry? operator()(*entry).second : string_view{};
+}
+
+template<class T>
+T
+ircd::json::object::index::at(const string_view &key)
+const try
+{
+	const auto *const entry(find(key));
+	if(!entry)
+		throw not_found("'%s'", key);
+
+	return lex_cast<T>(operator()(*entry).second);
+}
+catch(const bad_lex_cast &e)
+{
+	throw type_error("'%s' must cast to type %s",
+	                 key,
+	                 typeid(T).name());
+}
+
+inline ircd::string_view
+ircd::json::object::index::get(const string_view &key,
+                               const string_view &def)
+const
+{
+	return get<string_view>(key, def);
+}
+
+template<class T>
+T
+ircd::json::object::index::get(const string_view &key,
+                               const T &def)
+const try
+{
+	const string_view sv(operator[](key));
+	return !sv.empty()? lex_cast<T>(sv) : def;
+}
+catch(const bad_lex_cast &e)
+{
+	return def;
+}
+
+inline ircd::json::object::member
+ircd::json::object::index::operator()(const entry &entry)
+const
+{
+	return
+	{
+		string_view{source.data() + entry.key, entry.key_len},
+		string_view{source.data() + entry.val, entry.val_len},
+	};
+}
+
 inline ircd::string_view
 ircd::json::object::operator[](const path &path)
 const
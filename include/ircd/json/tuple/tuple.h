@@ -390,11 +390,79 @@ serialized(const tuple<T...> *const &b,
 	});
 }
 
+/// True if the properties of the tuple are declared in the lexical order of
+/// their keys, which is the member order of canonical JSON.
+template<class tuple,
+         size_t i = 0>
+constexpr typename std::enable_if<i + 1 >= tuple::size(), bool>::type
+sorted_keys()
+{
+	return true;
+}
+
+template<class tuple,
+         size_t i = 0>
+constexpr typename std::enable_if<i + 1 < tuple::size(), bool>::type
+sorted_keys()
+{
+	return _constexpr_less(key<tuple, i>(), key<tuple, i + 1>()) &&
+	       sorted_keys<tuple, i + 1>();
+}
+
+/// Stringify a tuple whose keys are already in lexical order. The members
+/// are printed as they are visited rather than first being gathered into an
+/// array and sorted; the output is identical. Values are printed by the
+/// general stringify(value) which canonicalizes nested objects.
+template<class... T>
+string_view
+_stringify_sorted(mutable_buffer &buf,
+                  const tuple<T...> &tuple)
+{
+	const auto put{[&buf](const string_view &s)
+	{
+		if(unlikely(ircd::size(s) > ircd::size(buf)))
+			throw print_error
+			{
+				"Failed to print tuple (%zu bytes remaining in buffer)",
+				ircd::size(buf)
+			};
+
+		consume(buf, copy(buf, s));
+	}};
+
+	const auto start(begin(buf));
+	put("{"_sv);
+
+	bool sep{false};
+	for_each(tuple, [&put, &buf, &sep]
+	(const string_view &key, auto&& val)
+	{
+		const json::value value(val);
+		if(!defined(value))
+			return;
+
+		if(sep)
+			put(","_sv);
+
+		put("\""_sv);
+		put(key);
+		put("\":"_sv);
+		stringify(buf, value);
+		sep = true;
+	});
+
+	put("}"_sv);
+	return { start, begin(buf) };
+}
+
 template<class... T>
 string_view
 stringify(mutable_buffer &buf,
           const tuple<T...> &tuple)
 {
+	if constexpr(sorted_keys<json::tuple<T...>>())
+		return _stringify_sorted(buf, tuple);
+
 	std::array<member, tuple.size()> members;
 	const auto e{_member_transform_if(tuple, begin(members), end(members), []
 	(auto &ret, const string_view &key, auto&& val)
@@ -57,6 +57,12 @@ namespace ircd::log
 	void console_disable(const facility &);
 	void console_enable(const facility &);
 
+	// Messages are written out by a background thread when async is set
+	// (default). If that thread falls behind, messages are dropped rather
+	// than blocking the caller; they are counted here.
+	extern bool async;
+	extern std::atomic<uint64_t> dropped;
+
 	void flush();
 	void close();
 	void open();
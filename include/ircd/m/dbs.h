@@ -33,6 +33,7 @@ namespace ircd::m::dbs
 	extern db::index room_joined;      // room_id | origin, member => event_idx
 	extern db::index room_state;       // room_id | type, state_key => event_idx
 	extern db::column state_node;      // node_id => state::node
+	extern db::column id_intern;       // id => handle | 0xFF, handle => id
 
 	// Lowlevel util
 	constexpr size_t ROOM_HEAD_KEY_MAX_SIZE {id::MAX_SIZE + 1 + id::MAX_SIZE};
@@ -54,6 +55,10 @@ namespace ircd::m::dbs
 	string_view room_events_key(const mutable_buffer &out, const id::room &, const uint64_t &depth);
 	std::pair<uint64_t, event::idx> room_events_key(const string_view &amalgam);
 
+	constexpr size_t ID_INTERN_KEY_MAX_SIZE {1 + 8};
+	string_view id_intern_key(const mutable_buffer &out, const uint64_t &handle);
+	uint64_t id_intern_key(const string_view &amalgam);
+
 	// [GET] the state root for an event (with as much information as you have)
 	string_view state_root(const mutable_buffer &out, const id::room &, const event::idx &, const uint64_t &depth);
 	string_view state_root(const mutable_buffer &out, const id::room &, const event::id &, const uint64_t &depth);
@@ -138,6 +143,9 @@ namespace ircd::m::dbs::desc
 
 	// state btree node key-value store
 	extern const database::descriptor events__state_node;
+
+	// interned identifiers
+	extern const database::descriptor events__id_intern;
 }
 
 // Internal interface; not for public.
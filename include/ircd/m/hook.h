@@ -25,6 +25,8 @@ struct ircd::m::hook<>
 
 	IRCD_EXCEPTION(ircd::error, error)
 
+	static ircd::stats::counter total_calls;
+
 	json::strung _feature;
 	json::object feature;
 	m::event matching;
@@ -0,0 +1,62 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_INTERN_H
+
+/// Interning of identifiers to dense integer handles.
+///
+/// User, room and server IDs are assigned a handle the first time they are
+/// interned. The assignment is permanent and persisted in the _id_intern
+/// column so a handle may be stored or compared in place of its string and
+/// translated back at any time. Handles start at 1; zero is never assigned
+/// and indicates not found from the nothrow overloads.
+///
+/// Event IDs are already interned by the _event_idx column; their handle is
+/// the event::idx obtained with m::index() and event::fetch::event_id() is
+/// the reverse. The overloads for event IDs here are deleted to catch that.
+///
+/// Handles are allocated sequentially so they will fit in 32 bits for any
+/// practical deployment; hot in-memory structures (see util::roaring) may
+/// store them narrowed.
+///
+namespace ircd::m::intern
+{
+	using handle = uint64_t;
+	using closure = std::function<void (const string_view &)>;
+
+	extern conf::item<size_t> cache_max;
+	extern handle head;                         // last handle assigned
+
+	// [GET] reverse lookup of handle to ID
+	bool get(std::nothrow_t, const handle &, const closure &);
+	void get(const handle &, const closure &);
+	string_view get(const mutable_buffer &out, const handle &);
+	std::string get(const handle &);
+
+	// [GET] handle of an ID already interned; 0 if not.
+	handle find(std::nothrow_t, const string_view &id);
+	handle find(const string_view &id);
+	handle find(std::nothrow_t, const id::event &) = delete;
+	handle find(const id::event &) = delete;
+
+	// [SET] handle of an ID; assigned and persisted if not already interned.
+	handle set(const string_view &id);
+	handle set(const id::event &) = delete;
+
+	// [SET] as above but a new assignment is written to the caller's txn
+	// and must be forgotten by the caller if that txn is abandoned.
+	handle set(db::txn &, const string_view &id, bool &assigned);
+	void forget(const handle &);
+
+	// In-memory table
+	size_t cached();
+	void clear();
+}
@@ -58,6 +58,7 @@ namespace ircd
 #include "commitment.h"
 #include "event.h"
 #include "dbs.h"
+#include "intern.h"
 #include "state.h"
 #include "vm.h"
 #include "room.h"
@@ -40,6 +40,7 @@ struct ircd::m::node
 	using id = m::id::node;
 	using key_closure = std::function<void (const string_view &)>;  // remember to unquote()!!!
 	using ed25519_closure = std::function<void (const ed25519::pk &)>;
+	using ed25519_valid_closure = std::function<void (const ed25519::pk &, const time_t &valid_until)>;
 
 	id node_id;
 
@@ -48,6 +49,7 @@ struct ircd::m::node
 	id::room room_id(const mutable_buffer &) const;
 	id::room::buf room_id() const;
 
+	void key(const string_view &key_id, const ed25519_valid_closure &) const;
 	void key(const string_view &key_id, const ed25519_closure &) const;
 	void key(const string_view &key_id, const key_closure &) const;
 
@@ -33,6 +33,9 @@ struct ircd::m::request
 >
 {
 	struct x_matrix;
+	struct verifier;
+
+	struct verifier static verifier;
 
 	static bool verify(const ed25519::pk &, const ed25519::sig &, const json::object &);
 	bool verify(const ed25519::pk &, const ed25519::sig &) const;
@@ -74,3 +77,46 @@ struct ircd::m::request::x_matrix
 	x_matrix(const string_view &);
 	x_matrix() = default;
 };
+
+/// (internal) Warm state for verifying X-Matrix authorization. Verify keys
+/// are kept decoded in memory by origin and key_id so a request from a known
+/// origin is verified without a query to the node room. Each origin also
+/// accumulates the cost of verifying its requests. Both maps are bounded;
+/// the entry used least recently makes room when one is full.
+struct ircd::m::request::verifier
+{
+	struct key;
+	struct stats;
+	using lru_list = std::list<string_view>;         // views of the map keys
+
+	static conf::item<seconds> key_ttl;
+	static conf::item<size_t> keys_max;
+	static conf::item<size_t> origins_max;
+
+	std::map<std::string, key, std::less<>> keys;      // "origin key_id" => key
+	std::map<std::string, stats, std::less<>> origins;
+	lru_list keys_lru;                                 // most recent first
+	lru_list origins_lru;
+
+  public:
+	bool get(const string_view &origin, const string_view &key_id, ed25519::pk &);
+	void set(const string_view &origin, const string_view &key_id, const ed25519::pk &, const time_t &valid_until = 0);
+	stats &operator[](const string_view &origin);
+};
+
+struct ircd::m::request::verifier::key
+{
+	ed25519::pk pk;
+	time_t expires {0};
+	lru_list::iterator lru;
+};
+
+struct ircd::m::request::verifier::stats
+{
+	size_t count {0};         ///< Requests verified from this origin
+	size_t failed {0};        ///< Requests with a bad signature
+	size_t key_miss {0};      ///< Verifications which had to fetch the key
+	nanoseconds time {0ns};   ///< Total time spent verifying
+	time_t last {0};          ///< Time of the last request from this origin
+	lru_list::iterator lru;
+};
@@ -300,6 +300,8 @@ struct ircd::m::room::state::opts
 ///
 struct ircd::m::room::members
 {
+	struct cache;
+
 	using closure = std::function<void (const id::user &)>;
 	using closure_bool = std::function<bool (const id::user &)>;
 
@@ -323,6 +325,54 @@ struct ircd::m::room::members
 	{}
 };
 
+/// In-memory index of the present membership of a room. User IDs are
+/// interned to dense integers (see m/intern.h) and each membership state is
+/// a compressed bitmap of those integers; a membership test is then a
+/// lookup rather than a query of the state tree and member counts are free.
+///
+/// The index for a room is built from its state on first use. It is kept
+/// current by update(), which the m.room.member module calls from the
+/// vm.write hook once a member event is committed to the present state. A
+/// build which a committed member event raced is discarded rather than
+/// kept; get() returns null in that case and the caller queries the state.
+/// When a state resolution changes the membership of other users the
+/// room's index is dropped with invalidate() and built again on next use.
+/// The least recently used room is evicted when rooms_max is reached.
+///
+struct ircd::m::room::members::cache
+{
+	static conf::item<size_t> rooms_max;
+	static std::map<std::string, cache, std::less<>> rooms;
+	static std::list<string_view> lru;                          // least recent first
+	static std::map<std::string, bool, std::less<>> building;   // room_id => raced
+
+	roaring join;
+	roaring invite;
+	roaring leave;
+	roaring ban;
+	decltype(lru)::iterator lru_it;
+
+	static uint32_t intern(const string_view &user_id);
+	static bool interned(const string_view &user_id, uint32_t &);
+
+	roaring *set(const string_view &membership);
+	const roaring *set(const string_view &membership) const;
+	void set(const uint32_t &user, const string_view &membership);
+
+  public:
+	string_view membership(const id::user &) const;
+	bool membership(const id::user &, const string_view &membership) const;
+	size_t count(const string_view &membership) const;
+
+	static void update(const m::room::id &, const id::user &, const string_view &membership);
+	static void invalidate(const m::room::id &);
+	static cache *find(const m::room::id &);
+	static const cache *get(const m::room &);
+
+	cache(const m::room &);
+	cache() = default;
+};
+
 /// Interface to the origins (autonomous systems) of a room
 ///
 /// This interface focuses specifically on the origins (from the field in the
@@ -48,6 +48,7 @@ namespace ircd::m::state
 	using search_closure = std::function<bool (const json::array &, const string_view &, const uint &, const uint &)>;
 	using iter_closure = std::function<void (const json::array &, const string_view &)>;
 	using iter_bool_closure = std::function<bool (const json::array &, const string_view &)>;
+	using diff_closure = std::function<bool (const json::array &, const string_view &, const string_view &)>;
 
 	int keycmp(const json::array &a, const json::array &b);
 	bool prefix_eq(const json::array &a, const json::array &b);
@@ -57,6 +58,7 @@ namespace ircd::m::state
 	id set_node(db::txn &txn, const mutable_buffer &id, const json::object &node);
 	bool get_node(const std::nothrow_t, const string_view &id, const node_closure &);
 	void get_node(const string_view &id, const node_closure &);
+	void get_node(const db::txn &, const string_view &id, const node_closure &);
 
 	id remove(db::txn &, const mutable_buffer &rootout, const id &rootin, const json::array &key);
 	id remove(db::txn &, const mutable_buffer &rootout, const id &rootin, const string_view &type, const string_view &state_key);
@@ -86,6 +88,11 @@ namespace ircd::m::state
 
 	bool get(std::nothrow_t, const id &root, const string_view &type, const string_view &state_key, const val_closure &);
 	void get(const id &root, const string_view &type, const string_view &state_key, const val_closure &);
+
+	bool diff(const id &a, const id &b, const diff_closure &);
+	id resolve(db::txn &, const mutable_buffer &rootout, const vector_view<const id> &roots, const iter_closure &applied = {});
+
+	extern conf::item<size_t> resolve_width;
 }
 
 /// JSON property name strings specifically for use in m::state
@@ -26,12 +26,14 @@ struct ircd::m::user
 	struct room;
 	struct rooms;
 	struct mitsein;
+	struct token_cache;
 	using id = m::id::user;
 	using closure = std::function<void (const user &)>;
 	using closure_bool = std::function<bool (const user &)>;
 
 	static m::room users;
 	static m::room tokens;
+	struct token_cache static token_cache;
 
 	id user_id;
 
@@ -88,6 +90,32 @@ struct ircd::m::user::room
 	room &operator=(const room &) = delete;
 };
 
+/// In-memory cache of access_token => user_id. Client authentication
+/// consults this before making a state lookup in the tokens room. At logout
+/// the token's state is replaced by a tombstone ({"revoked": true}) before
+/// the entry is removed; a redaction of the token's event also removes it.
+///
+/// The lookup after a miss yields, and a logout may complete meanwhile. A
+/// caller takes the epoch before the lookup and passes it to set(), which
+/// does nothing if any token was removed since.
+struct ircd::m::user::token_cache
+{
+	using closure = std::function<void (const id &)>;
+
+	static conf::item<size_t> max_size;
+
+	std::map<std::string, std::string, std::less<>> map;
+	uint64_t epoch {0};                  // incremented by del() and clear()
+	size_t hits {0};
+	size_t misses {0};
+
+  public:
+	bool get(const string_view &token, const closure &);
+	bool set(const string_view &token, const id &, const uint64_t &epoch);
+	bool del(const string_view &token);
+	void clear();
+};
+
 /// Interface to the rooms for a user.
 struct ircd::m::user::rooms
 {
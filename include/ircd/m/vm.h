@@ -34,6 +34,17 @@ namespace ircd::m::vm
 	uint64_t retired_sequence();
 }
 
+/// Metrics for the vm; see ircd::stats
+namespace ircd::m::vm::stats
+{
+	extern ircd::stats::counter evals;
+	extern ircd::stats::gauge evaluating;
+	extern ircd::stats::gauge sequence;
+	extern ircd::stats::counter accepts;
+	extern ircd::stats::counter faults;
+	extern ircd::stats::histogram accept_time;
+}
+
 /// Event Evaluation Device
 ///
 /// This object conducts the evaluation of an event or a tape of multiple
@@ -37,6 +37,7 @@ struct ircd::net::dns
 
 	using callback = std::function<void (std::exception_ptr, const hostport &, const vector_view<const rfc1035::record *> &)>;
 	using callback_A_one = std::function<void (std::exception_ptr, const hostport &, const rfc1035::record::A &)>;
+	using callback_AAAA_one = std::function<void (std::exception_ptr, const hostport &, const rfc1035::record::AAAA &)>;
 	using callback_SRV_one = std::function<void (std::exception_ptr, const hostport &, const rfc1035::record::SRV &)>;
 	using callback_ipport_one = std::function<void (std::exception_ptr, const hostport &, const ipport &)>;
 
@@ -44,15 +45,21 @@ struct ircd::net::dns
 	static string_view make_SRV_key(const mutable_buffer &out, const hostport &, const opts &);
 	static string_view unmake_SRV_key(const string_view &);
 
+	// (internal) concurrent A and AAAA resolution for the ipport interface.
+	static conf::item<milliseconds> aaaa_grace;
+	static void resolve_ip(const hostport &, const opts &, callback_ipport_one);
+
   public:
 	// Cache warming
 	static const callback_A_one prefetch_A;
+	static const callback_AAAA_one prefetch_AAAA;
 	static const callback_SRV_one prefetch_SRV;
 	static const callback_ipport_one prefetch_ipport;
 
 	// Callback-based interface
 	void operator()(const hostport &, const opts &, callback);
 	void operator()(const hostport &, const opts &, callback_A_one);
+	void operator()(const hostport &, const opts &, callback_AAAA_one);
 	void operator()(const hostport &, const opts &, callback_SRV_one);
 	void operator()(const hostport &, const opts &, callback_ipport_one);
 
@@ -77,6 +84,11 @@ struct ircd::net::dns::opts
 	/// made in the first place).
 	string_view proto{"tcp"};
 
+	/// Specifies the rfc1035 query type. A zero value means the type is
+	/// deduced: an SRV query is made when a service is specified, otherwise
+	/// an A query. Set this to 28 to make an AAAA query for the host.
+	uint16_t qtype {0};
+
 	/// Whether the dns::cache is checked and may respond to the query.
 	bool cache_check {true};
 
@@ -103,6 +115,7 @@ struct ircd::net::dns::cache
 	static conf::item<seconds> clear_nxdomain;
 
 	std::multimap<std::string, rfc1035::record::A, std::less<>> A;
+	std::multimap<std::string, rfc1035::record::AAAA, std::less<>> AAAA;
 	std::multimap<std::string, rfc1035::record::SRV, std::less<>> SRV;
 
   public:
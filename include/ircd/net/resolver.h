@@ -27,6 +27,7 @@ struct ircd::net::dns::resolver
 	static conf::item<milliseconds> send_rate;
 	static conf::item<size_t> send_burst;
 	static conf::item<size_t> retry_max;
+	static conf::item<size_t> send_parallel;
 
 	std::vector<ip::udp::endpoint> server;       // The list of active servers
 	size_t server_next{0};                       // Round-robin state to hit servers
@@ -34,6 +35,8 @@ struct ircd::net::dns::resolver
 
 	ctx::dock dock;
 	std::map<uint16_t, tag> tags;                // The active requests
+	std::map<string_view, uint16_t> pending;     // Question => tag id for coalescing
+	size_t coalesced {0};                        // Count of lookups merged in-flight
 	steady_point send_last;                      // Time of last send
 	std::deque<uint16_t> sendq;                  // Queue of frames for rate-limiting
 
@@ -48,6 +51,11 @@ struct ircd::net::dns::resolver
 	void handle(const error_code &ec, const size_t &) noexcept;
 	void set_handle();
 
+	static string_view key(const tag &);
+	void unindex(const tag &);
+	bool coalesce(tag &);
+	void call_user(tag &, std::exception_ptr, const vector_view<const rfc1035::record *> &);
+
 	void send_query(const ip::udp::endpoint &, tag &);
 	void queue_query(tag &);
 	void send_query(tag &);
@@ -77,6 +85,7 @@ struct ircd::net::dns::resolver::tag
 	dns::opts opts;       // note: invalid after query sent
 	const_buffer question;
 	callback cb;
+	std::vector<std::pair<hostport, callback>> waiters;  // coalesced lookups
 	steady_point last {};
 	uint8_t tries {0};
 	char hostbuf[256];
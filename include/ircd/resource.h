@@ -26,8 +26,10 @@ struct ircd::resource
 	struct method;
 	struct request;
 	struct response;
+	struct node;
 
 	static std::map<string_view, resource *, iless> resources;
+	static node tree;
 
 	string_view path;
 	string_view description;
@@ -43,14 +45,29 @@ struct ircd::resource
   public:
 	method &operator[](const string_view &path);
 
-	void operator()(client &, const http::request::head &, const string_view &content_partial);
+	void operator()(client &, const http::request::head &, const string_view &content_partial, const vector_view<string_view> &parv);
 
 	resource(const string_view &path, const opts &);
 	resource(const string_view &path);
 	resource() = default;
 	virtual ~resource() noexcept;
 
-	static resource &find(const string_view &path);
+	static resource &find(const string_view &path, vector_view<string_view> &parv);
+};
+
+/// Routing tree of the registered resources with a node for each segment of
+/// their paths. A segment beginning with ':' (i.e "/rooms/:room_id/state")
+/// is a template parameter which matches any one segment of a request path;
+/// literal segments are preferred to it and there is no backtracking.
+///
+/// Routing is a single pass over the request path: the parameters captured
+/// along the way, followed by the remaining segments under the deepest
+/// DIRECTORY matched, become the request's parv.
+struct ircd::resource::node
+{
+	std::map<std::string, std::unique_ptr<node>, iless> child;
+	std::unique_ptr<node> param;
+	resource *target {nullptr};
 };
 
 enum ircd::resource::flag
@@ -141,7 +158,12 @@ struct ircd::resource::response
 {
 	struct chunked;
 
-	response(client &, const http::code &, const string_view &content_type, const size_t &content_length, const string_view &headers = {});
+	static conf::item<size_t> compress_threshold;
+	static conf::item<int64_t> compress_level;
+	static stats::counter compress_in;
+	static stats::counter compress_out;
+
+	response(client &, const http::code &, const string_view &content_type, const size_t &content_length, const string_view &headers = {}, const const_buffer &content = {});
 	response(client &, const string_view &str, const string_view &content_type, const http::code &, const vector_view<const http::header> &);
 	response(client &, const string_view &str, const string_view &content_type, const http::code & = http::OK, const string_view &headers = {});
 	response(client &, const json::object &str, const http::code & = http::OK);
@@ -160,7 +182,9 @@ struct ircd::resource::response::chunked
 :resource::response
 {
 	client *c {nullptr};
+	compress::deflater deflater;
 
+	size_t write(const vector_view<const const_buffer> &chunk);
 	size_t write(const const_buffer &chunk);
 	bool finish();
 
@@ -176,6 +200,7 @@ struct ircd::resource::response::chunked
 
 struct ircd::resource::method
 {
+	struct stats;
 	using handler = std::function<response (client &, request &)>;
 
 	enum flag
@@ -184,6 +209,8 @@ struct ircd::resource::method
 		RATE_LIMITED          = 0x02,
 		VERIFY_ORIGIN         = 0x04,
 		CONTENT_DISCRETION    = 0x08,
+		PRIORITY_HIGH         = 0x10,  ///< Interactive; see ctx::pool::prio
+		PRIORITY_BULK         = 0x20,  ///< Throughput; see ctx::pool::prio
 	};
 
 	struct opts
@@ -200,12 +227,18 @@ struct ircd::resource::method
 		/// MIME type; first part is the Registry (i.e application) and second
 		/// part is the format (i.e json). Empty value means nothing rejected.
 		std::pair<string_view, string_view> mime;
+
+		/// Compression level for responses when the client accepts an
+		/// encoding. Zero is the conf default (resource::response
+		/// compress_level); negative never compresses this method.
+		int8_t compress {0};
 	};
 
 	string_view name;
 	struct resource *resource;
 	handler function;
 	struct opts opts;
+	std::unique_ptr<struct stats> stats;
 	unique_const_iterator<decltype(resource::methods)> methods_it;
 
   public:
@@ -215,3 +248,14 @@ struct ircd::resource::method
 	method(struct resource &, const string_view &name, const handler &);
 	virtual ~method() noexcept;
 };
+
+/// Metrics for each route, named by its resource and method, i.e
+/// "ircd.resource./_matrix/client/r0/sync.GET.requests".
+struct ircd::resource::method::stats
+{
+	std::string name[2];
+	ircd::stats::counter requests;
+	ircd::stats::histogram time;
+
+	stats(const method &);
+};
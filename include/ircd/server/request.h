@@ -92,6 +92,10 @@ struct ircd::server::request
 
 	server::tag *tag {nullptr};
 
+	/// Time of submission. The request's lifetime is accumulated into the
+	/// trace of the ctx which destroys it (see trace.h).
+	steady_point submitted;
+
   public:
 	/// Transmission data
 	server::out out;
@@ -170,6 +174,7 @@ ircd::server::request::request(request &&o)
 noexcept
 :ctx::future<http::code>{std::move(o)}
 ,tag{std::move(o.tag)}
+,submitted{std::move(o.submitted)}
 ,out{std::move(o.out)}
 ,in{std::move(o.in)}
 ,opt{std::move(o.opt)}
@@ -177,6 +182,7 @@ noexcept
 	if(tag)
 		associate(*this, *tag, std::move(o));
 
+	o.submitted = {};
 	assert(!o.tag);
 }
 
@@ -191,6 +197,8 @@ noexcept
 	in = std::move(o.in);
 	tag = std::move(o.tag);
 	opt = std::move(o.opt);
+	submitted = std::move(o.submitted);
+	o.submitted = {};
 
 	if(tag)
 		associate(*this, *tag, std::move(o));
@@ -209,6 +217,9 @@ noexcept
 	if(tag)
 		disassociate(*this, *tag);
 
+	if(submitted != steady_point{})
+		trace::add("server.request", now<steady_point>() - submitted);
+
 	assert(!tag);
 }
 
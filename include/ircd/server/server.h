@@ -31,6 +31,16 @@ namespace ircd::server
 	extern ircd::log::log log;
 }
 
+/// Metrics for all peers; see ircd::stats
+namespace ircd::server::stats
+{
+	extern ircd::stats::counter read_bytes;
+	extern ircd::stats::counter write_bytes;
+	extern ircd::stats::gauge peers;
+	extern ircd::stats::gauge links;
+	extern ircd::stats::gauge tags;
+}
+
 #include "tag.h"
 #include "request.h"
 #include "link.h"
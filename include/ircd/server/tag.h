@@ -36,6 +36,7 @@ struct ircd::server::tag
 		size_t chunk_read {0};         // content read after last chunk head
 		size_t chunk_length {0};       // -1 for chunk header mode
 		http::code status {(http::code)0};
+		compress::type encoding {compress::NONE};
 	}
 	state;
 	ctx::promise<http::code> p;
@@ -45,6 +46,7 @@ struct ircd::server::tag
 	void set_exception(std::exception_ptr);
 	template<class... args> void set_exception(args&&...);
 	template<class... args> void set_value(args&&...);
+	void inflate_content();
 
 	const_buffer make_write_content_buffer() const;
 	const_buffer make_write_head_buffer() const;
@@ -0,0 +1,232 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_STATS_H
+
+/// Registry of named runtime metrics.
+///
+/// Every counter, gauge and histogram registers itself with the instance_list
+/// on construction; they are declared statically next to the code they
+/// measure (or in a module, in which case they come and go with the module).
+/// The whole registry can be iterated or rendered in the Prometheus text
+/// exposition format.
+///
+/// Names are dotted like conf items (i.e "ircd.client.requests"); they are
+/// translated to underscores on export.
+///
+/// Updates are relaxed atomic operations. Almost every update occurs on the
+/// main thread where they never contend; the few which occur on other threads
+/// (i.e. RocksDB's background threads) cost no more than a locked add.
+///
+/// Items which simply reflect some value already maintained elsewhere can be
+/// constructed with a closure instead; the closure is called when the item is
+/// read and there is no cost to the measured code at all.
+///
+namespace ircd::stats
+{
+	struct item;
+	struct counter;
+	struct gauge;
+	struct histogram;
+
+	enum class type :uint8_t;
+	string_view reflect(const type &);
+
+	item *find(const string_view &name) noexcept;
+	item &get(const string_view &name);
+
+	std::ostream &prometheus(std::ostream &);
+	std::ostream &pretty(std::ostream &, const string_view &prefix = {});
+
+	IRCD_EXCEPTION(ircd::error, error)
+	IRCD_EXCEPTION(error, not_found)
+}
+
+enum class ircd::stats::type
+:uint8_t
+{
+	COUNTER,                     ///< Monotonic; only increases.
+	GAUGE,                       ///< Arbitrary value which goes up and down.
+	HISTOGRAM,                   ///< Distribution of observed values.
+};
+
+/// Abstract base registered with the instance_list for all metrics.
+struct ircd::stats::item
+:instance_list<item>
+{
+	string_view name;
+	string_view help;
+	enum type type;
+
+  protected:
+	item(const enum type &, const string_view &name, const string_view &help);
+
+  public:
+	item(item &&) = delete;
+	item(const item &) = delete;
+	virtual ~item() noexcept;
+};
+
+/// Monotonic counter.
+struct ircd::stats::counter
+:item
+{
+	using closure = std::function<uint64_t ()>;
+
+	std::atomic<uint64_t> value {0};
+	closure fetch;
+
+  public:
+	uint64_t get() const;
+	operator uint64_t() const          { return get();                         }
+
+	counter &operator+=(const uint64_t &);
+	counter &operator++();
+
+	counter(const string_view &name, const string_view &help = {});
+	counter(const string_view &name, const string_view &help, closure);
+};
+
+/// Gauge of a value which can rise and fall.
+struct ircd::stats::gauge
+:item
+{
+	using closure = std::function<int64_t ()>;
+
+	std::atomic<int64_t> value {0};
+	closure fetch;
+
+  public:
+	int64_t get() const;
+	operator int64_t() const           { return get();                         }
+
+	gauge &operator=(const int64_t &);
+	gauge &operator+=(const int64_t &);
+	gauge &operator-=(const int64_t &);
+	gauge &operator++();
+	gauge &operator--();
+
+	gauge(const string_view &name, const string_view &help = {});
+	gauge(const string_view &name, const string_view &help, closure);
+};
+
+/// Histogram of unsigned observations into base-2 logarithmic buckets.
+///
+/// Bucket 0 counts zeros and bucket N counts values with a bit length of N,
+/// i.e the interval [2^(N-1), 2^N). This costs one bit-scan per observation
+/// and covers the entire 64-bit range in a fixed 65 slots with a relative
+/// error of at most one octave; the sum is kept exactly. This is sufficient
+/// for latencies and sizes where the order of magnitude is the concern.
+///
+struct ircd::stats::histogram
+:item
+{
+	static constexpr const size_t BUCKETS {65};
+
+	std::array<std::atomic<uint64_t>, BUCKETS> bucket {{}};
+	std::atomic<uint64_t> count {0};
+	std::atomic<uint64_t> sum {0};
+
+	static size_t slot(const uint64_t &value);
+	static uint64_t upper(const size_t &slot);
+
+  public:
+	uint64_t percentile(const double &) const;
+
+	void operator()(const uint64_t &value);
+
+	histogram(const string_view &name, const string_view &help = {});
+};
+
+inline void
+ircd::stats::histogram::operator()(const uint64_t &value)
+{
+	bucket[slot(value)].fetch_add(1, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+/// The inclusive upper bound of values counted by a slot.
+inline uint64_t
+ircd::stats::histogram::upper(const size_t &slot)
+{
+	assert(slot < BUCKETS);
+	return slot < 64? (1UL << slot) - 1 : std::numeric_limits<uint64_t>::max();
+}
+
+inline size_t
+ircd::stats::histogram::slot(const uint64_t &value)
+{
+	return value? 64 - __builtin_clzl(value) : 0;
+}
+
+inline ircd::stats::gauge &
+ircd::stats::gauge::operator--()
+{
+	value.fetch_sub(1, std::memory_order_relaxed);
+	return *this;
+}
+
+inline ircd::stats::gauge &
+ircd::stats::gauge::operator++()
+{
+	value.fetch_add(1, std::memory_order_relaxed);
+	return *this;
+}
+
+inline ircd::stats::gauge &
+ircd::stats::gauge::operator-=(const int64_t &val)
+{
+	value.fetch_sub(val, std::memory_order_relaxed);
+	return *this;
+}
+
+inline ircd::stats::gauge &
+ircd::stats::gauge::operator+=(const int64_t &val)
+{
+	value.fetch_add(val, std::memory_order_relaxed);
+	return *this;
+}
+
+inline ircd::stats::gauge &
+ircd::stats::gauge::operator=(const int64_t &val)
+{
+	value.store(val, std::memory_order_relaxed);
+	return *this;
+}
+
+inline int64_t
+ircd::stats::gauge::get()
+const
+{
+	return fetch? fetch() : value.load(std::memory_order_relaxed);
+}
+
+inline ircd::stats::counter &
+ircd::stats::counter::operator++()
+{
+	value.fetch_add(1, std::memory_order_relaxed);
+	return *this;
+}
+
+inline ircd::stats::counter &
+ircd::stats::counter::operator+=(const uint64_t &val)
+{
+	value.fetch_add(val, std::memory_order_relaxed);
+	return *this;
+}
+
+inline uint64_t
+ircd::stats::counter::get()
+const
+{
+	return fetch? fetch() : value.load(std::memory_order_relaxed);
+}
@@ -200,6 +200,7 @@ namespace ircd
 #include "date.h"
 #include "logger.h"
 #include "info.h"
+#include "stats.h"
 #include "nacl.h"
 #include "rand.h"
 #include "hash.h"
@@ -217,10 +218,12 @@ namespace ircd
 #include "http.h"
 #include "fmt.h"
 #include "magics.h"
+#include "compress.h"
 #include "conf.h"
 #include "fs/fs.h"
 #include "ios.h"
 #include "ctx/ctx.h"
+#include "trace.h"
 #include "db/db.h"
 #include "js.h"
 #include "mods/mods.h"
@@ -0,0 +1,115 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_TRACE_H
+
+/// Request-scoped latency breakdown.
+///
+/// A trace::request is constructed on the stack of a context handling some
+/// request (i.e in client::handle_request()) and attaches itself to that
+/// ctx. Anywhere below, on the same ctx, a trace::span marks a section of
+/// interest by name; its time and the number of times the ctx yielded during
+/// it are accumulated into the request under that name. Because the request
+/// is found through the ctx, a span which yields is still attributed to the
+/// right request when it resumes, and code running on any other ctx (or the
+/// main stack) pays only for the null check.
+///
+/// Spans are accumulated by name rather than recorded individually so a
+/// request making thousands of db queries has a fixed footprint; nested
+/// spans are each counted in full (i.e db.seek time is also part of the
+/// state.get time which made the query).
+///
+/// When the request finishes taking longer than the `slow` threshold its
+/// sample is copied into a ring buffer which is viewable from the console.
+///
+namespace ircd::trace
+{
+	struct total;
+	struct sample;
+	struct request;
+	struct span;
+
+	extern conf::item<milliseconds> slow;
+	extern conf::item<size_t> slow_max;
+	extern std::deque<sample> slows;
+
+	request *&attached(ctx::ctx &);      // defined in ctx.cc
+	request *current();
+	void add(const string_view &name, const nanoseconds &, const uint64_t &yields = 0);
+}
+
+/// Accumulation for one span name within a request.
+struct ircd::trace::total
+{
+	static constexpr const size_t NAME_MAX {23};
+
+	char name[NAME_MAX + 1] {0};
+	uint32_t count {0};
+	uint32_t yields {0};
+	nanoseconds time {0ns};
+	nanoseconds max {0ns};
+};
+
+/// The record of one request retained in the slows ring.
+struct ircd::trace::sample
+{
+	static constexpr const size_t LABEL_MAX {127};
+	static constexpr const size_t TOTALS_MAX {16};
+
+	char label[LABEL_MAX + 1] {0};
+	uint64_t id {0};
+	time_t started {0};
+	nanoseconds time {0ns};
+	uint64_t yields {0};
+	uint32_t dropped {0};                    // spans with no room in totals
+	uint32_t used {0};
+	std::array<trace::total, TOTALS_MAX> totals;
+
+	const trace::total *find(const string_view &name) const;
+	trace::total *get(const string_view &name);
+};
+
+/// Root of a trace; attaches to the current ctx for its lifetime.
+struct ircd::trace::request
+:sample
+{
+	ctx::ctx *ctx {ctx::current};
+	request *prev {nullptr};
+	steady_point start;
+	uint64_t yields_start {0};
+
+  public:
+	request(const string_view &label, const uint64_t &id = 0);
+	request(request &&) = delete;
+	request(const request &) = delete;
+	~request() noexcept;
+};
+
+/// Marks a section of code on a traced ctx.
+struct ircd::trace::span
+{
+	request *req {current()};
+	string_view name;
+	steady_point start;
+	uint64_t yields_start {0};
+
+  public:
+	span(const string_view &name);
+	span(span &&) = delete;
+	span(const span &) = delete;
+	~span() noexcept;
+};
+
+inline ircd::trace::request *
+ircd::trace::current()
+{
+	return ctx::current? attached(*ctx::current) : nullptr;
+}
@@ -0,0 +1,283 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_UTIL_ROARING_H
+
+namespace ircd::util
+{
+	struct roaring;
+}
+
+/// Compressed set of 32-bit integers in the manner of a roaring bitmap. The
+/// high 16 bits of a value select a container which holds the low 16 bits.
+/// A container is a sorted array while it is sparse and becomes an 8KiB
+/// bitmap once it exceeds 4096 members, which is the point where the bitmap
+/// is the smaller of the two. A membership test is then a short map lookup
+/// followed by either a binary search or a single bit test.
+///
+/// This is intended for sets of dense integer handles (i.e interned IDs)
+/// where an std::set would cost a heap node per member.
+///
+struct ircd::util::roaring
+{
+	struct container;
+	using closure_bool = std::function<bool (const uint32_t &)>;
+	using closure = std::function<void (const uint32_t &)>;
+
+	std::map<uint16_t, container> containers;
+	size_t count {0};
+
+  public:
+	size_t size() const                { return count;                         }
+	bool empty() const                 { return !count;                        }
+	bool has(const uint32_t &) const;
+	bool test(const closure_bool &) const;
+	void for_each(const closure &) const;
+
+	bool set(const uint32_t &);
+	bool del(const uint32_t &);
+	void clear();
+};
+
+struct ircd::util::roaring::container
+{
+	static constexpr const size_t ARRAY_MAX {4096};
+	static constexpr const size_t BITMAP_WORDS {65536 / 64};
+
+	std::vector<uint16_t> array;
+	std::unique_ptr<uint64_t[]> bitmap;
+	size_t count {0};
+
+	void to_bitmap();
+	void to_array();
+
+  public:
+	bool has(const uint16_t &) const;
+	bool test(const uint16_t &hi, const closure_bool &) const;
+
+	bool set(const uint16_t &);
+	bool del(const uint16_t &);
+};
+
+inline bool
+ircd::util::roaring::set(const uint32_t &val)
+{
+	auto &container
+	{
+		containers[uint16_t(val >> 16)]
+	};
+
+	const bool ret
+	{
+		container.set(uint16_t(val))
+	};
+
+	count += ret;
+	return ret;
+}
+
+inline bool
+ircd::util::roaring::del(const uint32_t &val)
+{
+	const auto it
+	{
+		containers.find(uint16_t(val >> 16))
+	};
+
+	if(it == end(containers))
+		return false;
+
+	auto &container{it->second};
+	const bool ret
+	{
+		container.del(uint16_t(val))
+	};
+
+	count -= ret;
+	if(!container.count)
+		containers.erase(it);
+
+	return ret;
+}
+
+inline void
+ircd::util::roaring::clear()
+{
+	containers.clear();
+	count = 0;
+}
+
+/// Iterate the set in ascending order.
+inline void
+ircd::util::roaring::for_each(const closure &closure)
+const
+{
+	test([&closure](const uint32_t &val)
+	{
+		closure(val);
+		return false;
+	});
+}
+
+/// Iterate the set in ascending order until the closure returns true; the
+/// return value is true if the closure broke the iteration.
+inline bool
+ircd::util::roaring::test(const closure_bool &closure)
+const
+{
+	for(const auto &pair : containers)
+		if(pair.second.test(pair.first, closure))
+			return true;
+
+	return false;
+}
+
+inline bool
+ircd::util::roaring::has(const uint32_t &val)
+const
+{
+	const auto it
+	{
+		containers.find(uint16_t(val >> 16))
+	};
+
+	return it != end(containers) && it->second.has(uint16_t(val));
+}
+
+//
+// container
+//
+
+inline bool
+ircd::util::roaring::container::set(const uint16_t &val)
+{
+	if(bitmap)
+	{
+		auto &word{bitmap[val / 64]};
+		const uint64_t bit{1UL << (val % 64)};
+		if(word & bit)
+			return false;
+
+		word |= bit;
+		++count;
+		return true;
+	}
+
+	const auto it
+	{
+		std::lower_bound(begin(array), end(array), val)
+	};
+
+	if(it != end(array) && *it == val)
+		return false;
+
+	array.emplace(it, val);
+	++count;
+	if(count > ARRAY_MAX)
+		to_bitmap();
+
+	return true;
+}
+
+inline bool
+ircd::util::roaring::container::del(const uint16_t &val)
+{
+	if(bitmap)
+	{
+		auto &word{bitmap[val / 64]};
+		const uint64_t bit{1UL << (val % 64)};
+		if(~word & bit)
+			return false;
+
+		word &= ~bit;
+		--count;
+
+		// Hysteresis keeps a container at the threshold from flapping.
+		if(count < ARRAY_MAX / 2)
+			to_array();
+
+		return true;
+	}
+
+	const auto it
+	{
+		std::lower_bound(begin(array), end(array), val)
+	};
+
+	if(it == end(array) || *it != val)
+		return false;
+
+	array.erase(it);
+	--count;
+	return true;
+}
+
+inline bool
+ircd::util::roaring::container::has(const uint16_t &val)
+const
+{
+	if(bitmap)
+		return bitmap[val / 64] & (1UL << (val % 64));
+
+	return std::binary_search(begin(array), end(array), val);
+}
+
+inline bool
+ircd::util::roaring::container::test(const uint16_t &hi,
+                                     const closure_bool &closure)
+const
+{
+	const uint32_t base
+	{
+		uint32_t(hi) << 16
+	};
+
+	if(!bitmap)
+	{
+		for(const auto &lo : array)
+			if(closure(base | lo))
+				return true;
+
+		return false;
+	}
+
+	for(size_t i(0); i < BITMAP_WORDS; ++i)
+		for(uint64_t word(bitmap[i]); word; word &= word - 1)
+			if(closure(base | uint32_t(i * 64 + __builtin_ctzl(word))))
+				return true;
+
+	return false;
+}
+
+inline void
+ircd::util::roaring::container::to_bitmap()
+{
+	assert(!bitmap);
+	bitmap.reset(new uint64_t[BITMAP_WORDS]{0});
+	for(const auto &val : array)
+		bitmap[val / 64] |= 1UL << (val % 64);
+
+	array.clear();
+	array.shrink_to_fit();
+}
+
+inline void
+ircd::util::roaring::container::to_array()
+{
+	assert(bitmap);
+	array.clear();
+	array.reserve(count);
+	for(size_t i(0); i < BITMAP_WORDS; ++i)
+		for(uint64_t word(bitmap[i]); word; word &= word - 1)
+			array.emplace_back(uint16_t(i * 64 + __builtin_ctzl(word)));
+
+	bitmap.reset();
+}
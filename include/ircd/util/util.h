@@ -49,6 +49,7 @@ namespace ircd
 #include "iterator.h"
 #include "nothrow.h"
 #include "what.h"
+#include "roaring.h"
 
 // Unsorted section
 namespace ircd {
@@ -197,6 +198,17 @@ _constexpr_equal(const char *a,
 	return *a == *b && (*a == '\0' || _constexpr_equal(a + 1, b + 1));
 }
 
+/// Compile-time lexical ordering of string literals
+///
+constexpr bool
+_constexpr_less(const char *a,
+                const char *b)
+{
+	return *a == *b?
+		*a != '\0' && _constexpr_less(a + 1, b + 1):
+		uint8_t(*a) < uint8_t(*b);
+}
+
 /// Iterator based until() matching std::for_each except the function
 /// returns a bool to continue rather than void.
 ///
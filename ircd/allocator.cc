@@ -0,0 +1,245 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::allocator
+{
+	extern conf::item<size_t> arena_block_size;
+	extern stats::counter arena_allocs;
+	extern stats::counter arena_bytes;
+	extern stats::counter arena_blocks;
+}
+
+decltype(ircd::allocator::arena_block_size)
+ircd::allocator::arena_block_size
+{
+	{ "name",     "ircd.allocator.arena.block_size" },
+	{ "default",  ssize_t(64_KiB)                   },
+};
+
+decltype(ircd::allocator::arena_allocs)
+ircd::allocator::arena_allocs
+{
+	"ircd.allocator.arena.allocs",
+	"Allocations served from context scratch arenas.",
+};
+
+decltype(ircd::allocator::arena_bytes)
+ircd::allocator::arena_bytes
+{
+	"ircd.allocator.arena.bytes",
+	"Bytes served from context scratch arenas.",
+};
+
+decltype(ircd::allocator::arena_blocks)
+ircd::allocator::arena_blocks
+{
+	"ircd.allocator.arena.blocks",
+	"Blocks taken from the heap by context scratch arenas.",
+};
+
+/// The current context's arena while an arena::scope is open on it; null
+/// otherwise, and on the main stack.
+ircd::allocator::arena *
+ircd::allocator::scratch()
+noexcept
+{
+	if(!ctx::current)
+		return nullptr;
+
+	auto &arena
+	{
+		attached(*ctx::current)
+	};
+
+	return arena.depth? &arena : nullptr;
+}
+
+void *
+ircd::allocator::allocate(arena &arena,
+                          const size_t &size,
+                          const size_t &align)
+{
+	return arena.allocate(size, align);
+}
+
+void
+ircd::allocator::deallocate(arena &arena,
+                            void *const &ptr,
+                            const size_t &size)
+noexcept
+{
+	arena.deallocate(ptr, size);
+}
+
+//
+// arena::scope
+//
+
+ircd::allocator::arena::scope::scope()
+:a
+{
+	ctx::current? &attached(*ctx::current) : nullptr
+}
+{
+	if(!a)
+		return;
+
+	++a->depth;
+}
+
+ircd::allocator::arena::scope::~scope()
+noexcept
+{
+	if(!a)
+		return;
+
+	assert(a->depth > 0);
+	if(--a->depth == 0)
+		a->reset();
+}
+
+//
+// arena
+//
+
+ircd::allocator::arena::arena()
+:arena
+{
+	size_t(arena_block_size)
+}
+{}
+
+ircd::allocator::arena::arena(const size_t &block_size)
+:block_size{block_size}
+{}
+
+ircd::allocator::arena::~arena()
+noexcept
+{
+	assert(depth == 0);
+}
+
+void *
+ircd::allocator::arena::allocate(const size_t &size,
+                                 const size_t &align)
+{
+	assert(align && (align & (align - 1)) == 0);
+	for(; cur < blocks.size(); ++cur)
+	{
+		auto &block(blocks[cur]);
+		const size_t pos
+		{
+			(block.used + align - 1) & ~(align - 1)
+		};
+
+		if(pos + size > block.size)
+			continue;
+
+		block.used = pos + size;
+		++arena_allocs;
+		arena_bytes += size;
+		return block.buf.get() + pos;
+	}
+
+	// Blocks from new[] are aligned for any fundamental type; room is made
+	// to align a larger request within.
+	const size_t block_size
+	{
+		std::max(size + (align > alignof(std::max_align_t)? align : 0), this->block_size)
+	};
+
+	blocks.emplace_back(block
+	{
+		std::unique_ptr<uint8_t[]>{new uint8_t[block_size]}, block_size, 0
+	});
+
+	++arena_blocks;
+	cur = blocks.size() - 1;
+	return allocate(size, align);
+}
+
+void
+ircd::allocator::arena::deallocate(void *const &ptr,
+                                   const size_t &size)
+noexcept
+{
+	if(cur >= blocks.size())
+		return;
+
+	// Only the last allocation can be given back; everything else waits
+	// for the scope to close.
+	auto &block(blocks[cur]);
+	const auto *const p(reinterpret_cast<const uint8_t *>(ptr));
+	if(p + size == block.buf.get() + block.used)
+		block.used -= size;
+}
+
+ircd::allocator::arena::mark
+ircd::allocator::arena::tell()
+const noexcept
+{
+	return
+	{
+		cur, cur < blocks.size()? blocks[cur].used : 0
+	};
+}
+
+void
+ircd::allocator::arena::rewind(const mark &mark)
+noexcept
+{
+	assert(mark.block <= blocks.size());
+	for(size_t i(mark.block + 1); i < blocks.size(); ++i)
+		blocks[i].used = 0;
+
+	cur = mark.block;
+	if(cur < blocks.size())
+		blocks[cur].used = mark.used;
+}
+
+/// Release everything, keeping the first block for the next use unless it
+/// was grown for a single large allocation.
+void
+ircd::allocator::arena::reset()
+noexcept
+{
+	assert(depth == 0);
+	const bool keep
+	{
+		!blocks.empty() && blocks.front().size == block_size
+	};
+
+	blocks.resize(keep);
+	cur = 0;
+	if(keep)
+		blocks.front().used = 0;
+}
+
+size_t
+ircd::allocator::arena::allocated()
+const
+{
+	return std::accumulate(begin(blocks), end(blocks), size_t(0), []
+	(const size_t &ret, const block &block)
+	{
+		return ret + block.size;
+	});
+}
+
+size_t
+ircd::allocator::arena::used()
+const
+{
+	return std::accumulate(begin(blocks), end(blocks), size_t(0), []
+	(const size_t &ret, const block &block)
+	{
+		return ret + block.used;
+	});
+}
@@ -35,6 +35,34 @@ ircd::client::settings::pool_size
 	{ "default",  64L                      },
 };
 
+ircd::conf::item<size_t>
+ircd::client::settings::pool_max
+{
+	{ "name",     "ircd.client.pool_max" },
+	{ "default",  256L                   },
+};
+
+ircd::conf::item<ircd::milliseconds>
+ircd::client::settings::pool_grow_wait
+{
+	{ "name",     "ircd.client.pool_grow_wait" },
+	{ "default",  10L                          },
+};
+
+ircd::conf::item<ircd::seconds>
+ircd::client::settings::pool_idle
+{
+	{ "name",     "ircd.client.pool_idle" },
+	{ "default",  60L                     },
+};
+
+ircd::conf::item<ircd::milliseconds>
+ircd::client::settings::pool_starve
+{
+	{ "name",     "ircd.client.pool_starve" },
+	{ "default",  2500L                     },
+};
+
 /// Linkage for the default settings
 decltype(ircd::client::settings)
 ircd::client::settings
@@ -87,6 +115,119 @@ decltype(ircd::client::ctr)
 ircd::client::ctr
 {};
 
+//
+// client::stats
+//
+
+decltype(ircd::client::stats::accepted)
+ircd::client::stats::accepted
+{
+	"ircd.client.accepted",
+	"Connections accepted since startup.",
+	[] { return ctr; }
+};
+
+decltype(ircd::client::stats::connected)
+ircd::client::stats::connected
+{
+	"ircd.client.connected",
+	"Clients currently connected.",
+	[] { return int64_t(client::list.size()); }
+};
+
+decltype(ircd::client::stats::requests)
+ircd::client::stats::requests
+{
+	"ircd.client.requests",
+	"HTTP requests received.",
+};
+
+decltype(ircd::client::stats::request_time)
+ircd::client::stats::request_time
+{
+	"ircd.client.request_time_us",
+	"Microseconds from receipt of a request to the start of its response.",
+};
+
+decltype(ircd::client::stats::queue_wait)
+ircd::client::stats::queue_wait
+{
+	"ircd.client.queue_wait_us",
+	"Microseconds a ready client waited for a request context.",
+};
+
+//
+// client::lane
+//
+
+decltype(ircd::client::lane::federation)
+ircd::client::lane::federation
+{
+	"federation",
+	{
+		{ "name",     "ircd.client.lane.federation.wait_max" },
+		{ "default",  5000L                                  },
+	},
+	{
+		{ "name",     "ircd.client.lane.federation.active_max" },
+		{ "default",  0L                                       },
+	},
+	"ircd.client.lane.federation.rejected",
+};
+
+decltype(ircd::client::lane::media)
+ircd::client::lane::media
+{
+	"media",
+	{
+		{ "name",     "ircd.client.lane.media.wait_max" },
+		{ "default",  5000L                             },
+	},
+	{
+		{ "name",     "ircd.client.lane.media.active_max" },
+		{ "default",  32L                                 },
+	},
+	"ircd.client.lane.media.rejected",
+};
+
+decltype(ircd::client::lane::clients)
+ircd::client::lane::clients
+{
+	"client",
+	{
+		{ "name",     "ircd.client.lane.client.wait_max" },
+		{ "default",  2500L                              },
+	},
+	{
+		{ "name",     "ircd.client.lane.client.active_max" },
+		{ "default",  0L                                   },
+	},
+	"ircd.client.lane.client.rejected",
+};
+
+ircd::client::lane &
+ircd::client::lane::find(const string_view &path)
+{
+	if(startswith(path, "/_matrix/federation/") || startswith(path, "/_matrix/key/"))
+		return federation;
+
+	if(startswith(path, "/_matrix/media/"))
+		return media;
+
+	return clients;
+}
+
+ircd::client::lane::lane(const string_view &name,
+                         const json::members &wait_max,
+                         const json::members &active_max,
+                         const string_view &rejected)
+:name{name}
+,wait_max{wait_max}
+,active_max{active_max}
+,rejected{rejected, "Requests refused by admission control."}
+{
+}
+
 // Linkage for the container of all active clients for iteration purposes.
 template<>
 decltype(ircd::util::instance_list<ircd::client>::list)
@@ -99,6 +240,11 @@ ircd::util::instance_list<ircd::client>::list
 
 ircd::client::init::init()
 {
+	context.opts.min = settings.pool_size;
+	context.opts.max = std::max(size_t(settings.pool_max), size_t(settings.pool_size));
+	context.opts.grow_wait = settings.pool_grow_wait;
+	context.opts.idle = settings.pool_idle;
+	context.opts.starve = settings.pool_starve;
 	context.add(size_t(settings.pool_size));
 }
 
@@ -356,19 +502,28 @@ ircd::handle_client_ready(std::shared_ptr<client> client,
 	if(!handle_ec(*client, ec))
 		return;
 
+	// The priority of a request isn't known until its head is read on a ctx.
+	// A connection whose last request was HIGH is dispatched as HIGH; any
+	// other is NORMAL, and a request which then turns out to be BULK takes
+	// its place in that queue from there (see resource::operator()).
+	client->prio = client->prio == ctx::pool::HIGH? ctx::pool::HIGH : ctx::pool::NORMAL;
+	const auto prio(client->prio);
+	client->queued = now<steady_point>();
+
 	auto handler
 	{
 		std::bind(ircd::handle_client_request, std::move(client))
 	};
 
-	if(client::context.avail() == 0)
+	if(client::context.avail() == 0 && client::context.size() >= client::context.opts.max)
 		log::dwarning
 		{
-			"Client context pool exhausted. %zu requests queued.",
-			client::context.queued()
+			"Client context pool exhausted. %zu requests queued for %ld$ms.",
+			client::context.queued(),
+			duration_cast<milliseconds>(client::context.delay()).count()
 		};
 
-	client::context(std::move(handler));
+	client::context(std::move(handler), prio);
 }
 
 /// A request context has been dispatched and is now handling this client.
@@ -385,6 +540,8 @@ noexcept try
 	assert(ctx::current);
 	assert(!client->reqctx);
 	client->reqctx = ctx::current;
+	client->queue_wait = now<steady_point>() - client->queued;
+	client::stats::queue_wait(duration_cast<microseconds>(client->queue_wait).count());
 	const unwind reset{[&client]
 	{
 		assert(bool(client));
@@ -759,6 +916,23 @@ try
 	content_consumed = std::min(pc.unparsed(), head.content_length);
 	pc.parsed += content_consumed;
 	assert(pc.parsed <= pc.read);
+	++stats::requests;
+
+	// Attach a trace to this ctx for the remainder of the request; if it
+	// turns out to be slow the breakdown is retained (see trace.h).
+	const fmt::bsprintf<trace::sample::LABEL_MAX + 1> label
+	{
+		"%s %s", head.method, head.path
+	};
+
+	const trace::request tracing
+	{
+		label, id
+	};
+
+	// Scratch memory taken while handling this request is released all at
+	// once when it's done (see allocator.h).
+	const allocator::arena::scope scratch;
 
 	// The resource being sought will have its own specific timeout, or none
 	// at all. This timeout is now canceled to not conflict. Note that the
@@ -835,12 +1009,30 @@ try
 		data(head_buffer) + head_length, content_consumed
 	};
 
+	auto &lane
+	{
+		lane::find(head.path)
+	};
+
+	admit(lane);
+	++lane.active;
+	const unwind release{[&lane]
+	{
+		--lane.active;
+	}};
+
+	string_view param[8];
+	vector_view<string_view> parv
+	{
+		param
+	};
+
 	auto &resource
 	{
-		ircd::resource::find(head.path)
+		ircd::resource::find(head.path, parv)
 	};
 
-	resource(*this, head, content_partial);
+	resource(*this, head, content_partial, parv);
 	discard_unconsumed(head);
 	return true;
 }
@@ -883,6 +1075,55 @@ catch(const http::error &e)
 	}
 }
 
+/// Admission control; throws a 503 if the request should not be handled.
+/// The queueing delay only counts against the first request handled after
+/// dispatch; pipelined requests following it didn't wait for a context.
+void
+ircd::client::admit(lane &lane)
+{
+	const auto wait
+	{
+		std::exchange(queue_wait, 0ns)
+	};
+
+	const milliseconds &wait_max(lane.wait_max);
+	const size_t &active_max(lane.active_max);
+	const bool overdue
+	{
+		wait_max > 0ms && wait > wait_max
+	};
+
+	const bool saturated
+	{
+		active_max && lane.active >= active_max
+	};
+
+	if(likely(!overdue && !saturated))
+		return;
+
+	++lane.rejected;
+	log::dwarning
+	{
+		"socket(%p) local[%s] remote[%s] %s lane refused request; waited %ld$ms with %zu active",
+		sock.get(),
+		string(local(*this)),
+		string(remote(*this)),
+		lane.name,
+		duration_cast<milliseconds>(wait).count(),
+		lane.active
+	};
+
+	const http::header headers[]
+	{
+		{ "Retry-After", "1" },
+	};
+
+	throw http::error
+	{
+		http::SERVICE_UNAVAILABLE, {}, headers
+	};
+}
+
 void
 ircd::client::discard_unconsumed(const http::request::head &head)
 {
@@ -933,11 +1174,70 @@ ircd::client::close(const net::close_opts &opts,
 	net::close(*sock, opts, std::move(callback));
 }
 
+/// Gather write. The TLS layer makes a record and a write to the socket out
+/// of each buffer in turn, so runs of small buffers (i.e a head, chunk
+/// framing, separators) are first copied together on the stack; anything
+/// larger is sent from where it is without being staged.
+size_t
+ircd::client::write_all(const vector_view<const const_buffer> &bufs)
+{
+	if(unlikely(!sock))
+		throw error{"No socket to client."};
+
+	static constexpr const size_t GATHER_MAX {16};
+	static constexpr const size_t SMALL_MAX {512};
+	if(bufs.size() > GATHER_MAX)
+	{
+		const trace::span span{"write"};
+		return net::write_all(*sock, bufs);
+	}
+
+	char small[2_KiB];
+	mutable_buffer rem{small};
+	const_buffer iov[GATHER_MAX];
+	size_t n(0);
+	for(const auto &buf : bufs)
+	{
+		if(empty(buf))
+			continue;
+
+		if(size(buf) > SMALL_MAX || size(buf) > size(rem))
+		{
+			iov[n++] = buf;
+			continue;
+		}
+
+		const size_t copied
+		{
+			copy(rem, buf)
+		};
+
+		if(n && end(iov[n - 1]) == data(rem))
+			iov[n - 1] = const_buffer{data(iov[n - 1]), size(iov[n - 1]) + copied};
+		else
+			iov[n++] = const_buffer{data(rem), copied};
+
+		consume(rem, copied);
+	}
+
+	const trace::span span
+	{
+		"write"
+	};
+
+	return net::write_all(*sock, vector_view<const const_buffer>{iov, n});
+}
+
 size_t
 ircd::client::write_all(const const_buffer &buf)
 {
 	if(unlikely(!sock))
 		throw error{"No socket to client."};
 
+	const trace::span span
+	{
+		"write"
+	};
+
 	return net::write_all(*sock, buf);
 }
@@ -0,0 +1,552 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+#include <RB_INC_ZSTD_H
+
+namespace ircd::compress
+{
+	// Each stream has its own output buffer because the sink may yield the
+	// ctx and another stream may run in the meantime.
+	constexpr size_t BUFSIZE {32_KiB};
+
+	static void throw_on_error(const type &, const ssize_t &code);
+}
+
+/// Per-stream library state for the deflater. Only the member for the type
+/// is initialized.
+struct ircd::compress::deflater::state
+{
+	unique_buffer<mutable_buffer> buf {BUFSIZE};
+
+	#ifdef HAVE_LIBZ
+	z_stream z {};
+	#endif
+
+	#ifdef HAVE_ZSTD
+	ZSTD_CStream *zs {nullptr};
+	#endif
+};
+
+struct ircd::compress::inflater::state
+{
+	unique_buffer<mutable_buffer> buf {BUFSIZE};
+
+	#ifdef HAVE_LIBZ
+	z_stream z {};
+	#endif
+
+	#ifdef HAVE_ZSTD
+	ZSTD_DStream *zs {nullptr};
+	#endif
+};
+
+ircd::string_view
+ircd::compress::reflect(const type &type)
+{
+	switch(type)
+	{
+		case type::NONE:  return "identity";
+		case type::GZIP:  return "gzip";
+		case type::ZSTD:  return "zstd";
+	}
+
+	return "identity";
+}
+
+ircd::compress::type
+ircd::compress::find(const string_view &coding)
+{
+	#ifdef HAVE_ZSTD
+	if(iequals(coding, "zstd"_sv))
+		return type::ZSTD;
+	#endif
+
+	#ifdef HAVE_LIBZ
+	if(iequals(coding, "gzip"_sv) || iequals(coding, "x-gzip"_sv))
+		return type::GZIP;
+	#endif
+
+	return type::NONE;
+}
+
+/// Quality values are only honored to the extent that q=0 refuses the
+/// coding; otherwise our own preference (zstd, then gzip) decides.
+ircd::compress::type
+ircd::compress::negotiate(const string_view &accept_encoding)
+{
+	type ret{type::NONE};
+	tokens(accept_encoding, ',', [&ret]
+	(const string_view &token)
+	{
+		const auto &coding(split(strip(token), ';'));
+		const auto &param(split(strip(coding.second), '='));
+		const auto &q(strip(param.second));
+		if(iequals(strip(param.first), "q"_sv) && try_lex_cast<double>(q))
+			if(lex_cast<double>(q) <= 0.0)
+				return;
+
+		const auto type
+		{
+			compress::find(strip(coding.first))
+		};
+
+		if(type > ret)
+			ret = type;
+	});
+
+	return ret;
+}
+
+ircd::string_view
+ircd::compress::accepted()
+{
+	#if defined(HAVE_ZSTD) && defined(HAVE_LIBZ)
+	return "zstd, gzip";
+	#elif defined(HAVE_ZSTD)
+	return "zstd";
+	#elif defined(HAVE_LIBZ)
+	return "gzip";
+	#else
+	return "identity";
+	#endif
+}
+
+size_t
+ircd::compress::bound(const type &type,
+                      const size_t &size)
+{
+	switch(type)
+	{
+		#ifdef HAVE_LIBZ
+		case type::GZIP:
+			// deflateBound() plus the gzip header and trailer.
+			return ::compressBound(size) + 18;
+		#endif
+
+		#ifdef HAVE_ZSTD
+		case type::ZSTD:
+			return ZSTD_compressBound(size);
+		#endif
+
+		default:
+			return size;
+	}
+}
+
+ircd::const_buffer
+ircd::compress::deflate(const mutable_buffer &out,
+                        const const_buffer &in,
+                        const type &type,
+                        const int &level)
+{
+	assert(size(out) >= bound(type, size(in)));
+	window_buffer wb{out};
+	const auto sink{[&wb](const const_buffer &buf)
+	{
+		wb([&buf](const mutable_buffer &out)
+		{
+			return copy(out, buf);
+		});
+	}};
+
+	deflater deflater
+	{
+		type, level
+	};
+
+	deflater(in, sink);
+	deflater.finish(sink);
+	return wb.completed();
+}
+
+void
+ircd::compress::throw_on_error(const type &type,
+                               const ssize_t &code)
+{
+	switch(type)
+	{
+		#ifdef HAVE_LIBZ
+		case type::GZIP:
+			if(code == Z_OK || code == Z_STREAM_END || code == Z_BUF_ERROR)
+				return;
+
+			throw error
+			{
+				"gzip: %s (%zd)", ::zError(code), code
+			};
+		#endif
+
+		#ifdef HAVE_ZSTD
+		case type::ZSTD:
+			if(!ZSTD_isError(code))
+				return;
+
+			throw error
+			{
+				"zstd: %s", ZSTD_getErrorName(code)
+			};
+		#endif
+
+		default:
+			return;
+	}
+}
+
+//
+// deflater
+//
+
+ircd::compress::deflater::deflater(const enum type &type,
+                                   const int &level)
+:type{type}
+,s{std::make_unique<state>()}
+{
+	switch(type)
+	{
+		#ifdef HAVE_LIBZ
+		case type::GZIP:
+		{
+			// windowBits+16 writes a gzip header and trailer.
+			const int lvl(std::min(std::max(level, 1), 9));
+			throw_on_error(type, ::deflateInit2(&s->z, lvl, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY));
+			break;
+		}
+		#endif
+
+		#ifdef HAVE_ZSTD
+		case type::ZSTD:
+		{
+			const int lvl(std::min(std::max(level, 1), ZSTD_maxCLevel()));
+			if(!(s->zs = ZSTD_createCStream()))
+				throw error{"zstd: failed to create stream"};
+
+			throw_on_error(type, ZSTD_initCStream(s->zs, lvl));
+			break;
+		}
+		#endif
+
+		default: throw error
+		{
+			"Compression type '%s' is not available", reflect(type)
+		};
+	}
+}
+
+ircd::compress::deflater::deflater()
+{
+}
+
+ircd::compress::deflater::deflater(deflater &&other)
+noexcept
+:type{std::move(other.type)}
+,s{std::move(other.s)}
+,in{std::move(other.in)}
+,out{std::move(other.out)}
+{
+	other.type = type::NONE;
+}
+
+ircd::compress::deflater &
+ircd::compress::deflater::operator=(deflater &&other)
+noexcept
+{
+	// The other's destructor releases whatever this held.
+	std::swap(type, other.type);
+	std::swap(s, other.s);
+	std::swap(in, other.in);
+	std::swap(out, other.out);
+	return *this;
+}
+
+ircd::compress::deflater::~deflater()
+noexcept
+{
+	if(!s)
+		return;
+
+	switch(type)
+	{
+		#ifdef HAVE_LIBZ
+		case type::GZIP:
+			::deflateEnd(&s->z);
+			break;
+		#endif
+
+		#ifdef HAVE_ZSTD
+		case type::ZSTD:
+			ZSTD_freeCStream(s->zs);
+			break;
+		#endif
+
+		default:
+			break;
+	}
+}
+
+void
+ircd::compress::deflater::operator()(const const_buffer &buf,
+                                     const sink &sink)
+{
+	assert(s);
+	const mutable_buffer &ob(s->buf);
+	switch(type)
+	{
+		#ifdef HAVE_LIBZ
+		case type::GZIP:
+		{
+			auto &z(s->z);
+			z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data(buf)));
+			z.avail_in = size(buf);
+			while(z.avail_in)
+			{
+				z.next_out = reinterpret_cast<Bytef *>(data(ob));
+				z.avail_out = size(ob);
+				throw_on_error(type, ::deflate(&z, Z_NO_FLUSH));
+				const size_t produced(size(ob) - z.avail_out);
+				if(produced)
+				{
+					out += produced;
+					sink(const_buffer{data(ob), produced});
+				}
+			}
+
+			break;
+		}
+		#endif
+
+		#ifdef HAVE_ZSTD
+		case type::ZSTD:
+		{
+			ZSTD_inBuffer zin{data(buf), size(buf), 0};
+			while(zin.pos < zin.size)
+			{
+				ZSTD_outBuffer zout{data(ob), size(ob), 0};
+				throw_on_error(type, ZSTD_compressStream(s->zs, &zout, &zin));
+				if(zout.pos)
+				{
+					out += zout.pos;
+					sink(const_buffer{data(ob), zout.pos});
+				}
+			}
+
+			break;
+		}
+		#endif
+
+		default:
+			assert(0);
+			break;
+	}
+
+	in += size(buf);
+}
+
+void
+ircd::compress::deflater::finish(const sink &sink)
+{
+	assert(s);
+	const mutable_buffer &ob(s->buf);
+	switch(type)
+	{
+		#ifdef HAVE_LIBZ
+		case type::GZIP:
+		{
+			auto &z(s->z);
+			z.next_in = nullptr;
+			z.avail_in = 0;
+			int ret(Z_OK); do
+			{
+				z.next_out = reinterpret_cast<Bytef *>(data(ob));
+				z.avail_out = size(ob);
+				ret = ::deflate(&z, Z_FINISH);
+				throw_on_error(type, ret);
+				const size_t produced(size(ob) - z.avail_out);
+				if(produced)
+				{
+					out += produced;
+					sink(const_buffer{data(ob), produced});
+				}
+			}
+			while(ret != Z_STREAM_END);
+			break;
+		}
+		#endif
+
+		#ifdef HAVE_ZSTD
+		case type::ZSTD:
+		{
+			size_t remain(0); do
+			{
+				ZSTD_outBuffer zout{data(ob), size(ob), 0};
+				remain = ZSTD_endStream(s->zs, &zout);
+				throw_on_error(type, remain);
+				if(zout.pos)
+				{
+					out += zout.pos;
+					sink(const_buffer{data(ob), zout.pos});
+				}
+			}
+			while(remain);
+			break;
+		}
+		#endif
+
+		default:
+			assert(0);
+			break;
+	}
+}
+
+//
+// inflater
+//
+
+ircd::compress::inflater::inflater(const enum type &type)
+:type{type}
+,s{std::make_unique<state>()}
+{
+	switch(type)
+	{
+		#ifdef HAVE_LIBZ
+		case type::GZIP:
+			// windowBits+32 detects either a zlib or gzip header.
+			throw_on_error(type, ::inflateInit2(&s->z, 15 + 32));
+			break;
+		#endif
+
+		#ifdef HAVE_ZSTD
+		case type::ZSTD:
+			if(!(s->zs = ZSTD_createDStream()))
+				throw error{"zstd: failed to create stream"};
+
+			throw_on_error(type, ZSTD_initDStream(s->zs));
+			break;
+		#endif
+
+		default: throw error
+		{
+			"Compression type '%s' is not available", reflect(type)
+		};
+	}
+}
+
+ircd::compress::inflater::inflater(inflater &&other)
+noexcept
+:type{std::move(other.type)}
+,s{std::move(other.s)}
+,in{std::move(other.in)}
+,out{std::move(other.out)}
+{
+	other.type = type::NONE;
+}
+
+ircd::compress::inflater &
+ircd::compress::inflater::operator=(inflater &&other)
+noexcept
+{
+	// The other's destructor releases whatever this held.
+	std::swap(type, other.type);
+	std::swap(s, other.s);
+	std::swap(in, other.in);
+	std::swap(out, other.out);
+	return *this;
+}
+
+ircd::compress::inflater::~inflater()
+noexcept
+{
+	if(!s)
+		return;
+
+	switch(type)
+	{
+		#ifdef HAVE_LIBZ
+		case type::GZIP:
+			::inflateEnd(&s->z);
+			break;
+		#endif
+
+		#ifdef HAVE_ZSTD
+		case type::ZSTD:
+			ZSTD_freeDStream(s->zs);
+			break;
+		#endif
+
+		default:
+			break;
+	}
+}
+
+void
+ircd::compress::inflater::operator()(const const_buffer &buf,
+                                     const sink &sink)
+{
+	assert(s);
+	const mutable_buffer &ob(s->buf);
+	switch(type)
+	{
+		#ifdef HAVE_LIBZ
+		case type::GZIP:
+		{
+			auto &z(s->z);
+			z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data(buf)));
+			z.avail_in = size(buf);
+			int ret(Z_OK); do
+			{
+				z.next_out = reinterpret_cast<Bytef *>(data(ob));
+				z.avail_out = size(ob);
+				ret = ::inflate(&z, Z_NO_FLUSH);
+				throw_on_error(type, ret);
+				const size_t produced(size(ob) - z.avail_out);
+				if(produced)
+				{
+					out += produced;
+					sink(const_buffer{data(ob), produced});
+				}
+			}
+			while(ret != Z_STREAM_END && (z.avail_in || !z.avail_out));
+			break;
+		}
+		#endif
+
+		#ifdef HAVE_ZSTD
+		case type::ZSTD:
+		{
+			ZSTD_inBuffer zin{data(buf), size(buf), 0};
+			size_t ret(0); do
+			{
+				ZSTD_outBuffer zout{data(ob), size(ob), 0};
+				ret = ZSTD_decompressStream(s->zs, &zout, &zin);
+				throw_on_error(type, ret);
+				if(zout.pos)
+				{
+					out += zout.pos;
+					sink(const_buffer{data(ob), zout.pos});
+				}
+
+				if(zout.pos < zout.size && zin.pos == zin.size)
+					break;
+			}
+			while(true);
+			break;
+		}
+		#endif
+
+		default:
+			assert(0);
+			break;
+	}
+
+	in += size(buf);
+}
@@ -67,7 +67,15 @@ ircd::conf::set(const string_view &key,
 try
 {
 	auto &item(*items.at(key));
-	return item.set(value);
+	if(!item.set(value))
+		return false;
+
+	// Notify the owner so the new value can be applied to whatever was
+	// configured from it when it was first read.
+	if(item.set_cb)
+		item.set_cb();
+
+	return true;
 }
 catch(const bad_lex_cast &e)
 {
@@ -92,8 +100,10 @@ decltype(ircd::conf::items)
 ircd::conf::items
 {};
 
-/// Conf item abstract constructor.
-ircd::conf::item<void>::item(const json::members &opts)
+/// Conf item abstract constructor. The optional set_cb is called after
+/// the item takes a new value through conf::set().
+ircd::conf::item<void>::item(const json::members &opts,
+                             conf::set_cb set_cb)
 :feature_
 {
 	opts
@@ -106,6 +116,10 @@ ircd::conf::item<void>::item(const json::members &opts)
 {
 	unquote(feature.at("name"))
 }
+,set_cb
+{
+	std::move(set_cb)
+}
 {
 	if(!items.emplace(name, this).second)
 		throw error
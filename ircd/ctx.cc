@@ -9,6 +9,8 @@
 // full license for this software is available in the LICENSE file.
 
 #include <RB_INC_X86INTRIN_H
+#include <RB_INC_SYS_MMAN_H
+#include <RB_INC_UNISTD_H
 #include <cxxabi.h>
 #include <ircd/asio.h>
 #include "ctx.h"
@@ -34,6 +36,60 @@ ircd::ctx::ctx::id_ctr
 	0
 };
 
+//
+// stats
+//
+
+decltype(ircd::ctx::stats::spawned)
+ircd::ctx::stats::spawned
+{
+	"ircd.ctx.spawned",
+	"Contexts created since startup.",
+	[] { return ctx::id_ctr; }
+};
+
+decltype(ircd::ctx::stats::contexts)
+ircd::ctx::stats::contexts
+{
+	"ircd.ctx.contexts",
+	"Contexts currently existing.",
+	[] { return int64_t(ctxs.size()); }
+};
+
+decltype(ircd::ctx::stats::yields)
+ircd::ctx::stats::yields
+{
+	"ircd.ctx.yields",
+	"Context switches by all contexts.",
+};
+
+decltype(ircd::ctx::stats::slice_cycles)
+ircd::ctx::stats::slice_cycles
+{
+	"ircd.ctx.slice_cycles",
+	"TSC cycles spent executing on all contexts.",
+	[] { return uint64_t(prof::total_slice_cycles()); }
+};
+
+/// The request trace attached to a context; this lives here for access to
+/// the ctx internals.
+ircd::trace::request *&
+ircd::trace::attached(ctx::ctx &ctx)
+{
+	return ctx.trace;
+}
+
+/// The scratch arena of a context, created on first use; this lives here
+/// for access to the ctx internals.
+ircd::allocator::arena &
+ircd::allocator::attached(ctx::ctx &ctx)
+{
+	if(!ctx.arena)
+		ctx.arena = std::make_unique<arena>();
+
+	return *ctx.arena;
+}
+
 /// Base frame for a context.
 ///
 /// This function is the first thing executed on the new context's stack
@@ -644,6 +700,7 @@ ircd::ctx::continuation::continuation(ctx *const &self)
 	//assert(!std::uncaught_exceptions());
 
 	self->yields++;
+	++stats::yields;
 	self->cont = this;
 	ircd::ctx::current = nullptr;
 }
@@ -688,6 +745,199 @@ noexcept
 		handler(interruptor);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// ctx/stack.h
+//
+
+namespace ircd::ctx::stack
+{
+	static size_t get_page_size();
+
+	static const size_t _page_size {get_page_size()};
+	static std::multimap<size_t, char *> pool;   // usable size => base of mapping
+	static size_t _mapped;
+}
+
+decltype(ircd::ctx::stack::pool_max)
+ircd::ctx::stack::pool_max
+{
+	{ "name",     "ircd.ctx.stack.pool_max" },
+	{ "default",  128L                      },
+};
+
+decltype(ircd::ctx::stack::trim)
+ircd::ctx::stack::trim
+{
+	{ "name",     "ircd.ctx.stack.trim" },
+	{ "default",  ssize_t(64_KiB)       },
+};
+
+decltype(ircd::ctx::stack::page_size)
+ircd::ctx::stack::page_size
+{
+	_page_size
+};
+
+decltype(ircd::ctx::stats::stack_mapped)
+ircd::ctx::stats::stack_mapped
+{
+	"ircd.ctx.stack.mapped",
+	"Bytes of address space mapped for stacks in use and pooled.",
+	[] { return int64_t(stack::mapped()); }
+};
+
+decltype(ircd::ctx::stats::stack_pooled)
+ircd::ctx::stats::stack_pooled
+{
+	"ircd.ctx.stack.pooled",
+	"Stacks on the free list.",
+	[] { return int64_t(stack::pooled()); }
+};
+
+decltype(ircd::ctx::stats::stack_reused)
+ircd::ctx::stats::stack_reused
+{
+	"ircd.ctx.stack.reused",
+	"Spawns served a stack from the free list.",
+};
+
+/// The usable region is rounded up to whole pages. The guard page sits below
+/// it at the base of the mapping.
+ircd::mutable_buffer
+ircd::ctx::stack::allocate(const size_t &size)
+{
+	const size_t len
+	{
+		(size + page_size - 1) & ~(page_size - 1)
+	};
+
+	const auto it
+	{
+		pool.find(len)
+	};
+
+	if(it != end(pool))
+	{
+		char *const base(it->second);
+		pool.erase(it);
+		++stats::stack_reused;
+		return { base + page_size, len };
+	}
+
+	const size_t map_len
+	{
+		page_size + len
+	};
+
+	void *const map
+	{
+		::mmap(nullptr, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0)
+	};
+
+	if(unlikely(map == MAP_FAILED))
+		throw_system_error(errno);
+
+	if(unlikely(::mprotect(map, page_size, PROT_NONE) != 0))
+	{
+		const auto code(errno);
+		::munmap(map, map_len);
+		throw_system_error(code);
+	}
+
+	_mapped += map_len;
+	return { static_cast<char *>(map) + page_size, len };
+}
+
+void
+ircd::ctx::stack::deallocate(const mutable_buffer &buf)
+noexcept
+{
+	char *const base(data(buf) - page_size);
+	const size_t len(size(buf));
+	if(pool.size() < size_t(pool_max))
+	{
+		// Stacks grow down; the region worth keeping resident is at the top.
+		const size_t keep
+		{
+			std::min((size_t(trim) + page_size - 1) & ~(page_size - 1), len)
+		};
+
+		if(len > keep)
+			::madvise(data(buf), len - keep, MADV_DONTNEED);
+
+		pool.emplace(len, base);
+		return;
+	}
+
+	::munmap(base, page_size + len);
+	_mapped -= page_size + len;
+}
+
+size_t
+ircd::ctx::stack::clear()
+{
+	const size_t ret(pool.size());
+	for(const auto &pair : pool)
+	{
+		::munmap(pair.second, page_size + pair.first);
+		_mapped -= page_size + pair.first;
+	}
+
+	pool.clear();
+	return ret;
+}
+
+size_t
+ircd::ctx::stack::mapped()
+{
+	return _mapped;
+}
+
+size_t
+ircd::ctx::stack::pooled()
+{
+	return pool.size();
+}
+
+size_t
+ircd::ctx::stack::get_page_size()
+{
+	const auto ret(::sysconf(_SC_PAGESIZE));
+	return ret > 0? size_t(ret) : 4_KiB;
+}
+
+/// Every coroutine stack is obtained by boost::asio::spawn() through the
+/// default allocator of boost::coroutines; it has no parameter for another
+/// one. These specializations route it to ctx::stack. They must precede the
+/// instantiation of spawn() below, which is the only one in the project.
+template<>
+void
+boost::coroutines::basic_standard_stack_allocator<boost::coroutines::stack_traits>::allocate(stack_context &sctx,
+                                                                                            std::size_t size)
+{
+	const auto buf
+	{
+		ircd::ctx::stack::allocate(size)
+	};
+
+	sctx.size = ircd::size(buf);
+	sctx.sp = ircd::data(buf) + ircd::size(buf);
+}
+
+template<>
+void
+boost::coroutines::basic_standard_stack_allocator<boost::coroutines::stack_traits>::deallocate(stack_context &sctx)
+{
+	assert(sctx.sp);
+	const ircd::mutable_buffer buf
+	{
+		static_cast<char *>(sctx.sp) - sctx.size, sctx.size
+	};
+
+	ircd::ctx::stack::deallocate(buf);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // ctx/context.h
@@ -870,14 +1120,98 @@ ircd::ctx::pool::pool(const char *const &name,
 ircd::ctx::pool::~pool()
 noexcept
 {
-	del(size());
+	join();
 }
 
 void
-ircd::ctx::pool::operator()(closure closure)
+ircd::ctx::pool::operator()(closure closure,
+                            const prio &prio)
 {
-	queue.push_back(std::move(closure));
+	assert(prio < PRIOS);
+	queue.at(prio).emplace_back(std::move(closure), now<steady_point>());
 	dock.notify();
+	grow();
+
+	// When every context is busy there may be no further dispatch or worker
+	// loop to check growth again before the closure has waited its limit.
+	if(opts.max && size() < opts.max && !avail() && watcher.joined())
+		watcher = context
+		{
+			name, DEFAULT_STACK_SIZE, context::POST, std::bind(&pool::watch, this)
+		};
+}
+
+/// Elastic growth. Contexts which were added but haven't started yet
+/// (size() > running) are about to take work, so nothing more is added
+/// until they have; otherwise a burst would grow the pool to max at once.
+void
+ircd::ctx::pool::grow()
+{
+	if(opts.max && size() < opts.max && size() == running && !avail())
+		if(delay() >= opts.grow_wait)
+			add(1);
+}
+
+/// Checks growth while closures are waiting, at the time the oldest of them
+/// reaches opts.grow_wait; returns when the queue is drained or the pool is
+/// at its limit.
+void
+ircd::ctx::pool::watch()
+noexcept try
+{
+	while(opts.max && size() < opts.max && queued())
+	{
+		const auto waited
+		{
+			duration_cast<milliseconds>(delay())
+		};
+
+		this_ctx::sleep(std::max(opts.grow_wait - waited, milliseconds(1)));
+		grow();
+	}
+}
+catch(const interrupted &e)
+{
+	return;
+}
+catch(const terminated &e)
+{
+	return;
+}
+
+ircd::nanoseconds
+ircd::ctx::pool::delay()
+const
+{
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	nanoseconds ret{0ns};
+	for(const auto &queue : this->queue)
+		if(!queue.empty())
+			ret = std::max(ret, nanoseconds(now - queue.front().second));
+
+	return ret;
+}
+
+size_t
+ircd::ctx::pool::queued()
+const
+{
+	return std::accumulate(begin(queue), end(queue), size_t(0), []
+	(const size_t &ret, const auto &queue)
+	{
+		return ret + queue.size();
+	});
+}
+
+size_t
+ircd::ctx::pool::queued(const prio &prio)
+const
+{
+	return queue.at(prio).size();
 }
 
 void
@@ -885,8 +1219,15 @@ ircd::ctx::pool::del(const size_t &num)
 {
 	const ssize_t requested(size() - num);
 	const size_t target(std::max(requested, ssize_t(0)));
-	while(ctxs.size() > target)
-		ctxs.pop_back();
+
+	// The victims are moved out before being joined because other contexts
+	// may retire() and erase themselves from ctxs while this one yields.
+	std::vector<context> victims;
+	victims.reserve(ctxs.size() - target);
+	std::move(begin(ctxs) + target, end(ctxs), std::back_inserter(victims));
+	ctxs.erase(begin(ctxs) + target, end(ctxs));
+	while(!victims.empty())
+		victims.pop_back();
 }
 
 void
@@ -899,6 +1240,13 @@ ircd::ctx::pool::add(const size_t &num)
 void
 ircd::ctx::pool::join()
 {
+	// Can't join to bare metal; the handle's destructor deals with that.
+	if(current && !watcher.joined())
+	{
+		watcher.interrupt();
+		watcher.join();
+	}
+
 	del(size());
 }
 
@@ -919,8 +1267,7 @@ noexcept try
 		--running;
 	});
 
-	while(1)
-		next();
+	while(next());
 }
 catch(const interrupted &e)
 {
@@ -937,14 +1284,21 @@ catch(const terminated &e)
 //	};
 }
 
-void
+/// Returns false when the calling context has retired from the pool and
+/// must return from main().
+bool
 ircd::ctx::pool::next()
 try
 {
-	dock.wait([this]
+	const auto ready{[this]
 	{
-		return !queue.empty();
-	});
+		return queued() > 0;
+	}};
+
+	if(!opts.max || size() <= opts.min)
+		dock.wait(ready);
+	else if(!dock.wait_for(opts.idle, ready))
+		return size() > opts.min? !retire() : true;
 
 	++working;
 	const unwind avail([this]
@@ -952,9 +1306,21 @@ try
 		--working;
 	});
 
-	const auto func(std::move(queue.front()));
+	auto &queue
+	{
+		this->queue.at(select())
+	};
+
+	const auto func(std::move(queue.front().first));
 	queue.pop_front();
+
+	// Taking this closure leaves the pool with one less available context;
+	// the others still queued may have waited long enough for another.
+	if(queued())
+		grow();
+
 	func();
+	return true;
 }
 catch(const interrupted &e)
 {
@@ -971,6 +1337,119 @@ catch(const std::exception &e)
 		ircd::ctx::id(cur()),
 		e.what()
 	};
+
+	return true;
+}
+
+/// Choose the class of the next closure to run; at least one is queued.
+/// Each class spends one credit per dispatch from highest to lowest, and
+/// credits are refilled from opts.weight when no class with work queued has
+/// any left. A closure which has waited opts.starve is promoted ahead of
+/// that: only the single oldest of them, and not twice in a row, so under
+/// overload (when every class starves) half the dispatches still follow the
+/// weights instead of all going to whichever class is searched first.
+size_t
+ircd::ctx::pool::select()
+{
+	assert(queued());
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	size_t oldest(PRIOS);
+	for(size_t i(0); i < PRIOS && !promoted; ++i)
+		if(!queue[i].empty() && now - queue[i].front().second >= opts.starve)
+			if(oldest == PRIOS || queue[i].front().second < queue[oldest].front().second)
+				oldest = i;
+
+	promoted = oldest < PRIOS;
+	if(promoted)
+		return oldest;
+
+	for(size_t pass(0); pass < 2; ++pass)
+	{
+		for(size_t i(0); i < PRIOS; ++i)
+			if(!queue[i].empty() && credit[i])
+			{
+				--credit[i];
+				return i;
+			}
+
+		for(size_t i(0); i < PRIOS; ++i)
+			credit[i] = std::max(opts.weight[i], 1U);
+	}
+
+	assert(0);
+	return 0;
+}
+
+/// Called by a closure running on this pool which has only now learned its
+/// class (e.g a request once its head is read) to take its place behind the
+/// work queued ahead of that class. The caller waits, holding its context,
+/// until a ticket queued at the class is dispatched. The ticket can only run
+/// on another free context of this pool, so the caller doesn't wait when
+/// none is free, and never longer than the timeout. Returns false without
+/// waiting for the ticket in those cases or when nothing is queued.
+bool
+ircd::ctx::pool::requeue(const prio &prio,
+                         const milliseconds &timeout)
+{
+	if(!queued() || !avail())
+		return false;
+
+	// The ticket may outlive this frame if the caller is interrupted or
+	// times out; it does nothing then.
+	const auto waiter
+	{
+		std::make_shared<ctx *>(current)
+	};
+
+	const unwind release{[&waiter]
+	{
+		*waiter = nullptr;
+	}};
+
+	operator()([waiter]
+	{
+		if(*waiter)
+			ircd::ctx::notify(**waiter);
+
+		*waiter = nullptr;
+	}, prio);
+
+	const auto deadline
+	{
+		now<steady_point>() + timeout
+	};
+
+	while(*waiter)
+		if(this_ctx::wait_until(deadline, std::nothrow))
+			return false;
+
+	return true;
+}
+
+/// Remove the calling context from the pool. The context is detached from
+/// its handle so it frees itself when it returns from main().
+bool
+ircd::ctx::pool::retire()
+{
+	const auto it
+	{
+		std::find_if(begin(ctxs), end(ctxs), []
+		(const context &context)
+		{
+			return context && &static_cast<const ctx &>(context) == current;
+		})
+	};
+
+	if(unlikely(it == end(ctxs)))
+		return false;
+
+	it->detach();
+	ctxs.erase(it);
+	return true;
 }
 
 void
@@ -978,14 +1457,15 @@ ircd::ctx::debug_stats(const pool &pool)
 {
 	log::debug
 	{
-		"pool '%s' (stack size: %zu) total: %zu avail: %zu queued: %zu active: %zu pending: %zu",
+		"pool '%s' (stack size: %zu) total: %zu avail: %zu queued: %zu active: %zu pending: %zu delay: %ld$ms",
 		pool.name,
 		pool.stack_size,
 		pool.size(),
 		pool.avail(),
 		pool.queued(),
 		pool.active(),
-		pool.pending()
+		pool.pending(),
+		duration_cast<milliseconds>(pool.delay()).count()
 	};
 }
 
@@ -31,6 +31,8 @@ struct ircd::ctx::ctx
 	uint64_t yields {0};                         // monotonic counter
 	continuation *cont {nullptr};                // valid when asleep; invalid when awake
 	ctx *adjoindre {nullptr};                    // context waiting for this to join()
+	trace::request *trace {nullptr};             // request trace attached (see trace.h)
+	std::unique_ptr<allocator::arena> arena;     // scratch memory (see allocator.h)
 	list::node node;                             // node for ctx::list
 
 	bool started() const                         { return stack_base != 0;                         }
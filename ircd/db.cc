@@ -8,6 +8,8 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <RB_INC_UNISTD_H
+#include <RB_INC_SYS_SYSCALL_H
 #include <rocksdb/version.h>
 #include <rocksdb/db.h>
 #include <rocksdb/cache.h>
@@ -24,9 +26,11 @@
 #include <rocksdb/filter_policy.h>
 #include <rocksdb/table.h>
 #include <rocksdb/sst_file_manager.h>
+#include <rocksdb/rate_limiter.h>
 
 #include <ircd/db/database/comparator.h>
 #include <ircd/db/database/prefix_transform.h>
+#include <ircd/db/database/filter_policy.h>
 #include <ircd/db/database/mergeop.h>
 #include <ircd/db/database/events.h>
 #include <ircd/db/database/stats.h>
@@ -115,6 +119,7 @@ ircd::db::init::init()
 ircd::db::init::~init()
 noexcept
 {
+	jobs::fini();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -418,8 +423,9 @@ try
 ,cache{[this]
 () -> std::shared_ptr<rocksdb::Cache>
 {
-	//TODO: conf
-	const auto lru_cache_size{16_MiB};
+	// Always created so the size can be raised from zero later; a database
+	// can't be given a row cache once it is open.
+	const size_t &lru_cache_size(row_cache_size);
 	return rocksdb::NewLRUCache(lru_cache_size);
 }()}
 ,descriptors
@@ -488,9 +494,8 @@ try
 	opts.stats_dump_period_sec = 0;
 	opts.enable_thread_tracking = true;
 	opts.delete_obsolete_files_period_micros = 0;
-	opts.max_background_jobs = 0;
-	opts.max_background_flushes = 0;
-	opts.max_background_compactions = 0;
+	opts.rate_limiter = jobs::limiter(); // must precede threads(); see reconf()
+	opts.max_background_jobs = jobs::background_jobs();
 	opts.max_subcompactions = 0;
 	opts.max_open_files = -1; //ircd::info::rlimit_nofile / 4;
 	//opts.allow_concurrent_memtable_write = true;
@@ -636,6 +641,10 @@ try
 		#endif
 	};
 
+	// Now that the columns of this database are counted toward the budget
+	// all column caches can be resized.
+	apply_cache_budget();
+
 	log.info("'%s': Opened database @ `%s' with %zu columns at sequence number %lu.",
 	         this->name,
 	         path,
@@ -913,6 +922,57 @@ const noexcept
 	return user.has(slice(key));
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// database::filter_policy
+//
+
+void
+ircd::db::database::filter_policy::set(const size_t &bits)
+{
+	policies.emplace_back(rocksdb::NewBloomFilterPolicy(bits, false));
+	policy.store(policies.back().get(), std::memory_order_release);
+}
+
+const char *
+ircd::db::database::filter_policy::Name()
+const noexcept
+{
+	assert(policy.load(std::memory_order_acquire));
+	return policy.load(std::memory_order_acquire)->Name();
+}
+
+void
+ircd::db::database::filter_policy::CreateFilter(const Slice *const keys,
+                                                int n,
+                                                std::string *const dst)
+const
+{
+	policy.load(std::memory_order_acquire)->CreateFilter(keys, n, dst);
+}
+
+bool
+ircd::db::database::filter_policy::KeyMayMatch(const Slice &key,
+                                               const Slice &filter)
+const
+{
+	return policy.load(std::memory_order_acquire)->KeyMayMatch(key, filter);
+}
+
+rocksdb::FilterBitsBuilder *
+ircd::db::database::filter_policy::GetFilterBitsBuilder()
+const
+{
+	return policy.load(std::memory_order_acquire)->GetFilterBitsBuilder();
+}
+
+rocksdb::FilterBitsReader *
+ircd::db::database::filter_policy::GetFilterBitsReader(const Slice &contents)
+const
+{
+	return policy.load(std::memory_order_acquire)->GetFilterBitsReader(contents);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // database::column
@@ -951,6 +1011,153 @@ ircd::db::describe(const database::column &c)
 	return c.descriptor;
 }
 
+//
+// compression
+//
+
+decltype(ircd::db::compressions)
+ircd::db::compressions
+{{
+	{ "none",    rocksdb::kNoCompression,      "kNoCompression"      },
+	{ "snappy",  rocksdb::kSnappyCompression,  "kSnappyCompression"  },
+	{ "zlib",    rocksdb::kZlibCompression,    "kZlibCompression"    },
+	{ "bzip2",   rocksdb::kBZip2Compression,   "kBZip2Compression"   },
+	{ "lz4",     rocksdb::kLZ4Compression,     "kLZ4Compression"     },
+	{ "lz4hc",   rocksdb::kLZ4HCCompression,   "kLZ4HCCompression"   },
+	{ "xpress",  rocksdb::kXpressCompression,  "kXpressCompression"  },
+	{ "zstd",    rocksdb::kZSTD,               "kZSTD"               },
+}};
+
+/// Without the ZSTD trainer in older RocksDB the dictionary is a raw sample
+/// of the output; otherwise it is trained from a larger sample (ZSTD
+/// suggests ~100x the dictionary size). An open column takes the options
+/// for its next compactions; files keep the dictionary they were written
+/// with.
+void
+ircd::db::apply_compression_dict(database::column &c)
+{
+	auto &opts(c.options.compression_opts);
+	opts.max_dict_bytes = size_t(c.compression_dict);
+	#if ROCKSDB_MAJOR > 5 || (ROCKSDB_MAJOR == 5 && ROCKSDB_MINOR >= 14)
+	opts.zstd_max_train_bytes = size_t(c.compression_dict_train);
+	#endif
+
+	if(!c.handle)
+		return;
+
+	// window_bits:level:strategy:max_dict_bytes[:zstd_max_train_bytes]
+	#if ROCKSDB_MAJOR > 5 || (ROCKSDB_MAJOR == 5 && ROCKSDB_MINOR >= 14)
+	const std::string value{fmt::snstringf
+	{
+		64, "%d:%d:%d:%u:%u",
+		opts.window_bits,
+		opts.level,
+		opts.strategy,
+		uint(opts.max_dict_bytes),
+		uint(opts.zstd_max_train_bytes)
+	}};
+	#else
+	const std::string value{fmt::snstringf
+	{
+		64, "%d:%d:%d:%u",
+		opts.window_bits,
+		opts.level,
+		opts.strategy,
+		uint(opts.max_dict_bytes)
+	}};
+	#endif
+
+	const std::unordered_map<std::string, std::string> options
+	{
+		{ "compression_opts", value }
+	};
+
+	throw_on_error
+	{
+		c.d->d->SetOptions(c.handle.get(), options)
+	};
+}
+
+/// Name of the conf item for a column's setting:
+/// ircd.db.<dbname>.<column>.<key>
+std::string
+ircd::db::conf_name(const database::column &c,
+                    const string_view &key)
+{
+	return fmt::snstringf
+	{
+		256, "ircd.db.%s.%s.%s",
+		db::name(*c.d),
+		c.name,
+		key
+	};
+}
+
+const ircd::db::compression &
+ircd::db::find_compression(const string_view &name)
+{
+	const auto it
+	{
+		std::find_if(begin(compressions), end(compressions), [&name]
+		(const auto &compression)
+		{
+			return compression.name == name;
+		})
+	};
+
+	if(it == end(compressions))
+		throw error
+		{
+			"Unknown compression algorithm '%s'", name
+		};
+
+	return *it;
+}
+
+/// The first algorithm in the ';' separated list of names which the RocksDB
+/// we're linked with supports; e.g. "zstd;lz4;zlib". Null when the list is
+/// empty, for the RocksDB default. When none is supported it is "none".
+const ircd::db::compression *
+ircd::db::select_compression(const string_view &names)
+{
+	if(empty(names))
+		return nullptr;
+
+	const auto supported
+	{
+		rocksdb::GetSupportedCompressions()
+	};
+
+	const compression *ret{nullptr};
+	tokens(names, ';', [&supported, &ret]
+	(const string_view &name)
+	{
+		const auto &compression
+		{
+			find_compression(name)
+		};
+
+		const bool available
+		{
+			compression.type == rocksdb::kNoCompression ||
+			std::find(begin(supported), end(supported), compression.type) != end(supported)
+		};
+
+		if(!ret && available)
+			ret = &compression;
+	});
+
+	if(!ret)
+	{
+		log.warning("None of the compression algorithms '%s' are available; using none.",
+		            names);
+
+		ret = &find_compression("none");
+	}
+
+	return ret;
+}
+
 //
 // database::column
 //
@@ -975,6 +1182,118 @@ ircd::db::database::column::column(database *const &d,
 			this->d->d->DestroyColumnFamilyHandle(handle);
 	}
 }
+,cache_size
+{
+	{
+		{ "name",     string_view{conf_name(*this, "cache.size")} },
+		{ "default",  long(this->descriptor.cache_size)            },
+	}, []
+	{
+		apply_cache_budget();
+	}
+}
+,cache_size_comp
+{
+	{
+		{ "name",     string_view{conf_name(*this, "cache_comp.size")} },
+		{ "default",  long(this->descriptor.cache_size_comp)            },
+	}, []
+	{
+		apply_cache_budget();
+	}
+}
+,bloom_bits
+{
+	{
+		{ "name",     string_view{conf_name(*this, "bloom.bits")} },
+		{ "default",  long(this->descriptor.bloom_bits)            },
+	}, [this]
+	{
+		// Whether there is a filter at all is up to the descriptor.
+		const size_t &bloom_bits(this->bloom_bits);
+		if(!this->table_opts.filter_policy || !bloom_bits)
+			return;
+
+		this->filter.set(bloom_bits);
+	}
+}
+,block_size
+{
+	{
+		{ "name",     string_view{conf_name(*this, "block.size")} },
+		{ "default",  long(this->descriptor.block_size)            },
+	}, [this]
+	{
+		const size_t &block_size(this->block_size);
+		this->table_opts.block_size = block_size?: rocksdb::BlockBasedTableOptions{}.block_size;
+		if(!this->handle)
+			return;
+
+		// The table factory is shared with RocksDB's flush and compaction
+		// threads; the change goes through the database to reach files
+		// written afterward.
+		const std::unordered_map<std::string, std::string> options
+		{
+			{
+				"block_based_table_factory", fmt::snstringf
+				{
+					64, "{block_size=%zu;}", this->table_opts.block_size
+				}
+			}
+		};
+
+		throw_on_error
+		{
+			this->d->d->SetOptions(this->handle.get(), options)
+		};
+	}
+}
+,compression
+{
+	{
+		{ "name",     string_view{conf_name(*this, "compression")} },
+		{ "default",  string_view{this->descriptor.compression}     },
+	}, [this]
+	{
+		const auto *const compression
+		{
+			select_compression(this->compression)
+		};
+
+		if(!this->handle || !compression)
+			return;
+
+		const std::unordered_map<std::string, std::string> options
+		{
+			{ "compression", std::string{compression->option} }
+		};
+
+		throw_on_error
+		{
+			this->d->d->SetOptions(this->handle.get(), options)
+		};
+	}
+}
+,compression_dict
+{
+	{
+		{ "name",     string_view{conf_name(*this, "compression.dict.size")} },
+		{ "default",  long(this->descriptor.compression_dict)               },
+	}, [this]
+	{
+		apply_compression_dict(*this);
+	}
+}
+,compression_dict_train
+{
+	{
+		{ "name",     string_view{conf_name(*this, "compression.dict.train")} },
+		{ "default",  long(this->descriptor.compression_dict * 100)          },
+	}, [this]
+	{
+		apply_compression_dict(*this);
+	}
+}
 {
 	// If possible, deduce comparator based on type given in descriptor
 	if(!this->descriptor.cmp.less)
@@ -1009,19 +1328,30 @@ ircd::db::database::column::column(database *const &d,
 	//
 
 	// Setup the cache for assets.
-	const auto &cache_size(this->descriptor.cache_size);
+	const size_t &cache_size(this->cache_size);
 	if(cache_size)
 		table_opts.block_cache = rocksdb::NewLRUCache(cache_size);
 
 	// Setup the cache for compressed assets.
-	const auto &cache_size_comp(this->descriptor.cache_size_comp);
+	const size_t &cache_size_comp(this->cache_size_comp);
 	if(cache_size_comp)
 		table_opts.block_cache_compressed = rocksdb::NewLRUCache(cache_size_comp);
 
 	// Setup the bloom filter.
-	const auto &bloom_bits(this->descriptor.bloom_bits);
+	const size_t &bloom_bits(this->bloom_bits);
 	if(bloom_bits)
-		table_opts.filter_policy.reset(rocksdb::NewBloomFilterPolicy(bloom_bits, false));
+	{
+		this->filter.set(bloom_bits);
+		table_opts.filter_policy = std::shared_ptr<const rocksdb::FilterPolicy>
+		{
+			&this->filter, [](const rocksdb::FilterPolicy *) {}
+		};
+	}
+
+	// Setup the block size.
+	const size_t &block_size(this->block_size);
+	if(block_size)
+		table_opts.block_size = block_size;
 
 	// Tickers::READ_AMP_TOTAL_READ_BYTES / Tickers::READ_AMP_ESTIMATE_USEFUL_BYTES
 	//table_opts.read_amp_bytes_per_bit = 8;
@@ -1043,8 +1373,13 @@ ircd::db::database::column::column(database *const &d,
 	this->options.optimize_filters_for_hits = this->descriptor.expect_queries_hit;
 
 	// Compression
-	//TODO: descriptor / conf / detect etc...
-	//this->options.compression = rocksdb::kSnappyCompression;
+	const string_view &compression(this->compression);
+	if(const auto *const selected{select_compression(compression)})
+		this->options.compression = selected->type;
+
+	// Compression dictionary
+	const size_t &compression_dict(this->compression_dict);
+	apply_compression_dict(*this);
 
 	//TODO: descriptor / conf
 	this->options.num_levels = 8;
@@ -1052,7 +1387,7 @@ ircd::db::database::column::column(database *const &d,
 	this->options.target_file_size_multiplier = 4;        // size at level
 	this->options.level0_file_num_compaction_trigger = 2;
 
-	log.debug("schema '%s' column [%s => %s] cmp[%s] pfx[%s] lru:%zu:%zu bloom:%zu %s",
+	log.debug("schema '%s' column [%s => %s] cmp[%s] pfx[%s] lru:%zu:%zu bloom:%zu block:%zu compression:%s:%zu %s",
 	          db::name(*d),
 	          demangle(key_type.name()),
 	          demangle(mapped_type.name()),
@@ -1061,6 +1396,9 @@ ircd::db::database::column::column(database *const &d,
 	          cache_size,
 	          cache_size_comp,
 	          bloom_bits,
+	          block_size,
+	          compression?: "default",
+	          compression_dict,
 	          this->descriptor.name);
 }
 
@@ -1271,6 +1609,100 @@ catch(const std::exception &e)
 // database::stats
 //
 
+decltype(ircd::db::stats::get_time)
+ircd::db::stats::get_time
+{
+	"ircd.db.get_time_us",
+	"Microseconds for a point query.",
+};
+
+decltype(ircd::db::stats::write_time)
+ircd::db::stats::write_time
+{
+	"ircd.db.write_time_us",
+	"Microseconds to write a batch.",
+};
+
+decltype(ircd::db::stats::seek_time)
+ircd::db::stats::seek_time
+{
+	"ircd.db.seek_time_us",
+	"Microseconds for an iterator seek.",
+};
+
+decltype(ircd::db::stats::cache_hit)
+ircd::db::stats::cache_hit
+{
+	"ircd.db.cache_hit",
+	"Block cache hits.",
+	[] { return ticker_total(rocksdb::BLOCK_CACHE_HIT); }
+};
+
+decltype(ircd::db::stats::cache_miss)
+ircd::db::stats::cache_miss
+{
+	"ircd.db.cache_miss",
+	"Block cache misses.",
+	[] { return ticker_total(rocksdb::BLOCK_CACHE_MISS); }
+};
+
+decltype(ircd::db::stats::bytes_read)
+ircd::db::stats::bytes_read
+{
+	"ircd.db.bytes_read",
+	"Bytes read by point queries.",
+	[] { return ticker_total(rocksdb::BYTES_READ); }
+};
+
+decltype(ircd::db::stats::bytes_written)
+ircd::db::stats::bytes_written
+{
+	"ircd.db.bytes_written",
+	"Bytes written by all writes.",
+	[] { return ticker_total(rocksdb::BYTES_WRITTEN); }
+};
+
+decltype(ircd::db::stats::job_wait)
+ircd::db::stats::job_wait
+{
+	"ircd.db.jobs.wait_us",
+	"Microseconds a background job waited for a thread.",
+};
+
+decltype(ircd::db::stats::jobs_queued)
+ircd::db::stats::jobs_queued
+{
+	"ircd.db.jobs.queued",
+	"Background jobs waiting for a thread.",
+	[] { return int64_t(jobs::queued()); }
+};
+
+decltype(ircd::db::stats::jobs_running)
+ircd::db::stats::jobs_running
+{
+	"ircd.db.jobs.running",
+	"Background jobs executing.",
+	[] { return int64_t(jobs::running()); }
+};
+
+decltype(ircd::db::stats::jobs_rate)
+ircd::db::stats::jobs_rate
+{
+	"ircd.db.jobs.rate",
+	"Background write rate limit in bytes per second; 0 is unlimited.",
+	[] { return int64_t(jobs::rate()); }
+};
+
+uint64_t
+ircd::db::ticker_total(const uint32_t &id)
+{
+	return std::accumulate(begin(database::dbs), end(database::dbs), uint64_t(0), [&id]
+	(auto ret, const auto &pair)
+	{
+		return ret += ticker(*pair.second, id);
+	});
+}
+
 void
 ircd::db::log_rdb_perf_context(const bool &all)
 {
@@ -1320,178 +1752,862 @@ ircd::db::histogram_id(const string_view &key)
 		if(key == pair.second)
 			return pair.first;
 
-	throw std::out_of_range
+	throw std::out_of_range
+	{
+		"No histogram with that key"
+	};
+}
+
+ircd::string_view
+ircd::db::histogram_id(const uint32_t &id)
+{
+	for(const auto &pair : rocksdb::HistogramsNameMap)
+		if(id == pair.first)
+			return pair.second;
+
+	return {};
+}
+
+decltype(ircd::db::histogram_max)
+ircd::db::histogram_max
+{
+	rocksdb::HISTOGRAM_ENUM_MAX
+};
+
+uint64_t
+ircd::db::database::stats::getAndResetTickerCount(const uint32_t type)
+noexcept
+{
+	const auto ret(getTickerCount(type));
+	setTickerCount(type, 0);
+	return ret;
+}
+
+bool
+ircd::db::database::stats::HistEnabledForType(const uint32_t type)
+const noexcept
+{
+	return type < histogram.size();
+}
+
+void
+ircd::db::database::stats::measureTime(const uint32_t type,
+                                       const uint64_t time)
+noexcept
+{
+	switch(type)
+	{
+		case rocksdb::DB_GET:     db::stats::get_time(time);     break;
+		case rocksdb::DB_WRITE:   db::stats::write_time(time);   break;
+		case rocksdb::DB_SEEK:    db::stats::seek_time(time);    break;
+		default:                                                 break;
+	}
+}
+
+void
+ircd::db::database::stats::histogramData(const uint32_t type,
+                                         rocksdb::HistogramData *const data)
+const noexcept
+{
+	assert(data);
+
+	const auto &median(data->median);
+	const auto &percentile95(data->percentile95);
+	const auto &percentile88(data->percentile99);
+	const auto &average(data->average);
+	const auto &standard_deviation(data->standard_deviation);
+}
+
+void
+ircd::db::database::stats::recordTick(const uint32_t type,
+                                      const uint64_t count)
+noexcept
+{
+	ticker.at(type) += count;
+}
+
+void
+ircd::db::database::stats::setTickerCount(const uint32_t type,
+                                          const uint64_t count)
+noexcept
+{
+	ticker.at(type) = count;
+}
+
+uint64_t
+ircd::db::database::stats::getTickerCount(const uint32_t type)
+const noexcept
+{
+	return ticker.at(type);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// database::events
+//
+
+void
+ircd::db::database::events::OnFlushCompleted(rocksdb::DB *const db,
+                                             const rocksdb::FlushJobInfo &info)
+noexcept
+{
+	rog.debug("'%s' @%p: flushed: column[%s] path[%s] tid[%lu] job[%d] writes[slow:%d stop:%d]",
+	          d->name,
+	          db,
+	          info.cf_name,
+	          info.file_path,
+	          info.thread_id,
+	          info.job_id,
+	          info.triggered_writes_slowdown,
+	          info.triggered_writes_stop);
+}
+
+void
+ircd::db::database::events::OnCompactionCompleted(rocksdb::DB *const db,
+                                                  const rocksdb::CompactionJobInfo &info)
+noexcept
+{
+	rog.debug("'%s' @%p: compacted: column[%s] status[%d] tid[%lu] job[%d]",
+	          d->name,
+	          db,
+	          info.cf_name,
+	          int(info.status.code()),
+	          info.thread_id,
+	          info.job_id);
+}
+
+void
+ircd::db::database::events::OnTableFileDeleted(const rocksdb::TableFileDeletionInfo &info)
+noexcept
+{
+	rog.debug("'%s': table file deleted: db[%s] path[%s] status[%d] job[%d]",
+	          d->name,
+	          info.db_name,
+	          info.file_path,
+	          int(info.status.code()),
+	          info.job_id);
+}
+
+void
+ircd::db::database::events::OnTableFileCreated(const rocksdb::TableFileCreationInfo &info)
+noexcept
+{
+	rog.debug("'%s': table file created: db[%s] path[%s] status[%d] job[%d]",
+	          d->name,
+	          info.db_name,
+	          info.file_path,
+	          int(info.status.code()),
+	          info.job_id);
+}
+
+void
+ircd::db::database::events::OnTableFileCreationStarted(const rocksdb::TableFileCreationBriefInfo &info)
+noexcept
+{
+	rog.debug("'%s': table file creating: db[%s] column[%s] path[%s] job[%d]",
+	          d->name,
+	          info.db_name,
+	          info.cf_name,
+	          info.file_path,
+	          info.job_id);
+}
+
+void
+ircd::db::database::events::OnMemTableSealed(const rocksdb::MemTableInfo &info)
+noexcept
+{
+	rog.debug("'%s': memory table sealed: column[%s] entries[%lu] deletes[%lu]",
+	          d->name,
+	          info.cf_name,
+	          info.num_entries,
+	          info.num_deletes);
+}
+
+void
+ircd::db::database::events::OnColumnFamilyHandleDeletionStarted(rocksdb::ColumnFamilyHandle *const h)
+noexcept
+{
+	rog.debug("'%s': column[%s] handle closing @ %p",
+	          d->name,
+	          h->GetName(),
+	          h);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// db/jobs.h
+//
+
+namespace ircd::db::jobs
+{
+	struct task;
+	struct pool;
+	struct compaction_limiter;
+
+	static pool &get(const rocksdb::Env::Priority &);
+	static bool for_each_pool(const std::function<bool (pool &)> &);
+	static void lower_io(const int64_t &level) noexcept;
+	static void reconf() noexcept;
+	static void tune() noexcept;
+	static void tuner() noexcept;
+
+	extern pool flush_pool;
+	extern pool compaction_pool;
+
+	std::atomic<uint64_t> ids;
+	std::shared_ptr<compaction_limiter> rate_limiter;
+	ctx::context tuner_context;
+}
+
+/// The rate limiter given to every database. RocksDB charges flush IO at
+/// IO_HIGH and compaction IO at IO_LOW to the same limiter; only the latter
+/// is throttled here so a slow compaction rate never holds back memtable
+/// relief. A rate of zero lets everything through.
+struct ircd::db::jobs::compaction_limiter
+:rocksdb::RateLimiter
+{
+	std::unique_ptr<rocksdb::RateLimiter> generic;
+	std::atomic<int64_t> rate;
+
+	void SetBytesPerSecond(int64_t bytes_per_second) override;
+	void Request(const int64_t bytes, const rocksdb::Env::IOPriority pri, rocksdb::Statistics *const stats) override;
+	int64_t GetSingleBurstBytes() const override;
+	int64_t GetTotalBytesThrough(const rocksdb::Env::IOPriority pri) const override;
+	int64_t GetTotalRequests(const rocksdb::Env::IOPriority pri) const override;
+	int64_t GetBytesPerSecond() const override;
+
+	compaction_limiter(const int64_t &rate);
+};
+
+/// A job as RocksDB handed it to us.
+struct ircd::db::jobs::task
+{
+	struct job job;
+	void (*func)(void *);
+	void *arg;
+	void *tag;
+	void (*unschedule)(void *);
+};
+
+/// Threads are spawned on demand up to the configured size; a smaller size
+/// takes effect at restart. Remaining tasks are drained before join. The
+/// conf items are only read on the main thread; RocksDB's threads see the
+/// copies in max and level, which reconf() refreshes.
+struct ircd::db::jobs::pool
+{
+	string_view name;
+	conf::item<size_t> &size;
+	conf::item<int64_t> *ioprio;
+	std::atomic<size_t> max {1};
+	std::atomic<int64_t> level {-1};
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<task> queue;
+	std::list<job> running;
+	std::vector<std::thread> threads;
+	bool interruption {false};
+	bool joined {false};
+
+	void worker() noexcept;
+	bool spawn() noexcept;
+
+  public:
+	void schedule(task &&) noexcept;
+	int unschedule(void *const &tag) noexcept;
+	void join() noexcept;
+
+	pool(const string_view &name,
+	     conf::item<size_t> &size,
+	     conf::item<int64_t> *const &ioprio = nullptr);
+};
+
+decltype(ircd::db::jobs::flush_threads)
+ircd::db::jobs::flush_threads
+{
+	{
+		{ "name",     "ircd.db.jobs.flush.threads" },
+		{ "default",  2L                           },
+	},
+	reconf
+};
+
+decltype(ircd::db::jobs::compaction_threads)
+ircd::db::jobs::compaction_threads
+{
+	{
+		{ "name",     "ircd.db.jobs.compaction.threads" },
+		{ "default",  4L                                },
+	},
+	reconf
+};
+
+/// Best-effort IO priority level (0-7) assumed by compaction threads; a
+/// negative value leaves them at the process default. Takes effect for
+/// threads spawned after it is set.
+decltype(ircd::db::jobs::compaction_ioprio)
+ircd::db::jobs::compaction_ioprio
+{
+	{
+		{ "name",     "ircd.db.jobs.compaction.ioprio" },
+		{ "default",  7L                               },
+	},
+	reconf
+};
+
+/// Ceiling of the compaction write rate in bytes per second; 0 disables the
+/// limiter. Setting it resets the current rate to the new ceiling.
+decltype(ircd::db::jobs::rate_max)
+ircd::db::jobs::rate_max
+{
+	{
+		{ "name",     "ircd.db.jobs.rate.max" },
+		{ "default",  ssize_t(256_MiB)        },
+	},
+	reconf
+};
+
+decltype(ircd::db::jobs::rate_min)
+ircd::db::jobs::rate_min
+{
+	{ "name",     "ircd.db.jobs.rate.min" },
+	{ "default",  ssize_t(8_MiB)          },
+};
+
+/// Mean point query latency above which background writes are throttled.
+decltype(ircd::db::jobs::rate_target)
+ircd::db::jobs::rate_target
+{
+	{ "name",     "ircd.db.jobs.rate.target" },
+	{ "default",  2000L                      },
+};
+
+decltype(ircd::db::jobs::rate_interval)
+ircd::db::jobs::rate_interval
+{
+	{ "name",     "ircd.db.jobs.rate.interval" },
+	{ "default",  1000L                        },
+};
+
+decltype(ircd::db::jobs::flush_pool)
+ircd::db::jobs::flush_pool
+{
+	"flush", flush_threads
+};
+
+decltype(ircd::db::jobs::compaction_pool)
+ircd::db::jobs::compaction_pool
+{
+	"compaction", compaction_threads, &compaction_ioprio
+};
+
+bool
+ircd::db::jobs::for_each(const closure &closure)
+{
+	return for_each_pool([&closure](pool &pool)
+	{
+		const std::lock_guard<decltype(pool.mutex)> lock(pool.mutex);
+		for(const auto &job : pool.running)
+			if(!closure(job))
+				return false;
+
+		for(const auto &task : pool.queue)
+			if(!closure(task.job))
+				return false;
+
+		return true;
+	});
+}
+
+size_t
+ircd::db::jobs::threads(const string_view &name)
+{
+	size_t ret(0);
+	for_each_pool([&name, &ret](pool &pool)
+	{
+		const std::lock_guard<decltype(pool.mutex)> lock(pool.mutex);
+		if(!name || pool.name == name)
+			ret += pool.threads.size();
+
+		return true;
+	});
+
+	return ret;
+}
+
+size_t
+ircd::db::jobs::running(const string_view &name)
+{
+	size_t ret(0);
+	for_each_pool([&name, &ret](pool &pool)
+	{
+		const std::lock_guard<decltype(pool.mutex)> lock(pool.mutex);
+		if(!name || pool.name == name)
+			ret += pool.running.size();
+
+		return true;
+	});
+
+	return ret;
+}
+
+size_t
+ircd::db::jobs::queued(const string_view &name)
+{
+	size_t ret(0);
+	for_each_pool([&name, &ret](pool &pool)
+	{
+		const std::lock_guard<decltype(pool.mutex)> lock(pool.mutex);
+		if(!name || pool.name == name)
+			ret += pool.queue.size();
+
+		return true;
+	});
+
+	return ret;
+}
+
+size_t
+ircd::db::jobs::rate()
+{
+	return rate_limiter? size_t(rate_limiter->rate) : 0UL;
+}
+
+//
+// internal
+//
+
+void
+ircd::db::jobs::schedule(const rocksdb::Env::Priority &prio,
+                         const string_view &dbname,
+                         void (*func)(void *),
+                         void *arg,
+                         void *tag,
+                         void (*unschedule)(void *))
+noexcept
+{
+	auto &pool
+	{
+		get(prio)
+	};
+
+	task task;
+	task.job.id = ++ids;
+	task.job.pool = pool.name;
+	task.job.dbname = dbname;
+	task.job.queued = now<steady_point>();
+	task.func = func;
+	task.arg = arg;
+	task.tag = tag;
+	task.unschedule = unschedule;
+	pool.schedule(std::move(task));
+}
+
+int
+ircd::db::jobs::unschedule(const rocksdb::Env::Priority &prio,
+                           void *const &tag)
+noexcept
+{
+	return get(prio).unschedule(tag);
+}
+
+size_t
+ircd::db::jobs::queued(const rocksdb::Env::Priority &prio)
+{
+	auto &pool(get(prio));
+	const std::lock_guard<decltype(pool.mutex)> lock(pool.mutex);
+	return pool.queue.size();
+}
+
+size_t
+ircd::db::jobs::threads(const rocksdb::Env::Priority &prio)
+{
+	// Nothing goes to the bottommost pool while it reports no threads;
+	// RocksDB then keeps those compactions in the LOW pool.
+	if(prio == rocksdb::Env::Priority::BOTTOM)
+		return 0;
+
+	return get(prio).max;
+}
+
+/// The limiter is shared by all databases so the rate applies to the
+/// server's compactions as a whole. It is created with the first database
+/// (in any case, since conf may enable it later) and retuned every interval
+/// by a context comparing the mean point query latency with the target:
+/// above the target the rate is cut by a quarter, otherwise it grows by a
+/// sixteenth of the ceiling.
+std::shared_ptr<rocksdb::RateLimiter>
+ircd::db::jobs::limiter()
+{
+	if(rate_limiter)
+		return rate_limiter;
+
+	// The first database since init; the pools may have been joined by a
+	// previous fini().
+	for_each_pool([](pool &pool)
+	{
+		const std::lock_guard<decltype(pool.mutex)> lock(pool.mutex);
+		pool.joined = false;
+		return true;
+	});
+
+	reconf();
+	rate_limiter = std::make_shared<compaction_limiter>(int64_t(size_t(rate_max)));
+	tuner_context = ctx::context
+	{
+		"db.jobs.tuner", 128_KiB, &tuner, ctx::context::POST
+	};
+
+	return rate_limiter;
+}
+
+void
+ircd::db::jobs::fini()
+noexcept
+{
+	if(tuner_context)
+	{
+		tuner_context.interrupt();
+		tuner_context.join();
+		tuner_context = {};
+	}
+
+	compaction_pool.join();
+	flush_pool.join();
+	rate_limiter.reset();
+}
+
+/// Copy the conf into what the OS threads read, reset the rate to a new
+/// ceiling, and give the open databases the new number of background jobs.
+/// Called on the main thread when any of the items is set.
+void
+ircd::db::jobs::reconf()
+noexcept
+{
+	flush_pool.max = std::max(size_t(flush_threads), 1UL);
+	compaction_pool.max = std::max(size_t(compaction_threads), 1UL);
+	compaction_pool.level = int64_t(compaction_ioprio);
+	if(rate_limiter)
+		rate_limiter->SetBytesPerSecond(int64_t(size_t(rate_max)));
+
+	const std::unordered_map<std::string, std::string> options
+	{
+		{ "max_background_jobs", lex_cast(background_jobs()) }
+	};
+
+	for(const auto &p : database::dbs) try
+	{
+		auto &d(*p.second);
+		if(!d.d)
+			continue;
+
+		throw_on_error
+		{
+			d.d->SetDBOptions(options)
+		};
+	}
+	catch(const std::exception &e)
+	{
+		log.error("'%s': Failed to set the number of background jobs :%s",
+		          p.first,
+		          e.what());
+	}
+}
+
+/// The number of background jobs RocksDB may have scheduled at once. It
+/// divides them between flushes and compactions by itself; our pools still
+/// bound how many of each run.
+int
+ircd::db::jobs::background_jobs()
+{
+	return int(flush_pool.max + compaction_pool.max);
+}
+
+void
+ircd::db::jobs::tuner()
+noexcept try
+{
+	while(1)
+	{
+		ctx::sleep(milliseconds(rate_interval));
+		tune();
+	}
+}
+catch(const ctx::interrupted &)
+{
+	return;
+}
+catch(const ctx::terminated &)
+{
+	return;
+}
+
+void
+ircd::db::jobs::tune()
+noexcept
+{
+	static uint64_t last_count, last_sum;
+	const uint64_t count(stats::get_time.count), sum(stats::get_time.sum);
+	const uint64_t samples(count - last_count), total(sum - last_sum);
+	last_count = count;
+	last_sum = sum;
+
+	const size_t max(rate_max);
+	if(!max || !rate_limiter)
+		return;
+
+	const size_t min
+	{
+		std::max(std::min(size_t(rate_min), max), 1UL)
+	};
+
+	const bool over
 	{
-		"No histogram with that key"
+		samples && microseconds(total / samples) > microseconds(rate_target)
+	};
+
+	const size_t cur(rate_limiter->rate);
+	const size_t next
+	{
+		over?
+			std::max(cur - cur / 4, min):
+			std::min(cur + std::max(max / 16, 1UL), max)
 	};
+
+	if(next != cur)
+		rate_limiter->SetBytesPerSecond(int64_t(next));
 }
 
-ircd::string_view
-ircd::db::histogram_id(const uint32_t &id)
-{
-	for(const auto &pair : rocksdb::HistogramsNameMap)
-		if(id == pair.first)
-			return pair.second;
+//
+// compaction_limiter
+//
 
-	return {};
+ircd::db::jobs::compaction_limiter::compaction_limiter(const int64_t &rate)
+:generic
+{
+	rocksdb::NewGenericRateLimiter(std::max(rate, 1L))
+}
+,rate
+{
+	rate
+}
+{
 }
 
-decltype(ircd::db::histogram_max)
-ircd::db::histogram_max
+void
+ircd::db::jobs::compaction_limiter::SetBytesPerSecond(int64_t bytes_per_second)
 {
-	rocksdb::HISTOGRAM_ENUM_MAX
-};
+	if(bytes_per_second > 0)
+		generic->SetBytesPerSecond(bytes_per_second);
 
-uint64_t
-ircd::db::database::stats::getAndResetTickerCount(const uint32_t type)
-noexcept
+	rate = std::max(bytes_per_second, 0L);
+}
+
+void
+ircd::db::jobs::compaction_limiter::Request(const int64_t bytes,
+                                            const rocksdb::Env::IOPriority pri,
+                                            rocksdb::Statistics *const stats)
 {
-	const auto ret(getTickerCount(type));
-	setTickerCount(type, 0);
-	return ret;
+	if(pri == rocksdb::Env::IO_HIGH || rate <= 0)
+		return;
+
+	generic->Request(bytes, pri, stats);
 }
 
-bool
-ircd::db::database::stats::HistEnabledForType(const uint32_t type)
-const noexcept
+int64_t
+ircd::db::jobs::compaction_limiter::GetSingleBurstBytes()
+const
 {
-	return type < histogram.size();
+	return generic->GetSingleBurstBytes();
 }
 
-void
-ircd::db::database::stats::measureTime(const uint32_t type,
-                                       const uint64_t time)
-noexcept
+int64_t
+ircd::db::jobs::compaction_limiter::GetTotalBytesThrough(const rocksdb::Env::IOPriority pri)
+const
 {
+	return generic->GetTotalBytesThrough(pri);
 }
 
-void
-ircd::db::database::stats::histogramData(const uint32_t type,
-                                         rocksdb::HistogramData *const data)
-const noexcept
+int64_t
+ircd::db::jobs::compaction_limiter::GetTotalRequests(const rocksdb::Env::IOPriority pri)
+const
 {
-	assert(data);
+	return generic->GetTotalRequests(pri);
+}
 
-	const auto &median(data->median);
-	const auto &percentile95(data->percentile95);
-	const auto &percentile88(data->percentile99);
-	const auto &average(data->average);
-	const auto &standard_deviation(data->standard_deviation);
+int64_t
+ircd::db::jobs::compaction_limiter::GetBytesPerSecond()
+const
+{
+	return generic->GetBytesPerSecond();
 }
 
 void
-ircd::db::database::stats::recordTick(const uint32_t type,
-                                      const uint64_t count)
+ircd::db::jobs::lower_io(const int64_t &level)
 noexcept
 {
-	ticker.at(type) += count;
+	#ifdef SYS_ioprio_set
+	static const int IOPRIO_WHO_PROCESS {1};
+	static const int IOPRIO_CLASS_BE {2};
+	static const int IOPRIO_CLASS_SHIFT {13};
+	const int value
+	{
+		(IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | int(std::min(level, 7L))
+	};
+
+	// With who=0 this applies to the calling thread only.
+	syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, value);
+	#endif
 }
 
-void
-ircd::db::database::stats::setTickerCount(const uint32_t type,
-                                          const uint64_t count)
-noexcept
+ircd::db::jobs::pool &
+ircd::db::jobs::get(const rocksdb::Env::Priority &prio)
 {
-	ticker.at(type) = count;
+	switch(prio)
+	{
+		case rocksdb::Env::Priority::HIGH:
+			return flush_pool;
+
+		default:
+			return compaction_pool;
+	}
 }
 
-uint64_t
-ircd::db::database::stats::getTickerCount(const uint32_t type)
-const noexcept
+bool
+ircd::db::jobs::for_each_pool(const std::function<bool (pool &)> &closure)
 {
-	return ticker.at(type);
+	return closure(flush_pool) && closure(compaction_pool);
 }
 
-///////////////////////////////////////////////////////////////////////////////
 //
-// database::events
+// pool
 //
 
-void
-ircd::db::database::events::OnFlushCompleted(rocksdb::DB *const db,
-                                             const rocksdb::FlushJobInfo &info)
-noexcept
+ircd::db::jobs::pool::pool(const string_view &name,
+                           conf::item<size_t> &size,
+                           conf::item<int64_t> *const &ioprio)
+:name{name}
+,size{size}
+,ioprio{ioprio}
 {
-	rog.debug("'%s' @%p: flushed: column[%s] path[%s] tid[%lu] job[%d] writes[slow:%d stop:%d]",
-	          d->name,
-	          db,
-	          info.cf_name,
-	          info.file_path,
-	          info.thread_id,
-	          info.job_id,
-	          info.triggered_writes_slowdown,
-	          info.triggered_writes_stop);
 }
 
 void
-ircd::db::database::events::OnCompactionCompleted(rocksdb::DB *const db,
-                                                  const rocksdb::CompactionJobInfo &info)
+ircd::db::jobs::pool::join()
 noexcept
 {
-	rog.debug("'%s' @%p: compacted: column[%s] status[%d] tid[%lu] job[%d]",
-	          d->name,
-	          db,
-	          info.cf_name,
-	          int(info.status.code()),
-	          info.thread_id,
-	          info.job_id);
+	mutex.lock();
+	interruption = true;
+	joined = true;
+	cond.notify_all();
+	mutex.unlock();
+
+	for(auto &thread : threads)
+		thread.join();
+
+	threads.clear();
+	interruption = false;
 }
 
-void
-ircd::db::database::events::OnTableFileDeleted(const rocksdb::TableFileDeletionInfo &info)
+int
+ircd::db::jobs::pool::unschedule(void *const &tag)
 noexcept
 {
-	rog.debug("'%s': table file deleted: db[%s] path[%s] status[%d] job[%d]",
-	          d->name,
-	          info.db_name,
-	          info.file_path,
-	          int(info.status.code()),
-	          info.job_id);
+	int ret(0);
+	const std::lock_guard<decltype(mutex)> lock(mutex);
+	for(auto it(begin(queue)); it != end(queue); )
+	{
+		if(it->tag != tag)
+		{
+			++it;
+			continue;
+		}
+
+		if(it->unschedule)
+			it->unschedule(it->arg);
+
+		it = queue.erase(it);
+		++ret;
+	}
+
+	return ret;
 }
 
 void
-ircd::db::database::events::OnTableFileCreated(const rocksdb::TableFileCreationInfo &info)
+ircd::db::jobs::pool::schedule(task &&task)
 noexcept
 {
-	rog.debug("'%s': table file created: db[%s] path[%s] status[%d] job[%d]",
-	          d->name,
-	          info.db_name,
-	          info.file_path,
-	          int(info.status.code()),
-	          info.job_id);
+	std::unique_lock<decltype(mutex)> lock(mutex);
+	queue.emplace_back(std::move(task));
+
+	const bool want
+	{
+		threads.size() < max &&
+		threads.size() < running.size() + queue.size()
+	};
+
+	// Once joined no thread is spawned again, since nothing would join it;
+	// as when no thread can be spawned, the job is run here instead so that
+	// RocksDB doesn't wait on it forever.
+	if(joined || (want && !spawn() && threads.empty()))
+	{
+		auto task(std::move(queue.back()));
+		queue.pop_back();
+		lock.unlock();
+		task.func(task.arg);
+		return;
+	}
+
+	cond.notify_one();
 }
 
-void
-ircd::db::database::events::OnTableFileCreationStarted(const rocksdb::TableFileCreationBriefInfo &info)
-noexcept
+bool
+ircd::db::jobs::pool::spawn()
+noexcept try
 {
-	rog.debug("'%s': table file creating: db[%s] column[%s] path[%s] job[%d]",
-	          d->name,
-	          info.db_name,
-	          info.cf_name,
-	          info.file_path,
-	          info.job_id);
+	threads.emplace_back(&pool::worker, this);
+	return true;
 }
-
-void
-ircd::db::database::events::OnMemTableSealed(const rocksdb::MemTableInfo &info)
-noexcept
+catch(const std::exception &e)
 {
-	rog.debug("'%s': memory table sealed: column[%s] entries[%lu] deletes[%lu]",
-	          d->name,
-	          info.cf_name,
-	          info.num_entries,
-	          info.num_deletes);
+	log.critical("Failed to spawn %s thread #%zu: %s",
+	             name,
+	             threads.size(),
+	             e.what());
+
+	return false;
 }
 
 void
-ircd::db::database::events::OnColumnFamilyHandleDeletionStarted(rocksdb::ColumnFamilyHandle *const h)
+ircd::db::jobs::pool::worker()
 noexcept
 {
-	rog.debug("'%s': column[%s] handle closing @ %p",
-	          d->name,
-	          h->GetName(),
-	          h);
+	if(ioprio && level >= 0)
+		lower_io(level);
+
+	std::unique_lock<decltype(mutex)> lock(mutex); while(1)
+	{
+		cond.wait(lock, [this]
+		{
+			return !queue.empty() || interruption;
+		});
+
+		if(queue.empty())
+			return;
+
+		auto task(std::move(queue.front()));
+		queue.pop_front();
+		task.job.started = now<steady_point>();
+		const auto it
+		{
+			running.emplace(end(running), task.job)
+		};
+
+		lock.unlock();
+		stats::job_wait(duration_cast<microseconds>(task.job.started - task.job.queued).count());
+		task.func(task.arg);
+		lock.lock();
+		running.erase(it);
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1815,7 +2931,7 @@ noexcept
 	          u,
 	          reflect(prio));
 
-	return defaults.Schedule(f, a, prio, tag, u);
+	jobs::schedule(prio, d.name, f, a, tag, u);
 }
 
 int
@@ -1828,7 +2944,7 @@ noexcept
 	          tag,
 	          reflect(pri));
 
-	return defaults.UnSchedule(tag, pri);
+	return jobs::unschedule(pri, tag);
 }
 
 void
@@ -1859,7 +2975,7 @@ const noexcept
 	          d.name,
 	          reflect(pri));
 
-	return defaults.GetThreadPoolQueueLen(pri);
+	return jobs::queued(pri);
 }
 
 rocksdb::Status
@@ -1938,7 +3054,7 @@ noexcept
 	          num,
 	          reflect(pri));
 
-	return defaults.SetBackgroundThreads(num, pri);
+	// Pool sizes are governed by ircd.db.jobs.*.threads; see db/jobs.h
 }
 
 void
@@ -1951,7 +3067,7 @@ noexcept
 	          num,
 	          reflect(pri));
 
-	return defaults.IncBackgroundThreadsIfNeeded(num, pri);
+	// Pool sizes are governed by ircd.db.jobs.*.threads; see db/jobs.h
 }
 
 void
@@ -1962,7 +3078,7 @@ noexcept
 	          d.name,
 	          reflect(pool));
 
-	defaults.LowerThreadPoolIOPriority(pool);
+	// Compaction threads lower themselves per ircd.db.jobs.compaction.ioprio
 }
 
 std::string
@@ -1997,7 +3113,7 @@ int
 ircd::db::database::env::GetBackgroundThreads(Priority pri)
 noexcept
 {
-	return defaults.GetBackgroundThreads(pri);
+	return jobs::threads(pri);
 }
 
 //
@@ -3975,6 +5091,32 @@ ircd::db::bytes(const column &column)
 	return cfm.size;
 }
 
+bool
+ircd::db::for_each_compression(const column &column,
+                                const compression_closure &closure)
+{
+	database &d(const_cast<db::column &>(column));
+	database::column &c(const_cast<db::column &>(column));
+	assert(bool(c.handle));
+
+	rocksdb::TablePropertiesCollection tables;
+	throw_on_error
+	{
+		d.d->GetPropertiesOfAllTables(c.handle.get(), &tables)
+	};
+
+	for(const auto &p : tables)
+	{
+		const auto &props(*p.second);
+		const string_view file{p.first};
+		const string_view compression{props.compression_name};
+		if(!closure(file, compression, props.raw_key_size + props.raw_value_size, props.data_size))
+			return false;
+	}
+
+	return true;
+}
+
 size_t
 ircd::db::file_count(const column &column)
 {
@@ -4007,6 +5149,38 @@ ircd::db::describe(const column &column)
 	return describe(c);
 }
 
+/// Rewrite every table file of the column at the bottommost level with the
+/// column's current compression settings. Dictionaries are sampled anew
+/// from the data as it is now. This can take a long time so it is run on
+/// the offload thread.
+void
+ircd::db::recompress(column &column)
+{
+	database::column &c(column);
+	database &d(*c.d);
+	const string_view &compression(c.compression);
+	log::notice
+	{
+		log, "'%s':'%s' @%lu recompressing with %s dict:%zu",
+		name(d),
+		name(c),
+		sequence(d),
+		compression?: "default",
+		size_t(c.compression_dict)
+	};
+
+	rocksdb::CompactRangeOptions opts;
+	opts.exclusive_manual_compaction = false;
+	opts.bottommost_level_compaction = rocksdb::BottommostLevelCompaction::kForce;
+	ctx::ole::offload([&d, &c, &opts]
+	{
+		throw_on_error
+		{
+			d.d->CompactRange(opts, c, nullptr, nullptr)
+		};
+	});
+}
+
 void
 ircd::db::sort(column &column,
                const bool &blocking)
@@ -4816,6 +5990,10 @@ ircd::db::_seek(database::column &c,
 {
 	database &d(*c.d);
 	const ircd::timer timer;
+	const trace::span span
+	{
+		"db.seek"
+	};
 
 	// Start with a non-blocking query.
 	_seek_(*it, p);
@@ -4884,6 +6062,10 @@ ircd::db::_seek(database::column &c,
 {
 	database &d(*c.d);
 	const ircd::timer timer;
+	const trace::span span
+	{
+		"db.seek"
+	};
 	const bool valid_it
 	{
 		valid(*it)
@@ -4979,6 +6161,11 @@ ircd::db::_seek_offload(database::column &c,
 		closure(*blocking_it);
 	}};
 
+	const trace::span span
+	{
+		"db.offload"
+	};
+
 	ctx::offload(function);
 	return blocking_it;
 }
@@ -5038,6 +6225,78 @@ ircd::db::_seek_(rocksdb::Iterator &it,
 // cache.h
 //
 
+decltype(ircd::db::cache_budget)
+ircd::db::cache_budget
+{
+	{
+		{ "name",     "ircd.db.cache.budget" },
+		{ "default",  0L                     },
+	}, []
+	{
+		apply_cache_budget();
+	}
+};
+
+decltype(ircd::db::row_cache_size)
+ircd::db::row_cache_size
+{
+	{
+		{ "name",     "ircd.db.cache.row.size" },
+		{ "default",  ssize_t(16_MiB)          },
+	}, []
+	{
+		apply_row_cache_size();
+	}
+};
+
+/// Set the capacity of every column's caches to its configured size, scaled
+/// down proportionally when the sum exceeds the budget. Each column still has
+/// its own caches; the budget only divides capacity between them, so memory
+/// a quiet column doesn't use is not available to a busy one. Columns opened
+/// without a cache are not affected.
+void
+ircd::db::apply_cache_budget()
+{
+	const auto for_each_column([](const auto &closure)
+	{
+		for(const auto &p : database::dbs)
+			for(const auto &column : p.second->columns)
+				if(column)
+					closure(*column);
+	});
+
+	size_t want(0);
+	for_each_column([&want](database::column &c)
+	{
+		want += size_t(c.cache_size) + size_t(c.cache_size_comp);
+	});
+
+	const size_t budget(cache_budget);
+	const long double scale
+	{
+		budget && want > budget? (long double)budget / want : 1.0L
+	};
+
+	for_each_column([&scale](database::column &c)
+	{
+		capacity(c.table_opts.block_cache.get(), size_t(size_t(c.cache_size) * scale));
+		capacity(c.table_opts.block_cache_compressed.get(), size_t(size_t(c.cache_size_comp) * scale));
+	});
+
+	if(scale < 1.0L)
+		log.debug("Column caches want %zu bytes; scaled by %.3Lf to the budget of %zu",
+		          want,
+		          scale,
+		          budget);
+}
+
+void
+ircd::db::apply_row_cache_size()
+{
+	for(const auto &p : database::dbs)
+		capacity(p.second->cache.get(), size_t(row_cache_size));
+}
+
 void
 ircd::db::for_each(rocksdb::Cache *const &cache,
                    const cache_closure &closure)
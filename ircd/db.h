@@ -10,6 +10,35 @@
 
 #pragma once
 
+/// Metrics for all databases; see ircd::stats. Histograms are fed from
+/// database::stats::measureTime() which may be called on any thread.
+namespace ircd::db::stats
+{
+	extern ircd::stats::histogram get_time;
+	extern ircd::stats::histogram write_time;
+	extern ircd::stats::histogram seek_time;
+	extern ircd::stats::counter cache_hit;
+	extern ircd::stats::counter cache_miss;
+	extern ircd::stats::counter bytes_read;
+	extern ircd::stats::counter bytes_written;
+	extern ircd::stats::histogram job_wait;
+	extern ircd::stats::gauge jobs_queued;
+	extern ircd::stats::gauge jobs_running;
+	extern ircd::stats::gauge jobs_rate;
+}
+
+/// Internal to the background job pools; see jobs.h
+namespace ircd::db::jobs
+{
+	std::shared_ptr<rocksdb::RateLimiter> limiter();
+	int unschedule(const rocksdb::Env::Priority &, void *const &tag) noexcept;
+	void schedule(const rocksdb::Env::Priority &, const string_view &dbname, void (*)(void *), void *, void *tag, void (*)(void *)) noexcept;
+	size_t queued(const rocksdb::Env::Priority &);
+	size_t threads(const rocksdb::Env::Priority &);
+	int background_jobs();
+	void fini() noexcept;
+}
+
 namespace ircd::db
 {
 	struct throw_on_error;
@@ -21,6 +50,31 @@ namespace ircd::db
 	// Dedicated logging facility for rocksdb's log callbacks
 	extern log::log rog;
 
+	// Sum of a ticker over all open databases
+	uint64_t ticker_total(const uint32_t &id);
+
+	// Compression algorithms by the names used in conf and descriptors
+	struct compression
+	{
+		string_view name;
+		rocksdb::CompressionType type;
+		string_view option;          // value for the "compression" option string
+	};
+
+	extern const std::array<compression, 8> compressions;
+	const compression &find_compression(const string_view &name);
+	const compression *select_compression(const string_view &names);
+
+	// Column settings are conf items named by this
+	std::string conf_name(const database::column &, const string_view &key);
+
+	// Set the column's compression dictionary options from conf
+	void apply_compression_dict(database::column &);
+
+	// Resize column caches and row caches of all open databases from conf
+	void apply_cache_budget();
+	void apply_row_cache_size();
+
 	string_view reflect(const rocksdb::Env::Priority &p);
 	string_view reflect(const rocksdb::Env::IOPriority &p);
 	string_view reflect(const rocksdb::RandomAccessFile::AccessPattern &p);
@@ -21,7 +21,7 @@ namespace ircd::fs
 {
 	enum { NAME, PATH };
 	using ent = std::pair<std::string, std::string>;
-	extern const std::array<ent, num_of<index>()> paths;
+	extern std::array<ent, num_of<index>()> paths;
 
 	filesystem::path path(std::string);
 	filesystem::path path(const string_view &);
@@ -499,6 +499,15 @@ catch(const std::out_of_range &e)
 	return nullptr;
 }
 
+/// Override the default path of an element (i.e a tool running against a
+/// temporary database). This must be done before ircd::init().
+void
+ircd::fs::set(const index &index,
+              const string_view &path)
+{
+	std::get<PATH>(paths.at(index)) = std::string{path};
+}
+
 const char *
 ircd::fs::name(index index)
 noexcept try
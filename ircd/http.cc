@@ -8,6 +8,7 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <RB_INC_X86INTRIN_H
 #include <ircd/spirit.h>
 
 namespace ircd::http
@@ -18,6 +19,14 @@ namespace ircd::http
 	struct parser extern const parser;
 
 	extern const std::unordered_map<ircd::http::code, ircd::string_view> reason;
+	extern conf::item<int64_t> fast_parse;
+
+	template<char... c> static const char *_scan_any(const char *, const char *const &);
+	static const char *_scan_ws(const char *, const char *const &);
+	static bool _fast_query(const string_view &);
+	static bool _fast_request_line(const string_view &, line::request &);
+	static bool _fast_response_line(const string_view &, line::response &);
+	static bool _fast_header(const string_view &, header &);
 
 	[[noreturn]] void throw_error(const qi::expectation_failure<const char *> &, const bool &internal = false);
 }
@@ -302,6 +311,8 @@ ircd::http::request::head::head(parse::capstan &pc,
 			this->content_type = h.second;
 		else if(iequals(h.first, "user-agent"_sv))
 			this->user_agent = h.second;
+		else if(iequals(h.first, "accept-encoding"_sv))
+			this->accept_encoding = h.second;
 
 		if(c)
 			c(h);
@@ -398,6 +409,9 @@ ircd::http::response::head::head(parse::capstan &pc,
 		else if(iequals(h.first, "transfer-encoding"s))
 			this->transfer_encoding = h.second;
 
+		else if(iequals(h.first, "content-encoding"s))
+			this->content_encoding = h.second;
+
 		else if(iequals(h.first, "server"s))
 			this->server = h.second;
 
@@ -454,6 +468,9 @@ try
 	if(line.empty())
 		return;
 
+	if(fast_parse && _fast_header(line, *this))
+		return;
+
 	const char *start(line.data());
 	const char *const stop(line.data() + line.size());
 	qi::parse(start, stop, grammar, *this);
@@ -470,6 +487,9 @@ ircd::http::line::response::response(const line &line)
 		eps > parser.response_line
 	};
 
+	if(fast_parse && _fast_response_line(line, *this))
+		return;
+
 	const char *start(line.data());
 	const char *const stop(line.data() + line.size());
 	qi::parse(start, stop, grammar, *this);
@@ -483,6 +503,9 @@ try
 		eps > parser.request_line
 	};
 
+	if(fast_parse && _fast_request_line(line, *this))
+		return;
+
 	const char *start(line.data());
 	const char *const stop(line.data() + line.size());
 	qi::parse(start, stop, grammar, *this);
@@ -503,6 +526,24 @@ ircd::http::line::line(parse::capstan &pc)
 	string_view ret;
 	pc([&ret](const char *&start, const char *const &stop)
 	{
+		// Equivalent to the grammar's line rule: leading whitespace, then
+		// everything up to the first illegal character, which must begin
+		// the CRLF. Failing either way means more must be read.
+		if(fast_parse)
+		{
+			const char *const p(_scan_ws(start, stop));
+			const char *const q(_scan_any<'\0', '\r', '\n'>(p, stop));
+			if(q + 1 >= stop || q[0] != '\r' || q[1] != '\n')
+			{
+				ret = {};
+				return false;
+			}
+
+			ret = string_view{p, q};
+			start = q + 2;
+			return true;
+		}
+
 		if(!qi::parse(start, stop, grammar, ret))
 		{
 			ret = {};
@@ -516,6 +557,226 @@ ircd::http::line::line(parse::capstan &pc)
 {
 }
 
+//
+// Head scanners
+//
+// Every request and federation response head is parsed; these scan the
+// common well-formed case by hand, sixteen bytes at a time for the long
+// runs. When a scanner isn't certain the input is exactly what the grammar
+// would accept it returns false and the grammar parses it instead, so the
+// grammar remains the authority on what is valid and the source of all
+// errors. Nothing is written to the output unless the scan succeeds. Lines
+// are as given by line::line(), without CR, LF or NUL.
+//
+
+decltype(ircd::http::fast_parse)
+ircd::http::fast_parse
+{
+	{ "name",     "ircd.http.parse.fast" },
+	{ "default",  1L                     },
+};
+
+/// Find the next of any of the characters; returns stop if none.
+template<char... c>
+const char *
+ircd::http::_scan_any(const char *p,
+                      const char *const &stop)
+{
+	#if defined(__SSE2__)
+	for(; p + 16 <= stop; p += 16)
+	{
+		const __m128i block
+		{
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))
+		};
+
+		__m128i hit(_mm_setzero_si128());
+		((hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, _mm_set1_epi8(c)))), ...);
+		const uint mask(_mm_movemask_epi8(hit));
+		if(mask)
+			return p + __builtin_ctz(mask);
+	}
+	#endif
+
+	for(; p < stop; ++p)
+		if(((*p == c) || ...))
+			return p;
+
+	return stop;
+}
+
+const char *
+ircd::http::_scan_ws(const char *p,
+                     const char *const &stop)
+{
+	while(p < stop && (*p == ' ' || *p == '\t'))
+		++p;
+
+	return p;
+}
+
+/// True if the grammar's query_string would consume all of the input after
+/// the question mark: '&' separated pairs, each a non-empty key optionally
+/// followed by '=' and a value, none containing '=' or '?' again.
+bool
+ircd::http::_fast_query(const string_view &query)
+{
+	bool key(true), empty(true);
+	for(const char &c : query) switch(c)
+	{
+		case '?':
+			return false;
+
+		case '=':
+			if(!key || empty)
+				return false;
+
+			key = false;
+			continue;
+
+		case '&':
+			if(key && empty)
+				return false;
+
+			key = true;
+			empty = true;
+			continue;
+
+		default:
+			empty = false;
+			continue;
+	}
+
+	return query.empty() || !key || !empty;
+}
+
+/// method SP+ path [?query] [#fragment] SP+ version
+bool
+ircd::http::_fast_request_line(const string_view &line,
+                               line::request &out)
+{
+	const char *p(line.begin()), *q;
+	const char *const stop(line.end());
+	line::request ret;
+
+	q = _scan_any<' ', '\t'>(p, stop);
+	if(q == p || q == stop || *q != ' ')
+		return false;
+
+	ret.method = string_view{p, q};
+	p = q;
+	while(p < stop && *p == ' ')
+		++p;
+
+	q = _scan_any<' ', '\t', '=', '?', '&', '#'>(p, stop);
+	ret.path = string_view{p, q};
+	p = q;
+
+	if(p < stop && *p == '?')
+	{
+		q = _scan_any<' ', '\t', '#'>(p + 1, stop);
+		if(!_fast_query(string_view{p + 1, q}))
+			return false;
+
+		if(q > p + 1)
+			ret.query = string_view{p + 1, q};
+
+		p = q;
+	}
+
+	if(p < stop && *p == '#')
+	{
+		q = _scan_any<' ', '\t'>(p + 1, stop);
+		if(q > p + 1)
+			ret.fragment = string_view{p + 1, q};
+
+		p = q;
+	}
+
+	if(p == stop || *p != ' ')
+		return false;
+
+	while(p < stop && *p == ' ')
+		++p;
+
+	q = _scan_any<' ', '\t'>(p, stop);
+	if(q == p)
+		return false;
+
+	ret.version = string_view{p, q};
+	out = ret;
+	return true;
+}
+
+/// version SP+ status [SP+ reason]
+bool
+ircd::http::_fast_response_line(const string_view &line,
+                                line::response &out)
+{
+	const char *p(line.begin()), *q;
+	const char *const stop(line.end());
+	line::response ret;
+
+	q = _scan_any<' ', '\t'>(p, stop);
+	if(q == p || q == stop || *q != ' ')
+		return false;
+
+	ret.version = string_view{p, q};
+	p = q;
+	while(p < stop && *p == ' ')
+		++p;
+
+	const auto digit{[](const char &c)
+	{
+		return c >= '0' && c <= '9';
+	}};
+
+	if(stop - p < 3 || !digit(p[0]) || !digit(p[1]) || !digit(p[2]))
+		return false;
+
+	ret.status = string_view{p, p + 3};
+	p += 3;
+
+	if(p < stop && *p == ' ')
+	{
+		while(p < stop && *p == ' ')
+			++p;
+
+		if(p < stop)
+			ret.reason = string_view{p, stop};
+	}
+
+	out = ret;
+	return true;
+}
+
+/// key ws* ':' ws* value
+bool
+ircd::http::_fast_header(const string_view &line,
+                         header &out)
+{
+	const char *p(line.begin()), *q;
+	const char *const stop(line.end());
+	header ret;
+
+	q = _scan_any<':', ' ', '\t'>(p, stop);
+	if(q == p || q == stop)
+		return false;
+
+	ret.first = string_view{p, q};
+	p = _scan_ws(q, stop);
+	if(p == stop || *p != ':')
+		return false;
+
+	p = _scan_ws(p + 1, stop);
+	if(p == stop)
+		return false;
+
+	ret.second = string_view{p, stop};
+	out = ret;
+	return true;
+}
+
 ircd::string_view
 ircd::http::query::string::at(const string_view &key)
 const
@@ -8,6 +8,7 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <RB_INC_X86INTRIN_H
 #include <ircd/spirit.h>
 #include <boost/fusion/include/at.hpp>
 
@@ -1335,6 +1336,258 @@ ircd::json::sorted(const object &object)
 	return true;
 }
 
+//
+// object::index
+//
+
+namespace ircd::json
+{
+	template<char... c> static const char *_scan_any(const char *, const char *const &);
+	static const char *_scan_ws(const char *, const char *const &);
+	static const char *_scan_string(const char *, const char *const &);
+	static const char *_scan_nest(const char *, const char *const &);
+	static const char *_scan_value(const char *, const char *const &);
+}
+
+ircd::json::object::index::index(const object &object)
+:source
+{
+	object
+}
+{
+	const char *const start(source.begin()), *const stop(source.end());
+	if(unlikely(ircd::size(source) > std::numeric_limits<uint32_t>::max()))
+		throw parse_error
+		{
+			"Object of %zu bytes is too large to index", ircd::size(source)
+		};
+
+	const auto expect{[&start, &stop]
+	(const char *const &p, const char &c)
+	{
+		if(likely(p < stop && *p == c))
+			return;
+
+		throw parse_error
+		{
+			"Expected '%c' at offset %zu of object", c, size_t(p - start)
+		};
+	}};
+
+	const char *p(_scan_ws(start, stop));
+	expect(p, '{');
+	p = _scan_ws(p + 1, stop);
+	if(p < stop && *p == '}')
+		return;
+
+	while(1)
+	{
+		expect(p, '"');
+		const char *const key(p + 1);
+		p = _scan_string(key, stop);
+		const char *const key_end(p);
+		p = _scan_ws(p + 1, stop);
+		expect(p, ':');
+		p = _scan_ws(p + 1, stop);
+		const char *const val(p);
+		p = _scan_value(p, stop);
+		if(unlikely(p == val))
+			throw parse_error
+			{
+				"Expected value at offset %zu of object", size_t(val - start)
+			};
+
+		idx.emplace_back(entry
+		{
+			uint32_t(key - start), uint32_t(key_end - key),
+			uint32_t(val - start), uint32_t(p - val),
+		});
+
+		p = _scan_ws(p, stop);
+		if(p < stop && *p == ',')
+		{
+			p = _scan_ws(p + 1, stop);
+			continue;
+		}
+
+		expect(p, '}');
+		break;
+	}
+
+	std::stable_sort(idx.begin(), idx.end(), [this]
+	(const entry &a, const entry &b)
+	{
+		return operator()(a).first < operator()(b).first;
+	});
+}
+
+bool
+ircd::json::object::index::for_each(const std::function<bool (const member &)> &closure)
+const
+{
+	for(const auto &entry : idx)
+		if(!closure(operator()(entry)))
+			return false;
+
+	return true;
+}
+
+const ircd::json::object::index::entry *
+ircd::json::object::index::find(const string_view &key)
+const
+{
+	const auto it
+	{
+		std::lower_bound(idx.begin(), idx.end(), key, [this]
+		(const entry &a, const string_view &b)
+		{
+			return operator()(a).first < b;
+		})
+	};
+
+	if(it == idx.end() || operator()(*it).first != key)
+		return nullptr;
+
+	return std::addressof(*it);
+}
+
+/// Find the next of any of the characters; returns stop if none.
+template<char... c>
+const char *
+ircd::json::_scan_any(const char *p,
+                      const char *const &stop)
+{
+	#if defined(__SSE2__)
+	for(; p + 16 <= stop; p += 16)
+	{
+		const __m128i block
+		{
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))
+		};
+
+		__m128i hit(_mm_setzero_si128());
+		((hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, _mm_set1_epi8(c)))), ...);
+		const uint mask(_mm_movemask_epi8(hit));
+		if(mask)
+			return p + __builtin_ctz(mask);
+	}
+	#endif
+
+	for(; p < stop; ++p)
+		if(((*p == c) || ...))
+			return p;
+
+	return stop;
+}
+
+const char *
+ircd::json::_scan_ws(const char *p,
+                     const char *const &stop)
+{
+	while(p < stop && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+		++p;
+
+	return p;
+}
+
+/// Input is after the opening quote; returns the closing quote.
+const char *
+ircd::json::_scan_string(const char *p,
+                         const char *const &stop)
+{
+	while(1)
+	{
+		p = _scan_any<'"', '\\'>(p, stop);
+		if(unlikely(p >= stop))
+			throw parse_error
+			{
+				"Unterminated string in object"
+			};
+
+		if(*p == '"')
+			return p;
+
+		p += 2;
+	}
+}
+
+/// Input is the opening '{' or '['; returns one past its closing match.
+/// Each level's bracket type is kept as a bit to check the closing match.
+const char *
+ircd::json::_scan_nest(const char *p,
+                       const char *const &stop)
+{
+	uint64_t stack(0);
+	uint depth(0);
+	while(1)
+	{
+		p = _scan_any<'"', '{', '}', '[', ']'>(p, stop);
+		if(unlikely(p >= stop))
+			throw parse_error
+			{
+				"Unterminated %s in object", depth && (stack & 1)? "object" : "array"
+			};
+
+		switch(*p)
+		{
+			case '"':
+				p = _scan_string(p + 1, stop) + 1;
+				continue;
+
+			case '{':
+			case '[':
+				if(unlikely(depth >= object::max_recursion_depth))
+					throw recursion_limit
+					{
+						"Exceeded maximum depth of %u while indexing object",
+						object::max_recursion_depth
+					};
+
+				stack = (stack << 1) | (*p == '{');
+				++depth;
+				++p;
+				continue;
+
+			case '}':
+			case ']':
+				if(unlikely((stack & 1) != (*p == '}')))
+					throw parse_error
+					{
+						"Mismatched '%c' in object", *p
+					};
+
+				stack >>= 1;
+				++p;
+				if(--depth == 0)
+					return p;
+
+				continue;
+		}
+	}
+}
+
+/// Returns one past the end of the value; the input if there is no value.
+const char *
+ircd::json::_scan_value(const char *p,
+                        const char *const &stop)
+{
+	if(p >= stop)
+		return p;
+
+	switch(*p)
+	{
+		case '"':
+			return _scan_string(p + 1, stop) + 1;
+
+		case '{':
+		case '[':
+			return _scan_nest(p, stop);
+
+		default:
+			return _scan_any<',', '}', ']', ' ', '\t', '\n', '\r'>(p, stop);
+	}
+}
+
 ircd::json::object::const_iterator &
 ircd::json::object::const_iterator::operator++()
 try
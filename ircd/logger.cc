@@ -38,7 +38,12 @@ namespace ircd::log
 		std::cerr
 	};
 
+	// Serializes the sinks between the writer thread and the main thread.
+	std::mutex sink_mutex;
+
 	static void open(const facility &fac);
+	static void writer_drain() noexcept;
+	static void writer_stop() noexcept;
 }
 
 void
@@ -102,6 +107,7 @@ void
 ircd::log::fini()
 {
 	//remove_top_conf("log");
+	writer_stop();
 	flush();
 	close();
 }
@@ -109,6 +115,7 @@ ircd::log::fini()
 void
 ircd::log::open()
 {
+	const std::lock_guard<decltype(sink_mutex)> lock(sink_mutex);
 	for_each<facility>([](const facility &fac)
 	{
 		if(!fname[fac])
@@ -129,6 +136,7 @@ ircd::log::open()
 void
 ircd::log::close()
 {
+	const std::lock_guard<decltype(sink_mutex)> lock(sink_mutex);
 	for_each<facility>([](const facility &fac)
 	{
 		if(file[fac].is_open())
@@ -139,6 +147,8 @@ ircd::log::close()
 void
 ircd::log::flush()
 {
+	writer_drain();
+	const std::lock_guard<decltype(sink_mutex)> lock(sink_mutex);
 	for_each<facility>([](const facility &fac)
 	{
 		file[fac].flush();
@@ -341,11 +351,44 @@ ircd::log::log::log(const string_view &name,
 
 namespace ircd::log
 {
+	struct record;
+
 	static void check(std::ostream &) noexcept;
+	static void write(const record &) noexcept;
 	static void slog(const log &, const facility &, const window_buffer::closure &) noexcept;
 	static void vlog_threadsafe(const log &, const facility &, const char *const &fmt, const va_rtti &ap);
+
+	static record *ring_next() noexcept;
+	static void ring_push() noexcept;
+	static bool writer_start() noexcept;
 }
 
+/// A log message as it is passed to the writer thread. The user's message
+/// is formatted into it by the caller, because the arguments can't outlive
+/// the call; everything else is left raw for the writer to compose.
+struct ircd::log::record
+{
+	enum sink :uint8_t
+	{
+		CONSOLE_ERR      = 0x01,
+		CONSOLE_OUT      = 0x02,
+		CONSOLE_FLUSH    = 0x04,
+		LOGFILE          = 0x08,
+		LOGFILE_FLUSH    = 0x10,
+	};
+
+	microtime_t time {0, 0};
+	facility fac {INFO};
+	uint8_t sinks {0};
+	uint8_t log_name_len {0};
+	uint8_t ctx_name_len {0};
+	uint16_t msg_len {0};
+	uint64_t ctx_id {0};
+	char log_name[32];
+	char ctx_name[8];
+	char msg[1024 - 80];
+};
+
 decltype(ircd::log::star)
 ircd::log::star
 {
@@ -439,44 +482,112 @@ noexcept
 	// If slog() yields for some reason that's not good either...
 	const ctx::critical_assertion ca;
 
-	// The principal buffer doesn't have to be static but courtesy of all the
-	// above effort we might as well take advantage...
-	static char buf[1024], date[64];
+	// The destinations are decided now rather than by the writer so the
+	// toggles (i.e console_quiet) apply to messages made while they're set.
+	const bool to_console(log.cmasked), to_file(log.fmasked && file[fac].is_open());
+	const uint8_t sinks
+	(
+		(to_console && console_err[fac]?                        record::CONSOLE_ERR : 0) |
+		(to_console && console_out[fac]?                        record::CONSOLE_OUT : 0) |
+		(to_console && console_out[fac] && console_flush[fac]?  record::CONSOLE_FLUSH : 0) |
+		(to_file?                                               record::LOGFILE : 0) |
+		(to_file && file_flush[fac]?                            record::LOGFILE_FLUSH : 0)
+	);
+
+	if(!sinks)
+		return;
+
+	// Without the writer the record is composed in static space and
+	// written out here on the main thread as it always has been.
+	static record sync_record;
+	const bool async_
+	{
+		async && writer_start()
+	};
+
+	record *const rec
+	{
+		async_? ring_next() : &sync_record
+	};
+
+	// The buffer is full; the message is lost rather than blocking.
+	if(!rec)
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	rec->time = microtime();
+	rec->fac = fac;
+	rec->sinks = sinks;
+	rec->ctx_id = ctx::id();
+	rec->log_name_len = copy(rec->log_name, log.name);
+	rec->ctx_name_len = copy(rec->ctx_name, trunc(ctx::name(), sizeof(rec->ctx_name)));
+
+	// Compose the user message
+	window_buffer sb{mutable_buffer{rec->msg}};
+	sb(closure);
+	rec->msg_len = sb.consumed();
+
+	if(!async_)
+	{
+		const std::lock_guard<decltype(sink_mutex)> lock(sink_mutex);
+		write(*rec);
+		return;
+	}
+
+	ring_push();
+
+	// Anything this severe may be the last thing we get to say; it is not
+	// left sitting in the buffer.
+	if(fac == CRITICAL)
+		writer_drain();
+}
+
+/// Compose the line for a record and copy it to its destinations. Called
+/// by the writer thread or by slog() when there is no writer; the caller
+/// holds the sink_mutex.
+void
+ircd::log::write(const record &rec)
+noexcept
+{
+	char buf[2048], date[64];
 
 	// Maximum size of log line leaving 2 characters for \r\n
 	const size_t max(sizeof(buf) - 2);
 
+	const string_view date_str
+	{
+		date, size_t(::snprintf(date, sizeof(date), "%zd.%06d", rec.time.first, rec.time.second))
+	};
+
 	// Compose the prefix sequence into the buffer through stringstream
 	std::stringstream s;
 	pubsetbuf(s, buf);
-	s << microtime(date)
+	s << date_str
 	  << ' '
-	  << (console_ansi[fac]? console_ansi[fac] : "")
+	  << (console_ansi[rec.fac]? console_ansi[rec.fac] : "")
 	  << std::setw(8)
 	  << std::right
-	  << reflect(fac)
-	  << (console_ansi[fac]? "\033[0m " : " ")
-//	  << (log.snote? log.snote : '-')
+	  << reflect(rec.fac)
+	  << (console_ansi[rec.fac]? "\033[0m " : " ")
 	  << std::setw(9)
 	  << std::right
-	  << log.name
+	  << string_view{rec.log_name, rec.log_name_len}
 	  << ' '
 	  << std::setw(8)
-	  << trunc(ctx::name(), 8)
+	  << string_view{rec.ctx_name, rec.ctx_name_len}
 	  << ' '
 	  << std::setw(6)
 	  << std::right
-	  << ctx::id()
+	  << rec.ctx_id
 	  << " :";
 
-	// Compose the user message after prefix
-	const size_t pos(s.tellp());
-	const mutable_buffer userspace{buf + pos, max - pos};
-	window_buffer sb{userspace};
-	sb(closure);
+	// Copy the user message after prefix
+	size_t len(s.tellp());
+	len += copy(mutable_buffer{buf + len, max - len}, string_view{rec.msg, rec.msg_len});
 
 	// Compose the newline after user message.
-	size_t len{pos + sb.consumed()};
 	assert(len + 2 <= sizeof(buf));
 	buf[len++] = '\r';
 	buf[len++] = '\n';
@@ -484,38 +595,203 @@ noexcept
 	// Closure to copy the message to various places
 	assert(len <= sizeof(buf));
 	const string_view msg{buf, len};
-	const auto write{[&msg](std::ostream &s)
+	const auto put{[&msg](std::ostream &s)
 	{
 		check(s);
 		s.write(data(msg), size(msg));
 	}};
 
 	// copy to std::cerr
-	if(log.cmasked && console_err[fac])
+	if(rec.sinks & record::CONSOLE_ERR)
 	{
 		err_console.clear();
-		write(err_console);
+		put(err_console);
 	}
 
 	// copy to std::cout
-	if(log.cmasked && console_out[fac])
+	if(rec.sinks & record::CONSOLE_OUT)
 	{
 		out_console.clear();
-		write(out_console);
-		if(console_flush[fac])
+		put(out_console);
+		if(rec.sinks & record::CONSOLE_FLUSH)
 			std::flush(out_console);
 	}
 
-	// copy to file
-	if(log.fmasked && file[fac].is_open())
+	// copy to file; it may have been closed since the record was made.
+	if((rec.sinks & record::LOGFILE) && file[rec.fac].is_open())
 	{
-		file[fac].clear();
-		write(file[fac]);
-		if(file_flush[fac])
-			std::flush(file[fac]);
+		file[rec.fac].clear();
+		put(file[rec.fac]);
+		if(rec.sinks & record::LOGFILE_FLUSH)
+			std::flush(file[rec.fac]);
+	}
+}
+
+//
+// writer
+//
+
+decltype(ircd::log::async)
+ircd::log::async
+{
+	true
+};
+
+decltype(ircd::log::dropped)
+ircd::log::dropped
+{
+	0
+};
+
+namespace ircd::log
+{
+	// The ring is single-producer (the main thread, which is the only
+	// thread which calls slog()) and single-consumer (the writer thread).
+	// Each side only stores its own index so no lock is needed to pass a
+	// record; the mutex and condition are only for sleeping the writer.
+	constexpr const size_t RING_SIZE {1024};
+	std::array<record, RING_SIZE> ring;
+	std::atomic<size_t> ring_head {0};   // next slot the producer fills
+	std::atomic<size_t> ring_tail {0};   // next slot the consumer writes
+
+	std::mutex writer_mutex;
+	std::condition_variable writer_cond;
+	std::thread *writer_thread;
+	std::atomic<bool> writer_interrupt {false};
+
+	static void writer_worker() noexcept;
+	static void writer_report(const uint64_t &dropped) noexcept;
+}
+
+/// Returns the slot for the next record or nullptr if the ring is full.
+/// The record is not visible to the writer until ring_push().
+ircd::log::record *
+ircd::log::ring_next()
+noexcept
+{
+	const size_t head(ring_head.load(std::memory_order_relaxed));
+	const size_t tail(ring_tail.load(std::memory_order_acquire));
+	if(head - tail >= ring.size())
+		return nullptr;
+
+	return &ring[head % ring.size()];
+}
+
+void
+ircd::log::ring_push()
+noexcept
+{
+	ring_head.fetch_add(1, std::memory_order_release);
+	writer_cond.notify_one();
+}
+
+bool
+ircd::log::writer_start()
+noexcept try
+{
+	if(likely(writer_thread))
+		return true;
+
+	writer_interrupt.store(false, std::memory_order_relaxed);
+	writer_thread = new std::thread(&writer_worker);
+	return true;
+}
+catch(const std::exception &e)
+{
+	fprintf(stderr, "log writer thread failed to start: %s\n", e.what());
+	return false;
+}
+
+/// Wait for the writer to write everything in the ring. This blocks the
+/// main thread; it is for flush() and for messages which can't be lost.
+void
+ircd::log::writer_drain()
+noexcept
+{
+	if(!writer_thread)
+		return;
+
+	const size_t head(ring_head.load(std::memory_order_relaxed));
+	while(ring_tail.load(std::memory_order_acquire) != head)
+	{
+		writer_cond.notify_one();
+		std::this_thread::yield();
+	}
+}
+
+void
+ircd::log::writer_stop()
+noexcept
+{
+	if(!writer_thread)
+		return;
+
+	writer_drain();
+	writer_mutex.lock();
+	writer_interrupt.store(true, std::memory_order_relaxed);
+	writer_cond.notify_one();
+	writer_mutex.unlock();
+	writer_thread->join();
+	delete writer_thread;
+	writer_thread = nullptr;
+}
+
+void
+ircd::log::writer_worker()
+noexcept
+{
+	uint64_t reported(0);
+	while(1)
+	{
+		size_t tail(ring_tail.load(std::memory_order_relaxed));
+		size_t head(ring_head.load(std::memory_order_acquire));
+		if(tail == head)
+		{
+			if(writer_interrupt.load(std::memory_order_relaxed))
+				return;
+
+			// The producer does not take the mutex to notify, so a wakeup
+			// can be missed; the timeout bounds how long that can delay.
+			std::unique_lock<decltype(writer_mutex)> lock(writer_mutex);
+			writer_cond.wait_for(lock, milliseconds(100), [&head]
+			{
+				return ring_head.load(std::memory_order_acquire) != head ||
+				       writer_interrupt.load(std::memory_order_relaxed);
+			});
+
+			continue;
+		}
+
+		const std::lock_guard<decltype(sink_mutex)> lock(sink_mutex);
+		for(; tail != head; ++tail)
+		{
+			write(ring[tail % ring.size()]);
+			ring_tail.store(tail + 1, std::memory_order_release);
+		}
+
+		const auto dropped(ircd::log::dropped.load(std::memory_order_relaxed));
+		if(unlikely(dropped != reported))
+		{
+			writer_report(dropped - reported);
+			reported = dropped;
+		}
 	}
 }
 
+void
+ircd::log::writer_report(const uint64_t &count)
+noexcept
+{
+	record rec;
+	rec.time = microtime();
+	rec.fac = WARNING;
+	rec.sinks = record::CONSOLE_OUT | record::LOGFILE;
+	rec.log_name_len = copy(rec.log_name, star.name);
+	rec.ctx_name_len = copy(rec.ctx_name, "*"_sv);
+	rec.msg_len = ::snprintf(rec.msg, sizeof(rec.msg), "%lu log messages were dropped", count);
+	write(rec);
+}
+
 void
 ircd::log::check(std::ostream &s)
 noexcept try
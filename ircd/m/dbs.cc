@@ -56,6 +56,11 @@ decltype(ircd::m::dbs::state_node)
 ircd::m::dbs::state_node
 {};
 
+/// Linkage for a reference to the id_intern column.
+decltype(ircd::m::dbs::id_intern)
+ircd::m::dbs::id_intern
+{};
+
 //
 // init
 //
@@ -87,6 +92,7 @@ ircd::m::dbs::init::init(std::string dbopts)
 	room_joined = db::index{*events, desc::events__room_joined.name};
 	room_state = db::index{*events, desc::events__room_state.name};
 	state_node = db::column{*events, desc::events__state_node.name};
+	id_intern = db::column{*events, desc::events__id_intern.name};
 }
 
 /// Shuts down the m::dbs subsystem; closes the events database. The extern
@@ -553,6 +559,15 @@ ircd::m::dbs::state_root(const mutable_buffer &out,
 // Database descriptors
 //
 
+// Compression for the columns with a dictionary, in order of preference;
+// the first which RocksDB supports is used. A dictionary only works with
+// zlib, lz4 and zstd; RocksDB's default is snappy which ignores it.
+static const char *const
+dict_compression
+{
+	"zstd;lz4;zlib"
+};
+
 const ircd::database::descriptor
 ircd::m::dbs::desc::events__event_idx
 {
@@ -582,10 +597,10 @@ ircd::m::dbs::desc::events__event_idx
 	{},
 
 	// cache size
-	96_MiB, //TODO: conf
+	96_MiB,
 
 	// cache size for compressed assets
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// bloom filter bits
 	16,
@@ -633,10 +648,10 @@ ircd::m::dbs::desc::events__event_bad
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	16,
@@ -734,10 +749,10 @@ ircd::m::dbs::desc::events__room_head
 	events__room_head__pfx,
 
 	// cache size
-	32_MiB, //TODO: conf
+	32_MiB,
 
 	// cache size for compressed assets
-	0, //TODO: conf
+	0,
 
 	// bloom filter bits
 	0,
@@ -961,10 +976,10 @@ ircd::m::dbs::desc::events__room_events
 	events__room_events__pfx,
 
 	// cache size
-	64_MiB, //TODO: conf
+	64_MiB,
 
 	// cache size for compressed assets
-	24_MiB, //TODO: conf
+	24_MiB,
 
 	// bloom filter bits
 	0, // no bloom filter because of possible comparator issues
@@ -1072,10 +1087,10 @@ ircd::m::dbs::desc::events__room_joined
 	events__room_joined__pfx,
 
 	// cache size
-	64_MiB, //TODO: conf
+	64_MiB,
 
 	// cache size for compressed assets
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// bloom filter bits
 	10,
@@ -1181,10 +1196,10 @@ ircd::m::dbs::desc::events__room_state
 	events__room_state__pfx,
 
 	// cache size
-	128_MiB, //TODO: conf
+	128_MiB,
 
 	// cache size for compressed assets
-	32_MiB, //TODO: conf
+	32_MiB,
 
 	// bloom filter bits
 	16,
@@ -1223,10 +1238,10 @@ ircd::m::dbs::desc::events__state_node
 	{},
 
 	// cache size
-	96_MiB, //TODO: conf
+	96_MiB,
 
 	// cache size for compressed assets
-	24_MiB, //TODO: conf
+	24_MiB,
 
 	// bloom filter bits
 	12,
@@ -1235,6 +1250,91 @@ ircd::m::dbs::desc::events__state_node
 	true,
 };
 
+//
+// id_intern
+//
+
+ircd::string_view
+ircd::m::dbs::id_intern_key(const mutable_buffer &out_,
+                            const uint64_t &handle)
+{
+	// The handle is stored big-endian so the reverse keys sort numerically
+	// and the last one in the column is the last handle assigned.
+	const uint64_t handle_be
+	{
+		bswap(handle)
+	};
+
+	const const_buffer handle_cb
+	{
+		reinterpret_cast<const char *>(&handle_be), sizeof(handle_be)
+	};
+
+	mutable_buffer out{out_};
+	consume(out, copy(out, "\xFF"_sv));
+	consume(out, copy(out, handle_cb));
+	return { data(out_), data(out) };
+}
+
+uint64_t
+ircd::m::dbs::id_intern_key(const string_view &amalgam)
+{
+	assert(size(amalgam) == 1 + 8);
+	assert(uint8_t(amalgam.front()) == 0xFF);
+
+	uint64_t handle_be;
+	memcpy(&handle_be, data(amalgam) + 1, sizeof(handle_be));
+	return bswap(handle_be);
+}
+
+/// Interned identifiers. Two kinds of keys share this column. The forward
+/// key is the identifier itself and the value is its handle. The reverse
+/// key is a 0xFF byte followed by the big-endian handle and the value is
+/// the identifier. No identifier begins with 0xFF so all reverse keys sort
+/// after all forward keys. see: m/intern.h
+///
+const ircd::database::descriptor
+ircd::m::dbs::desc::events__id_intern
+{
+	// name
+	"_id_intern",
+
+	// explanation
+	R"(### developer note:
+
+	The key is either an identifier, in which case the value is its handle;
+	or the key is 0xFF followed by a big-endian handle, in which case the
+	value is the identifier.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(ircd::string_view), typeid(ircd::string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// cache size
+	16_MiB,
+
+	// cache size for compressed assets
+	8_MiB,
+
+	// bloom filter bits
+	16,
+
+	// expect queries hit
+	false,
+};
+
 //
 // Direct column descriptors
 //
@@ -1273,10 +1373,10 @@ ircd::m::dbs::desc::events_event_id
 	{},
 
 	// cache size
-	32_MiB, //TODO: conf
+	32_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1320,10 +1420,10 @@ ircd::m::dbs::desc::events_type
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1367,16 +1467,25 @@ ircd::m::dbs::desc::events_content
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
 
 	// expect queries hit
 	true,
+
+	// block size
+	0,
+
+	// compression
+	dict_compression,
+
+	// compression dictionary size
+	16_KiB,
 };
 
 const ircd::database::descriptor
@@ -1408,10 +1517,10 @@ ircd::m::dbs::desc::events_redacts
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1454,10 +1563,10 @@ ircd::m::dbs::desc::events_room_id
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1500,10 +1609,10 @@ ircd::m::dbs::desc::events_sender
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1548,10 +1657,10 @@ ircd::m::dbs::desc::events_state_key
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1591,10 +1700,10 @@ ircd::m::dbs::desc::events_origin
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1638,10 +1747,10 @@ ircd::m::dbs::desc::events_origin_server_ts
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1679,16 +1788,25 @@ ircd::m::dbs::desc::events_signatures
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
 
 	// expect queries hit
 	true,
+
+	// block size
+	0,
+
+	// compression
+	dict_compression,
+
+	// compression dictionary size
+	8_KiB,
 };
 
 const ircd::database::descriptor
@@ -1719,16 +1837,25 @@ ircd::m::dbs::desc::events_auth_events
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
 
 	// expect queries hit
 	false,
+
+	// block size
+	0,
+
+	// compression
+	dict_compression,
+
+	// compression dictionary size
+	8_KiB,
 };
 
 const ircd::database::descriptor
@@ -1759,10 +1886,10 @@ ircd::m::dbs::desc::events_depth
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1799,16 +1926,25 @@ ircd::m::dbs::desc::events_hashes
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
 
 	// expect queries hit
 	true,
+
+	// block size
+	0,
+
+	// compression
+	dict_compression,
+
+	// compression dictionary size
+	8_KiB,
 };
 
 const ircd::database::descriptor
@@ -1839,10 +1975,10 @@ ircd::m::dbs::desc::events_membership
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -1879,16 +2015,25 @@ ircd::m::dbs::desc::events_prev_events
 	{},
 
 	// cache size
-	16_MiB, //TODO: conf
+	16_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
 
 	// expect queries hit
 	true,
+
+	// block size
+	0,
+
+	// compression
+	dict_compression,
+
+	// compression dictionary size
+	8_KiB,
 };
 
 const ircd::database::descriptor
@@ -1919,10 +2064,10 @@ ircd::m::dbs::desc::events_prev_state
 	{},
 
 	// cache size
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// cache size for compressed assets
-	8_MiB, //TODO: conf
+	8_MiB,
 
 	// bloom filter bits
 	12,
@@ -2035,6 +2180,10 @@ ircd::m::dbs::desc::events
 	// Mapping of state tree node id to node data.
 	events__state_node,
 
+	// (id) => (handle)
+	// (0xFF, handle) => (id)
+	// Bidirectional mapping of interned identifiers to their handle.
+	events__id_intern,
 
 	events__event_bad,
 	events__room_head,
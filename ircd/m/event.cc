@@ -622,6 +622,14 @@ ircd::m::event::hash(json::iov &event,
 	return m::hash(event);
 }
 
+// The preimages for hashing and signing are printed by the sorted-tuple
+// fast path of json::stringify() which requires this.
+static_assert
+(
+	ircd::json::sorted_keys<ircd::m::event>(),
+	"m::event properties must be declared in lexical order of their keys."
+);
+
 ircd::sha256::buf
 ircd::m::hash(const event &event)
 {
@@ -15,6 +15,9 @@ namespace ircd::m
 	using namespace ircd::spirit;
 
 	[[noreturn]] void failure(const qi::expectation_failure<const char *> &, const string_view &);
+
+	extern conf::item<int64_t> id_fast_parse;
+	static bool _fast_mxid(const string_view &, const char *&colon, const char *&host_end, const char *&end);
 }
 
 template<class it>
@@ -252,6 +255,11 @@ const try
 		,"sigil type"
 	};
 
+	const char *colon, *host_end, *end;
+	if(id_fast_parse && !id.empty() && id[0] == sigil)
+		if(_fast_mxid(id, colon, host_end, end))
+			return string_view{id.begin(), end};
+
 	const rule<string_view> view_mxid
 	{
 		raw[eps > (sigil_type > mxid)]
@@ -277,6 +285,10 @@ ircd::string_view
 ircd::m::id::parser::operator()(const string_view &id)
 const try
 {
+	const char *colon, *host_end, *end;
+	if(id_fast_parse && _fast_mxid(id, colon, host_end, end))
+		return string_view{id.begin(), end};
+
 	static const rule<string_view> view_mxid
 	{
 		raw[eps > mxid]
@@ -310,6 +322,10 @@ void
 ircd::m::id::validator::operator()(const string_view &id)
 const try
 {
+	const char *colon, *host_end, *end;
+	if(id_fast_parse && _fast_mxid(id, colon, host_end, end))
+		return;
+
 	const char *start{id.begin()};
 	const char *const stop
 	{
@@ -335,6 +351,11 @@ const try
 		,"sigil type"
 	};
 
+	const char *colon, *host_end, *end;
+	if(id_fast_parse && !id.empty() && id[0] == sigil)
+		if(_fast_mxid(id, colon, host_end, end))
+			return;
+
 	const rule<> valid_mxid
 	{
 		eps > (sigil_type > mxid)
@@ -354,6 +375,134 @@ catch(const qi::expectation_failure<const char *> &e)
 	failure(e, reflect(sigil));
 }
 
+//
+// Fast path
+//
+// Nearly every ID has the shape `sigil localpart:hostname[:port]` and is
+// scanned by hand with a character class table. Anything else, including
+// IP literals and anything invalid, is left to the grammar: the scan only
+// answers when the grammar would give the same answer, so the grammar's
+// errors are unchanged.
+//
+
+decltype(ircd::m::id_fast_parse)
+ircd::m::id_fast_parse
+{
+	{ "name",     "ircd.m.id.parse.fast" },
+	{ "default",  1L                     },
+};
+
+namespace ircd::m
+{
+	enum id_class :uint8_t
+	{
+		ID_USER   = 0x01,    // user_id localpart character
+		ID_LABEL  = 0x02,    // hostname label character
+		ID_ALNUM  = 0x04,    // hostname label leading character
+		ID_ALPHA  = 0x08,    // hostname leading character (not an IPv4)
+	};
+
+	static const std::array<uint8_t, 256> id_class_table
+	{[]
+	{
+		std::array<uint8_t, 256> ret {{0}};
+		for(size_t i(0); i < ret.size(); ++i)
+		{
+			const char c(i);
+			const char *start(&c), *const stop(&c + 1);
+			if(qi::parse(start, stop, id::parser.user_id_char))
+				ret[i] |= ID_USER;
+
+			if(std::isalpha(i))
+				ret[i] |= ID_ALPHA | ID_ALNUM | ID_LABEL;
+
+			if(std::isdigit(i))
+				ret[i] |= ID_ALNUM | ID_LABEL;
+
+			if(c == '-')
+				ret[i] |= ID_LABEL;
+		}
+
+		return ret;
+	}()};
+}
+
+/// Scan an ID, truncated to MAX_SIZE like the grammar. On success colon is
+/// the separator following the localpart, host_end is the end of the
+/// hostname and end is the end of the whole mxid (after any port); the
+/// grammar may have stopped short of the end of the input as well.
+bool
+ircd::m::_fast_mxid(const string_view &id,
+                    const char *&colon,
+                    const char *&host_end,
+                    const char *&end)
+{
+	const auto &table(id_class_table);
+	const char *p(id.begin());
+	const char *const stop
+	{
+		std::min(id.end(), p + id::MAX_SIZE)
+	};
+
+	if(p == stop)
+		return false;
+
+	if(*p == id::USER)
+	{
+		const char *const start(++p);
+		while(p < stop && table[uint8_t(*p)] & ID_USER)
+			++p;
+
+		if(p == start)
+			return false;
+	}
+	else if(is_sigil(*p))
+		p = std::find(p + 1, stop, ':');
+	else
+		return false;
+
+	if(p == stop)
+		return false;
+
+	assert(*p == ':' || *id.begin() == id::USER);
+	if(*p != ':')
+		return false;
+
+	colon = p++;
+
+	// The grammar tries a leading digit as an IPv4 literal first.
+	if(p == stop || ~table[uint8_t(*p)] & ID_ALPHA)
+		return false;
+
+	// hostlabel % '.'; a dot only continues when a label follows it.
+	while(1)
+	{
+		for(++p; p < stop && table[uint8_t(*p)] & ID_LABEL; ++p);
+		if(p + 1 < stop && *p == '.' && table[uint8_t(p[1])] & ID_ALNUM)
+		{
+			++p;
+			continue;
+		}
+
+		break;
+	}
+
+	host_end = p;
+	if(p < stop && *p == ':')
+	{
+		const char *const digits(++p);
+		uint32_t port(0);
+		for(; p < stop && p - digits < 5 && *p >= '0' && *p <= '9'; ++p)
+			port = port * 10 + (*p - '0');
+
+		if(p == digits || port > 65535 || (p < stop && *p >= '0' && *p <= '9'))
+			return false;
+	}
+
+	end = p;
+	return true;
+}
+
 //TODO: abstract this pattern with ircd::json::printer in ircd/spirit.h
 struct ircd::m::id::printer
 :output<const char *>
@@ -533,6 +682,12 @@ uint16_t
 ircd::m::id::port()
 const
 {
+	const char *colon, *host_end, *stop;
+	if(id_fast_parse && _fast_mxid(*this, colon, host_end, stop))
+		return host_end < stop?
+			lex_cast<uint16_t>(string_view{host_end + 1, stop}):
+			uint16_t(0);
+
 	static const parser::rule<uint16_t> rule
 	{
 		omit[parser.prefix >> ':' >> parser.dns_name >> ':'] >> parser.port
@@ -553,6 +708,10 @@ ircd::string_view
 ircd::m::id::hostname()
 const
 {
+	const char *colon, *host_end, *stop;
+	if(id_fast_parse && _fast_mxid(*this, colon, host_end, stop))
+		return string_view{colon + 1, host_end};
+
 	static const parser::rule<string_view> dns_name
 	{
 		parser.dns_name
@@ -589,6 +748,10 @@ ircd::string_view
 ircd::m::id::host()
 const
 {
+	const char *colon, *host_end, *stop;
+	if(id_fast_parse && _fast_mxid(*this, colon, host_end, stop))
+		return string_view{colon + 1, stop};
+
 	static const parser::rule<string_view> server_name
 	{
 		parser.server_name
@@ -615,6 +778,10 @@ ircd::string_view
 ircd::m::id::local()
 const
 {
+	const char *colon, *host_end, *stop;
+	if(id_fast_parse && _fast_mxid(*this, colon, host_end, stop))
+		return string_view{begin(), colon};
+
 	static const parser::rule<string_view> prefix
 	{
 		parser.prefix
@@ -719,9 +886,20 @@ bool
 ircd::m::is_sigil(const char &c)
 noexcept
 {
-	const char *start{&c};
-	const char *const stop{start + 1};
-	return qi::parse(start, stop, id::parser.sigil);
+	switch(c)
+	{
+		case id::EVENT:
+		case id::USER:
+		case id::ROOM:
+		case id::ROOM_ALIAS:
+		case id::GROUP:
+		case id::NODE:
+		case id::DEVICE:
+			return true;
+
+		default:
+			return false;
+	}
 }
 
 enum ircd::m::id::sigil
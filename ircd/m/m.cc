@@ -391,6 +391,55 @@ decltype(ircd::m::vm::eval::id_ctr)
 ircd::m::vm::eval::id_ctr
 {};
 
+//
+// stats
+//
+
+decltype(ircd::m::vm::stats::evals)
+ircd::m::vm::stats::evals
+{
+	"ircd.m.vm.evals",
+	"Evaluations started since startup.",
+	[] { return eval::id_ctr; }
+};
+
+decltype(ircd::m::vm::stats::evaluating)
+ircd::m::vm::stats::evaluating
+{
+	"ircd.m.vm.evaluating",
+	"Evaluations currently in progress.",
+	[] { return int64_t(eval::list.size()); }
+};
+
+decltype(ircd::m::vm::stats::sequence)
+ircd::m::vm::stats::sequence
+{
+	"ircd.m.vm.sequence",
+	"Sequence number of the last event committed.",
+	[] { return int64_t(current_sequence); }
+};
+
+decltype(ircd::m::vm::stats::accepts)
+ircd::m::vm::stats::accepts
+{
+	"ircd.m.vm.accepts",
+	"Events accepted by evaluation.",
+};
+
+decltype(ircd::m::vm::stats::faults)
+ircd::m::vm::stats::faults
+{
+	"ircd.m.vm.faults",
+	"Evaluations ending in any fault.",
+};
+
+decltype(ircd::m::vm::stats::accept_time)
+ircd::m::vm::stats::accept_time
+{
+	"ircd.m.vm.accept_time_us",
+	"Microseconds to evaluate an event which was accepted.",
+};
+
 //
 // Eval
 //
@@ -1193,13 +1242,34 @@ ircd::m::my(const node &node)
 // node
 //
 
+namespace ircd::m
+{
+	using node_key_closure = std::function<void (const string_view &, const time_t &)>;
+
+	static void node_key(const node &, const string_view &key_id, const node_key_closure &);
+}
+
 void
 ircd::m::node::key(const string_view &key_id,
                    const ed25519_closure &closure)
 const
 {
-	key(key_id, key_closure{[&closure]
-	(const string_view &keyb64)
+	key(key_id, ed25519_valid_closure{[&closure]
+	(const ed25519::pk &pk, const time_t &valid_until)
+	{
+		closure(pk);
+	}});
+}
+
+/// The key and when the origin says it expires, in seconds since the epoch;
+/// zero if it didn't say.
+void
+ircd::m::node::key(const string_view &key_id,
+                   const ed25519_valid_closure &closure)
+const
+{
+	node_key(*this, key_id, [&closure]
+	(const string_view &keyb64, const time_t &valid_until)
 	{
 		const ed25519::pk pk
 		{
@@ -1209,18 +1279,30 @@ const
 			}
 		};
 
-		closure(pk);
-	}});
+		closure(pk, valid_until);
+	});
 }
 
 void
 ircd::m::node::key(const string_view &key_id,
                    const key_closure &closure)
 const
+{
+	node_key(*this, key_id, [&closure]
+	(const string_view &keyb64, const time_t &valid_until)
+	{
+		closure(keyb64);
+	});
+}
+
+void
+ircd::m::node_key(const node &node,
+                  const string_view &key_id,
+                  const node_key_closure &closure)
 {
 	const auto &server_name
 	{
-		node_id.hostname()
+		node.node_id.hostname()
 	};
 
 	m::keys::get(server_name, key_id, [&closure, &key_id]
@@ -1241,7 +1323,7 @@ const
 			vkk.at("key")
 		};
 
-		closure(key);
+		closure(key, keys.get<time_t>("valid_until_ts", 0) / 1000);
 	});
 }
 
@@ -1290,6 +1372,364 @@ ircd::m::node::room::room(const m::node &node)
 	static_cast<m::room &>(*this) = room_id;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// m/intern.h
+//
+
+namespace ircd::m::intern
+{
+	struct entry;
+
+	static void remember(const handle &, const string_view &id);
+	static void touch(entry &);
+	static handle last();
+
+	// handle => id; the strings are never moved once inserted so the
+	// forward map keys on views of them.
+	static std::map<handle, entry> reverse;
+	static std::map<string_view, handle> forward;
+	static std::list<handle> lru;              // least recent first
+}
+
+struct ircd::m::intern::entry
+{
+	std::string id;
+	decltype(lru)::iterator lru_it;
+};
+
+decltype(ircd::m::intern::cache_max)
+ircd::m::intern::cache_max
+{
+	{ "name",     "ircd.m.intern.cache_max" },
+	{ "default",   262144L                  },
+};
+
+decltype(ircd::m::intern::head)
+ircd::m::intern::head
+{0};
+
+ircd::m::intern::handle
+ircd::m::intern::set(const string_view &id)
+{
+	db::txn txn
+	{
+		*dbs::events
+	};
+
+	bool assigned{false};
+	const auto ret
+	{
+		set(txn, id, assigned)
+	};
+
+	if(!assigned)
+		return ret;
+
+	const unwind::exceptional abandon{[&ret]
+	{
+		forget(ret);
+	}};
+
+	txn();
+	return ret;
+}
+
+/// A new assignment is appended to the caller's txn and held in the table
+/// until the txn is committed; if it is abandoned the caller must forget()
+/// the handle. This may yield for the lookup, so it is called ahead of the
+/// indexers (which may not) to intern the identifiers for an event in the
+/// same txn as the event.
+ircd::m::intern::handle
+ircd::m::intern::set(db::txn &txn,
+                     const string_view &id,
+                     bool &assigned)
+{
+	assert(!empty(id));
+	assert(size(id) <= id::MAX_SIZE);
+	assert(uint8_t(id.front()) != 0xFF);
+	if(unlikely(empty(id) || size(id) > id::MAX_SIZE))
+		throw m::BAD_REQUEST
+		{
+			"Cannot intern identifier of %zu bytes", size(id)
+		};
+
+	assigned = false;
+	const auto existing
+	{
+		find(std::nothrow, id)
+	};
+
+	if(existing)
+		return existing;
+
+	// Another context may have loaded the head concurrently; the greater
+	// value is always the correct one.
+	if(!head)
+		head = std::max(head, last());
+
+	// The lookups may have yielded to the database; another context may have
+	// assigned this identifier in the meantime.
+	const auto it
+	{
+		forward.find(id)
+	};
+
+	if(it != end(forward))
+		return it->second;
+
+	// Nothing yields from here until the handle is in the table, which is
+	// what serializes assignment between contexts.
+	const handle ret
+	{
+		++head
+	};
+
+	remember(ret, id);
+	char keybuf[dbs::ID_INTERN_KEY_MAX_SIZE];
+	const string_view reverse_key
+	{
+		dbs::id_intern_key(keybuf, ret)
+	};
+
+	db::txn::append
+	{
+		txn, dbs::id_intern,
+		{
+			db::op::SET, id, byte_view<string_view>(ret)
+		}
+	};
+
+	db::txn::append
+	{
+		txn, dbs::id_intern,
+		{
+			db::op::SET, reverse_key, id
+		}
+	};
+
+	assigned = true;
+	return ret;
+}
+
+/// Drop an assignment whose txn was not committed. The handle is never given
+/// out again: until now it was visible to other contexts, which may hold it.
+void
+ircd::m::intern::forget(const handle &handle)
+{
+	const auto it
+	{
+		reverse.find(handle)
+	};
+
+	if(it == end(reverse))
+		return;
+
+	forward.erase(string_view{it->second.id});
+	lru.erase(it->second.lru_it);
+	reverse.erase(it);
+}
+
+ircd::m::intern::handle
+ircd::m::intern::find(const string_view &id)
+{
+	const auto ret
+	{
+		find(std::nothrow, id)
+	};
+
+	if(!ret)
+		throw m::NOT_FOUND
+		{
+			"Identifier '%s' is not interned", id
+		};
+
+	return ret;
+}
+
+ircd::m::intern::handle
+ircd::m::intern::find(std::nothrow_t,
+                      const string_view &id)
+{
+	const auto it
+	{
+		forward.find(id)
+	};
+
+	if(it != end(forward))
+	{
+		touch(reverse.at(it->second));
+		return it->second;
+	}
+
+	handle ret{0};
+	dbs::id_intern(id, std::nothrow, [&ret]
+	(const string_view &value)
+	{
+		ret = byte_view<handle>(value);
+	});
+
+	if(ret)
+		remember(ret, id);
+
+	return ret;
+}
+
+std::string
+ircd::m::intern::get(const handle &handle)
+{
+	std::string ret;
+	get(handle, [&ret](const string_view &id)
+	{
+		ret = std::string{id};
+	});
+
+	return ret;
+}
+
+ircd::string_view
+ircd::m::intern::get(const mutable_buffer &out,
+                     const handle &handle)
+{
+	string_view ret;
+	get(handle, [&out, &ret](const string_view &id)
+	{
+		ret = { data(out), copy(out, id) };
+	});
+
+	return ret;
+}
+
+void
+ircd::m::intern::get(const handle &handle,
+                     const closure &closure)
+{
+	if(!get(std::nothrow, handle, closure))
+		throw m::NOT_FOUND
+		{
+			"Interned handle %lu not found", handle
+		};
+}
+
+bool
+ircd::m::intern::get(std::nothrow_t,
+                     const handle &handle,
+                     const closure &closure)
+{
+	const auto it
+	{
+		reverse.find(handle)
+	};
+
+	if(it != end(reverse))
+	{
+		touch(it->second);
+		closure(string_view{it->second.id});
+		return true;
+	}
+
+	char keybuf[dbs::ID_INTERN_KEY_MAX_SIZE];
+	const string_view key
+	{
+		dbs::id_intern_key(keybuf, handle)
+	};
+
+	std::string id;
+	const bool found
+	{
+		dbs::id_intern(key, std::nothrow, [&id]
+		(const string_view &value)
+		{
+			id = std::string{value};
+		})
+	};
+
+	if(!found)
+		return false;
+
+	remember(handle, string_view{id});
+	closure(string_view{id});
+	return true;
+}
+
+size_t
+ircd::m::intern::cached()
+{
+	assert(forward.size() == reverse.size());
+	return reverse.size();
+}
+
+void
+ircd::m::intern::clear()
+{
+	forward.clear();
+	reverse.clear();
+	lru.clear();
+}
+
+/// Add a mapping to the in-memory table. The table is only a cache of the
+/// column; when it reaches the limit the least recently used mapping is
+/// dropped.
+void
+ircd::m::intern::remember(const handle &handle,
+                          const string_view &id)
+{
+	const auto it
+	{
+		reverse.find(handle)
+	};
+
+	if(it != end(reverse))
+		return touch(it->second);
+
+	while(!lru.empty() && reverse.size() >= size_t(cache_max))
+	{
+		const auto victim
+		{
+			reverse.find(lru.front())
+		};
+
+		assert(victim != end(reverse));
+		forward.erase(string_view{victim->second.id});
+		reverse.erase(victim);
+		lru.pop_front();
+	}
+
+	auto &entry
+	{
+		reverse.emplace(handle, intern::entry{std::string{id}}).first->second
+	};
+
+	entry.lru_it = lru.emplace(end(lru), handle);
+	forward.emplace(entry.id, handle);
+}
+
+void
+ircd::m::intern::touch(entry &entry)
+{
+	lru.splice(end(lru), lru, entry.lru_it);
+}
+
+/// The last handle assigned is the last reverse key in the column.
+ircd::m::intern::handle
+ircd::m::intern::last()
+{
+	auto &column
+	{
+		dbs::id_intern
+	};
+
+	const auto it
+	{
+		column.rbegin()
+	};
+
+	if(!it || uint8_t(it->first.front()) != 0xFF)
+		return 0;
+
+	return dbs::id_intern_key(it->first);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // m/events.h
@@ -1696,6 +2136,18 @@ ircd::m::user::tokens
 	tokens_room_id
 };
 
+/// Singleton instance of the access token cache.
+decltype(ircd::m::user::token_cache)
+ircd::m::user::token_cache
+{};
+
+decltype(ircd::m::user::token_cache::max_size)
+ircd::m::user::token_cache::max_size
+{
+	{ "name",     "ircd.m.user.token_cache.max_size" },
+	{ "default",   65536L                            },
+};
+
 ircd::m::user
 ircd::m::create(const id::user &user_id,
                 const json::members &contents)
@@ -2043,6 +2495,78 @@ catch(const std::exception &e)
 	return false;
 }
 
+//
+// user::token_cache
+//
+
+bool
+ircd::m::user::token_cache::get(const string_view &token,
+                                const closure &closure)
+{
+	const auto it
+	{
+		map.find(token)
+	};
+
+	if(it == end(map))
+	{
+		++misses;
+		return false;
+	}
+
+	++hits;
+	closure(id{string_view{it->second}});
+	return true;
+}
+
+bool
+ircd::m::user::token_cache::set(const string_view &token,
+                                const id &user_id,
+                                const uint64_t &epoch)
+{
+	if(unlikely(!size_t(max_size)))
+		return false;
+
+	if(epoch != this->epoch)
+		return false;
+
+	// There is no recency information to evict by; making room at an
+	// arbitrary point costs no more than a miss for that token later.
+	while(map.size() >= size_t(max_size))
+		map.erase(begin(map));
+
+	auto it{map.lower_bound(token)};
+	if(it != end(map) && it->first == token)
+		it->second = std::string{user_id};
+	else
+		map.emplace_hint(it, std::string{token}, std::string{user_id});
+
+	return true;
+}
+
+bool
+ircd::m::user::token_cache::del(const string_view &token)
+{
+	++epoch;
+	const auto it
+	{
+		map.find(token)
+	};
+
+	if(it == end(map))
+		return false;
+
+	map.erase(it);
+	return true;
+}
+
+void
+ircd::m::user::token_cache::clear()
+{
+	++epoch;
+	map.clear();
+}
+
 //
 // user::room
 //
@@ -2942,6 +3466,13 @@ decltype(ircd::util::instance_list<ircd::m::hook<>>::list)
 ircd::util::instance_list<ircd::m::hook<>>::list
 {};
 
+decltype(ircd::m::hook<>::total_calls)
+ircd::m::hook<>::total_calls
+{
+	"ircd.m.hook.calls",
+	"Calls made to all hook functions.",
+};
+
 /// Alternative hook ctor simply allowing the the function argument
 /// first and description after.
 ircd::m::hook<>::hook(decltype(function) function,
@@ -3254,6 +3785,7 @@ ircd::m::hook<>::site::call(hook &hook,
 try
 {
 	++hook.calls;
+	++total_calls;
 	hook.function(event);
 }
 catch(const std::exception &e)
@@ -88,6 +88,13 @@ const
 		{
 			"Authorization", generate(x_matrix, sk, pkid)
 		};
+
+		// Responses are decoded by ircd::server; see tag::inflate_content().
+		if(compress::accepted() != "identity")
+			header[headers++] =
+			{
+				"Accept-Encoding", compress::accepted()
+			};
 	}
 
 	assert(headers <= headers_max);
@@ -172,23 +179,58 @@ const
 		}
 	};
 
-	const m::node::id::buf node_id
+	const auto &origin
 	{
-		"", unquote(at<"origin"_>(*this))
+		unquote(at<"origin"_>(*this))
 	};
 
-	const m::node node
+	ed25519::pk pk;
+	const bool cached
 	{
-		node_id
+		verifier.get(origin, key, pk)
 	};
 
-	bool verified{false};
-	node.key(key, [this, &verified, &sig]
-	(const ed25519::pk &pk)
+	// The key is only fetched from the node room (or the network) when it
+	// isn't already held by the verifier. This may yield the ctx.
+	if(!cached)
 	{
-		verified = verify(pk, sig);
-	});
+		const m::node::id::buf node_id
+		{
+			"", origin
+		};
+
+		const m::node node
+		{
+			node_id
+		};
+
+		time_t valid_until{0};
+		node.key(key, m::node::ed25519_valid_closure{[&pk, &valid_until]
+		(const ed25519::pk &pk_, const time_t &valid_until_)
+		{
+			pk = pk_;
+			valid_until = valid_until_;
+		}});
+
+		verifier.set(origin, key, pk, valid_until);
+	}
+
+	// Only the verification itself is timed; a key fetch is in key_miss.
+	const util::timer timer;
+	const bool verified
+	{
+		verify(pk, sig)
+	};
+
+	auto &stats
+	{
+		verifier[origin]
+	};
 
+	stats.count++;
+	stats.failed += !verified;
+	stats.key_miss += !cached;
+	stats.time += timer.at<nanoseconds>();
 	return verified;
 }
 
@@ -243,6 +285,131 @@ ircd::m::request::verify(const ed25519::pk &pk,
 	return pk.verify(object, sig);
 }
 
+//
+// verifier
+//
+
+decltype(ircd::m::request::verifier)
+ircd::m::request::verifier
+{};
+
+decltype(ircd::m::request::verifier::key_ttl)
+ircd::m::request::verifier::key_ttl
+{
+	{ "name",     "ircd.m.request.verifier.key_ttl" },
+	{ "default",   3600L                            },
+};
+
+decltype(ircd::m::request::verifier::keys_max)
+ircd::m::request::verifier::keys_max
+{
+	{ "name",     "ircd.m.request.verifier.keys.max" },
+	{ "default",   16384L                            },
+};
+
+decltype(ircd::m::request::verifier::origins_max)
+ircd::m::request::verifier::origins_max
+{
+	{ "name",     "ircd.m.request.verifier.origins.max" },
+	{ "default",   16384L                               },
+};
+
+bool
+ircd::m::request::verifier::get(const string_view &origin,
+                                const string_view &key_id,
+                                ed25519::pk &pk)
+{
+	thread_local char buf[512];
+	const string_view k
+	{
+		fmt::sprintf{buf, "%s %s", origin, key_id}
+	};
+
+	const auto it
+	{
+		keys.find(k)
+	};
+
+	if(it == end(keys))
+		return false;
+
+	if(it->second.expires < ircd::time())
+		return false;
+
+	keys_lru.splice(begin(keys_lru), keys_lru, it->second.lru);
+	pk = it->second.pk;
+	return true;
+}
+
+/// The key is held until key_ttl has elapsed, or until the origin's
+/// valid_until_ts for it if that is sooner.
+void
+ircd::m::request::verifier::set(const string_view &origin,
+                                const string_view &key_id,
+                                const ed25519::pk &pk,
+                                const time_t &valid_until)
+{
+	thread_local char buf[512];
+	const string_view k
+	{
+		fmt::sprintf{buf, "%s %s", origin, key_id}
+	};
+
+	const time_t now
+	{
+		ircd::time()
+	};
+
+	auto it{keys.lower_bound(k)};
+	if(it == end(keys) || it->first != k)
+	{
+		if(!keys.empty() && keys.size() >= size_t(keys_max))
+		{
+			// Make room with the key used least recently.
+			keys.erase(keys.find(keys_lru.back()));
+			keys_lru.pop_back();
+			it = keys.lower_bound(k);
+		}
+
+		it = keys.emplace_hint(it, std::string{k}, key{});
+		it->second.lru = keys_lru.emplace(begin(keys_lru), it->first);
+	}
+	else keys_lru.splice(begin(keys_lru), keys_lru, it->second.lru);
+
+	const time_t ttl_expires
+	{
+		now + seconds(key_ttl).count()
+	};
+
+	it->second.pk = pk;
+	it->second.expires = valid_until > 0?
+		std::min(ttl_expires, valid_until):
+		ttl_expires;
+}
+
+ircd::m::request::verifier::stats &
+ircd::m::request::verifier::operator[](const string_view &origin)
+{
+	auto it{origins.lower_bound(origin)};
+	if(it == end(origins) || it->first != origin)
+	{
+		if(!origins.empty() && origins.size() >= size_t(origins_max))
+		{
+			// Make room with the origin heard from least recently.
+			origins.erase(origins.find(origins_lru.back()));
+			origins_lru.pop_back();
+			it = origins.lower_bound(origin);
+		}
+
+		it = origins.emplace_hint(it, std::string{origin}, stats{});
+		it->second.lru = origins_lru.emplace(begin(origins_lru), it->first);
+	}
+	else origins_lru.splice(begin(origins_lru), origins_lru, it->second.lru);
+
+	it->second.last = ircd::time();
+	return it->second;
+}
+
 //
 // x_matrix
 //
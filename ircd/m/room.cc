@@ -165,14 +165,28 @@ bool
 ircd::m::room::visible(const m::user::id &user_id)
 const
 {
-	return true;
+	using prototype = bool (const m::room &, const string_view &);
+
+	static import<prototype> function
+	{
+		"m_room_history_visibility", "visible__room"
+	};
+
+	return function(*this, user_id);
 }
 
 bool
 ircd::m::room::visible(const m::node::id &origin)
 const
 {
-	return true;
+	using prototype = bool (const m::room &, const string_view &);
+
+	static import<prototype> function
+	{
+		"m_room_history_visibility", "visible__room"
+	};
+
+	return function(*this, origin);
 }
 
 bool
@@ -189,6 +203,22 @@ ircd::m::room::membership(const mutable_buffer &out,
                           const m::id::user &user_id)
 const
 {
+	// The present membership is answered from the in-memory index.
+	const auto *const cache
+	{
+		!event_id? members::cache::get(*this) : nullptr
+	};
+
+	if(cache)
+	{
+		const string_view &membership
+		{
+			cache->membership(user_id)
+		};
+
+		return { data(out), copy(out, membership) };
+	}
+
 	string_view ret;
 	const state state{*this};
 	state.get(std::nothrow, "m.room.member"_sv, user_id, [&out, &ret]
@@ -1366,6 +1396,15 @@ size_t
 ircd::m::room::members::count(const string_view &membership)
 const
 {
+	// The present membership is counted by the in-memory index.
+	const auto *const index
+	{
+		!room.event_id? cache::get(room) : nullptr
+	};
+
+	if(index && index->set(membership))
+		return index->count(membership);
+
 	// joined members optimization. Only possible when seeking
 	// membership="join" on the present state of the room.
 	if(!room.event_id && membership == "join")
@@ -1408,6 +1447,307 @@ const
 	return state.count("m.room.member");
 }
 
+//
+// room::members::cache
+//
+
+decltype(ircd::m::room::members::cache::rooms_max)
+ircd::m::room::members::cache::rooms_max
+{
+	{ "name",     "ircd.m.room.members.cache.rooms_max" },
+	{ "default",   4096L                                },
+};
+
+decltype(ircd::m::room::members::cache::rooms)
+ircd::m::room::members::cache::rooms
+{};
+
+decltype(ircd::m::room::members::cache::lru)
+ircd::m::room::members::cache::lru
+{};
+
+decltype(ircd::m::room::members::cache::building)
+ircd::m::room::members::cache::building
+{};
+
+/// Find the index for the room or build it from the room's present state.
+/// Building may yield the ctx to query the state tree; null is returned if
+/// the build was raced by a member event committed to the room or another
+/// build of the room is in progress. The result is only valid until the
+/// caller yields.
+const ircd::m::room::members::cache *
+ircd::m::room::members::cache::get(const m::room &room)
+{
+	auto *const existing
+	{
+		find(room.room_id)
+	};
+
+	if(existing)
+		return existing;
+
+	auto bit
+	{
+		building.lower_bound(room.room_id)
+	};
+
+	if(bit != end(building) && bit->first == room.room_id)
+		return nullptr;
+
+	bit = building.emplace_hint(bit, std::string{room.room_id}, false);
+	const unwind done{[&bit]
+	{
+		building.erase(bit);
+	}};
+
+	cache built
+	{
+		room
+	};
+
+	const bool &raced
+	{
+		bit->second
+	};
+
+	if(raced)
+		return nullptr;
+
+	assert(!find(room.room_id));
+	while(!rooms.empty() && rooms.size() >= size_t(rooms_max))
+	{
+		assert(!lru.empty());
+		const auto it
+		{
+			rooms.find(lru.front())
+		};
+
+		assert(it != end(rooms));
+		lru.pop_front();
+		rooms.erase(it);
+	}
+
+	const auto it
+	{
+		rooms.emplace(std::string{room.room_id}, std::move(built)).first
+	};
+
+	it->second.lru_it = lru.emplace(end(lru), it->first);
+	return &it->second;
+}
+
+/// Find the index for the room if it is held; this counts as a use.
+ircd::m::room::members::cache *
+ircd::m::room::members::cache::find(const m::room::id &room_id)
+{
+	const auto it
+	{
+		rooms.find(room_id)
+	};
+
+	if(it == end(rooms))
+		return nullptr;
+
+	auto &cache(it->second);
+	lru.splice(end(lru), lru, cache.lru_it);
+	return &cache;
+}
+
+/// Called for each member event once it is committed to the present state
+/// (see the vm.write hook in m_room_member). Rooms without an index are
+/// ignored; they are built on demand.
+void
+ircd::m::room::members::cache::update(const m::room::id &room_id,
+                                      const id::user &user_id,
+                                      const string_view &membership)
+{
+	// Any build of this room underway may have read the state before this
+	// event; it is discarded rather than kept without it.
+	const auto bit
+	{
+		building.find(room_id)
+	};
+
+	if(bit != end(building))
+		bit->second = true;
+
+	if(!find(room_id))
+		return;
+
+	const auto idx
+	{
+		intern(user_id)
+	};
+
+	// Interning may have yielded; the room is found again after it.
+	auto *const cache
+	{
+		find(room_id)
+	};
+
+	if(cache)
+		cache->set(idx, membership);
+}
+
+/// Drop the index for the room, e.g. after a state resolution changed the
+/// membership of users other than the sender of the committed event. A
+/// build underway is discarded as well.
+void
+ircd::m::room::members::cache::invalidate(const m::room::id &room_id)
+{
+	const auto bit
+	{
+		building.find(room_id)
+	};
+
+	if(bit != end(building))
+		bit->second = true;
+
+	const auto it
+	{
+		rooms.find(room_id)
+	};
+
+	if(it == end(rooms))
+		return;
+
+	lru.erase(it->second.lru_it);
+	rooms.erase(it);
+}
+
+ircd::m::room::members::cache::cache(const m::room &room)
+{
+	const room::state state
+	{
+		room
+	};
+
+	state.for_each("m.room.member", event::closure{[this]
+	(const m::event &event)
+	{
+		set(intern(at<"state_key"_>(event)), m::membership(event));
+	}});
+}
+
+size_t
+ircd::m::room::members::cache::count(const string_view &membership)
+const
+{
+	const auto *const set
+	{
+		this->set(membership)
+	};
+
+	return set? set->size() : 0;
+}
+
+bool
+ircd::m::room::members::cache::membership(const id::user &user_id,
+                                          const string_view &membership)
+const
+{
+	uint32_t idx{0};
+	if(!interned(user_id, idx))
+		return false;
+
+	const auto *const set
+	{
+		this->set(membership)
+	};
+
+	return set && set->has(idx);
+}
+
+ircd::string_view
+ircd::m::room::members::cache::membership(const id::user &user_id)
+const
+{
+	uint32_t idx{0};
+	if(!interned(user_id, idx))
+		return {};
+
+	if(join.has(idx))
+		return "join";
+
+	if(invite.has(idx))
+		return "invite";
+
+	if(leave.has(idx))
+		return "leave";
+
+	if(ban.has(idx))
+		return "ban";
+
+	return {};
+}
+
+/// Moves the user into the set for the membership; an unrecognized or
+/// empty membership removes the user from all sets.
+void
+ircd::m::room::members::cache::set(const uint32_t &idx,
+                                   const string_view &membership)
+{
+	join.del(idx);
+	invite.del(idx);
+	leave.del(idx);
+	ban.del(idx);
+
+	auto *const set
+	{
+		this->set(membership)
+	};
+
+	if(set)
+		set->set(idx);
+}
+
+ircd::roaring *
+ircd::m::room::members::cache::set(const string_view &membership)
+{
+	const auto &cthis{*this};
+	return const_cast<roaring *>(cthis.set(membership));
+}
+
+const ircd::roaring *
+ircd::m::room::members::cache::set(const string_view &membership)
+const
+{
+	switch(hash(membership))
+	{
+		case hash("join"):     return &join;
+		case hash("invite"):   return &invite;
+		case hash("leave"):    return &leave;
+		case hash("ban"):      return &ban;
+		default:               return nullptr;
+	}
+}
+
+bool
+ircd::m::room::members::cache::interned(const string_view &user_id,
+                                        uint32_t &idx)
+{
+	const auto handle
+	{
+		m::intern::find(std::nothrow, user_id)
+	};
+
+	assert(handle <= std::numeric_limits<uint32_t>::max());
+	idx = handle;
+	return handle != 0;
+}
+
+uint32_t
+ircd::m::room::members::cache::intern(const string_view &user_id)
+{
+	const auto handle
+	{
+		m::intern::set(user_id)
+	};
+
+	assert(handle <= std::numeric_limits<uint32_t>::max());
+	return handle;
+}
+
 //
 // room::origins
 //
@@ -62,6 +62,11 @@ ircd::m::state::get(std::nothrow_t,
                     const json::array &key,
                     const val_closure &closure)
 {
+	const trace::span span
+	{
+		"state.get"
+	};
+
 	bool ret{false};
 	char nextbuf[ID_MAX_SZ];
 	string_view nextid{root};
@@ -181,6 +186,517 @@ ircd::m::state::test(const string_view &root,
 	});
 }
 
+//
+// diff
+//
+
+namespace ircd::m::state
+{
+	using pairs = std::map<std::string, std::string, std::less<>>;
+	using idset = std::set<std::string, std::less<>>;
+
+	static void _diff_expand(std::vector<std::string> &pending, idset &seen, pairs &found);
+}
+
+/// Find the keys with differing values in two trees. The closure is called
+/// with the key and its value in each tree, where an empty value means the
+/// key is absent from that tree. Return true from the closure to stop; the
+/// function returns true if stopped.
+///
+/// A node's id is the hash of its content so a subtree reached through the
+/// same id in both trees is identical and is not descended into. The trees
+/// are expanded together level by level and nodes on one side already
+/// reached on the other side are dropped, leaving only the nodes on the
+/// paths rewritten since the trees forked. Those nodes also carry unchanged
+/// neighbours, so every key found in them is confirmed against the other
+/// tree before it is reported.
+bool
+ircd::m::state::diff(const id &a,
+                     const id &b,
+                     const diff_closure &closure)
+{
+	if(a == b)
+		return false;
+
+	std::array<std::vector<std::string>, 2> pending;
+	std::array<idset, 2> seen;
+	std::array<pairs, 2> found;
+	const std::array<string_view, 2> root
+	{
+		a, b
+	};
+
+	for(size_t i(0); i < 2; ++i)
+	{
+		pending[i].emplace_back(root[i]);
+		seen[i].emplace(root[i]);
+	}
+
+	while(!pending[0].empty() || !pending[1].empty())
+	{
+		for(size_t i(0); i < 2; ++i)
+		{
+			const auto &theirs(seen[!i]);
+			auto &mine(pending[i]);
+			mine.erase(std::remove_if(begin(mine), end(mine), [&theirs]
+			(const std::string &id)
+			{
+				return theirs.count(id);
+			}), end(mine));
+		}
+
+		for(size_t i(0); i < 2; ++i)
+			_diff_expand(pending[i], seen[i], found[i]);
+	}
+
+	std::set<string_view> keys;
+	for(const auto &found : found)
+		for(const auto &pair : found)
+			keys.emplace(pair.first);
+
+	std::array<std::string, 2> val;
+	for(const auto &key : keys)
+	{
+		for(size_t i(0); i < 2; ++i)
+		{
+			const auto it(found[i].find(key));
+			if(it != end(found[i]))
+			{
+				val[i] = it->second;
+				continue;
+			}
+
+			val[i].clear();
+			get(std::nothrow, root[i], json::array{key}, [&val, &i]
+			(const string_view &value)
+			{
+				val[i] = std::string{value};
+			});
+		}
+
+		if(val[0] != val[1])
+			if(closure(json::array{key}, string_view{val[0]}, string_view{val[1]}))
+				return true;
+	}
+
+	return false;
+}
+
+void
+ircd::m::state::_diff_expand(std::vector<std::string> &pending,
+                             idset &seen,
+                             pairs &found)
+{
+	std::vector<std::string> next;
+	for(const auto &id : pending)
+		get_node(string_view{id}, [&next, &seen, &found]
+		(const node &node)
+		{
+			const node::rep rep{node};
+			for(size_t i(0); i < rep.kn && i < rep.vn; ++i)
+				found.emplace(rep.keys[i], rep.vals[i]);
+
+			for(size_t i(0); i < rep.cn; ++i)
+				if(!empty(rep.chld[i]) && seen.emplace(rep.chld[i]).second)
+					next.emplace_back(rep.chld[i]);
+		});
+
+	pending = std::move(next);
+}
+
+//
+// resolve
+//
+
+namespace ircd::m::state
+{
+	struct candidate;
+	struct powers;
+
+	static bool _resolve_power_event(const json::array &key);
+	static string_view _resolve_key(const json::array &key, std::vector<candidate> &, const powers &);
+	static void _resolve(const std::vector<std::string> &keys, std::vector<std::vector<candidate>> &, std::vector<std::string> &winners, const string_view &levels, const string_view &creator);
+
+	extern stats::counter resolve_count;
+	extern stats::counter resolve_conflicts;
+}
+
+/// Sender powers under the content of an m.room.power_levels, for all the
+/// candidates of a resolution. The users object is most of that content in
+/// a large room and every candidate would otherwise scan it from the start;
+/// it is indexed once instead. Without power levels the creator has 100.
+struct ircd::m::state::powers
+{
+	string_view creator;
+	string_view users_default;
+	json::object::index users;
+	bool levels {false};
+
+	int64_t operator()(const string_view &user_id) const;
+
+	powers(const string_view &levels, const string_view &creator);
+};
+
+/// A value proposed for a key by one of the forks being resolved.
+struct ircd::m::state::candidate
+{
+	std::string event_id;
+	int64_t power {0};
+	int64_t depth {0};
+	int64_t ts {0};
+	bool valid {false};
+};
+
+decltype(ircd::m::state::resolve_width)
+ircd::m::state::resolve_width
+{
+	{ "name",     "ircd.m.state.resolve.width" },
+	{ "default",  8L                           },
+};
+
+decltype(ircd::m::state::resolve_count)
+ircd::m::state::resolve_count
+{
+	"ircd.m.state.resolve.count",
+	"State resolutions of more than one distinct root.",
+};
+
+decltype(ircd::m::state::resolve_conflicts)
+ircd::m::state::resolve_conflicts
+{
+	"ircd.m.state.resolve.conflicts",
+	"Keys found in conflict by state resolution.",
+};
+
+/// Resolve the states of several forks (i.e the roots at each of an event's
+/// prev_events) into one tree; the new root id is written to rootout and a
+/// view of it returned.
+///
+/// The first root is the base. Conflicts are found by diff() of each other
+/// root against it, so the cost is in proportion to what changed since the
+/// forks diverged and not to the size of the state. Each conflicted key is
+/// resolved on its own, spread over up to resolve_width contexts which fetch
+/// the candidate events concurrently. The result is then applied to the
+/// base with an insert() for each key whose winner differs from the base,
+/// which rewrites only the nodes on the path to that key; all other
+/// subtrees of the base are shared by the new root. The nodes are written
+/// to the caller's txn (i.e the one of the event being evaluated) and the
+/// new root only exists once that is committed. Each key applied is given
+/// to the optional closure with its winning event id, so the caller can
+/// update what it derives from the state once the txn is committed.
+///
+/// In the manner of state resolution v2, the power events (create, power
+/// levels and join rules) are resolved first and the sender powers for the
+/// remaining keys are taken from the resulting power levels. Unlike v2,
+/// kicks and bans are not among them; see _resolve_power_event(). The
+/// ordering within a key is by sender power, then depth, then timestamp,
+/// then event id. The iterative auth checks and the auth-chain based
+/// orderings of v2 are not conducted here.
+ircd::m::state::id
+ircd::m::state::resolve(db::txn &txn,
+                        const mutable_buffer &rootout,
+                        const vector_view<const id> &roots,
+                        const iter_closure &applied_closure)
+{
+	std::vector<string_view> distinct;
+	for(const auto &root : roots)
+		if(!empty(root) && std::find(begin(distinct), end(distinct), root) == end(distinct))
+			distinct.emplace_back(root);
+
+	if(distinct.empty())
+		return {};
+
+	const string_view &base
+	{
+		distinct.front()
+	};
+
+	if(distinct.size() == 1)
+		return { data(rootout), copy(rootout, base) };
+
+	++resolve_count;
+	const trace::span span
+	{
+		"state.resolve"
+	};
+
+	// Every distinct value each fork has for each conflicted key. The value
+	// in the base is included when it has one.
+	std::map<std::string, std::vector<std::string>, std::less<>> conflicts;
+	for(auto it(begin(distinct) + 1); it != end(distinct); ++it)
+		diff(base, *it, [&conflicts]
+		(const json::array &key, const string_view &a, const string_view &b)
+		{
+			auto &vals(conflicts[std::string{key}]);
+			for(const auto &val : {a, b})
+				if(!empty(val) && std::find(begin(vals), end(vals), val) == end(vals))
+					vals.emplace_back(val);
+
+			return false;
+		});
+
+	resolve_conflicts += conflicts.size();
+
+	// Partition the power events from the rest; they are resolved first.
+	std::array<std::vector<std::string>, 2> keys;
+	std::array<std::vector<std::vector<candidate>>, 2> cands;
+	for(const auto &pair : conflicts)
+	{
+		const bool power(_resolve_power_event(json::array{pair.first}));
+		keys[!power].emplace_back(pair.first);
+		auto &vec(cands[!power].emplace_back(pair.second.size()));
+		for(size_t i(0); i < pair.second.size(); ++i)
+			vec[i].event_id = pair.second[i];
+	}
+
+	std::array<std::vector<std::string>, 2> winners;
+	std::string creator, levels;
+	const auto load_create{[&creator]
+	(const string_view &event_id)
+	{
+		creator.clear();
+		const m::event::fetch event{m::event::id{event_id}, std::nothrow};
+		if(event.valid)
+			creator = unquote(json::get<"content"_>(event).get("creator"));
+	}};
+
+	const auto load_levels{[&levels]
+	(const string_view &event_id)
+	{
+		levels.clear();
+		const m::event::fetch event{m::event::id{event_id}, std::nothrow};
+		if(event.valid)
+			levels = std::string{json::get<"content"_>(event)};
+	}};
+
+	get(std::nothrow, base, "m.room.create", "", load_create);
+	get(std::nothrow, base, "m.room.power_levels", "", load_levels);
+	_resolve(keys[0], cands[0], winners[0], string_view{levels}, string_view{creator});
+
+	// Apply a resolved value. Each key is applied once, so its value in the
+	// tree built so far is still the value in the base. The nodes written
+	// by one insert are read back from the txn by the next.
+	std::array<id_buffer, 2> buf;
+	size_t applied(0);
+	string_view root{base};
+	const auto apply{[&txn, &buf, &applied, &root, &base, &applied_closure]
+	(const string_view &key, const string_view &event_id)
+	{
+		std::string cur;
+		get(std::nothrow, base, json::array{key}, [&cur]
+		(const string_view &val)
+		{
+			cur = std::string{val};
+		});
+
+		if(empty(event_id) || string_view{cur} == event_id)
+			return;
+
+		root = insert(txn, buf[applied++ % buf.size()], root, json::array{key}, m::event::id{event_id});
+		if(applied_closure)
+			applied_closure(json::array{key}, event_id);
+	}};
+
+	for(size_t i(0); i < keys[0].size(); ++i)
+		apply(string_view{keys[0][i]}, string_view{winners[0][i]});
+
+	// The powers for the remaining keys are those of the resolved auth state;
+	// the winners are loaded directly since the new root is not committed.
+	for(size_t i(0); i < keys[0].size(); ++i)
+	{
+		const json::array key{keys[0][i]};
+		if(empty(winners[0][i]) || !empty(unquote(key.at(1))))
+			continue;
+
+		if(unquote(key.at(0)) == "m.room.create")
+			load_create(string_view{winners[0][i]});
+		else if(unquote(key.at(0)) == "m.room.power_levels")
+			load_levels(string_view{winners[0][i]});
+	}
+
+	_resolve(keys[1], cands[1], winners[1], string_view{levels}, string_view{creator});
+	for(size_t i(0); i < keys[1].size(); ++i)
+		apply(string_view{keys[1][i]}, string_view{winners[1][i]});
+
+	log::debug
+	{
+		log, "Resolved %zu roots from %s with %zu conflicts (%zu power) applying %zu to %s",
+		distinct.size(),
+		base,
+		conflicts.size(),
+		keys[0].size(),
+		applied,
+		root
+	};
+
+	return { data(rootout), copy(rootout, root) };
+}
+
+/// Resolve the keys in parallel. The keys are striped over the workers; each
+/// worker fetches the candidates of its keys and chooses the winners in
+/// place. The workers are joined before returning (or unwinding).
+void
+ircd::m::state::_resolve(const std::vector<std::string> &keys,
+                         std::vector<std::vector<candidate>> &cands,
+                         std::vector<std::string> &winners,
+                         const string_view &levels,
+                         const string_view &creator)
+{
+	assert(keys.size() == cands.size());
+	winners.assign(keys.size(), std::string{});
+	if(keys.empty())
+		return;
+
+	const size_t width
+	{
+		std::max(std::min(size_t(resolve_width), keys.size()), 1UL)
+	};
+
+	const powers powers
+	{
+		levels, creator
+	};
+
+	std::exception_ptr eptr;
+	const auto worker{[&keys, &cands, &winners, &powers, &width, &eptr]
+	(const size_t &stripe)
+	{
+		try
+		{
+			for(size_t i(stripe); i < keys.size(); i += width)
+				winners[i] = std::string
+				{
+					_resolve_key(json::array{keys[i]}, cands[i], powers)
+				};
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const ctx::terminated &)
+		{
+			throw;
+		}
+		catch(...)
+		{
+			eptr = std::current_exception();
+		}
+	}};
+
+	// The calling context does a stripe itself.
+	std::vector<std::unique_ptr<ctx::context>> workers;
+	workers.reserve(width - 1);
+	for(size_t i(1); i < width; ++i)
+		workers.emplace_back(std::make_unique<ctx::context>("m.state.resolve", 128_KiB, ctx::context::POST, std::bind(worker, i)));
+
+	worker(0);
+	for(auto &context : workers)
+		context->join();
+
+	if(eptr)
+		std::rethrow_exception(eptr);
+}
+
+/// Choose the winning event id among the candidates for a key.
+ircd::string_view
+ircd::m::state::_resolve_key(const json::array &key,
+                             std::vector<candidate> &cands,
+                             const powers &powers)
+{
+	for(auto &cand : cands)
+	{
+		const m::event::fetch event
+		{
+			m::event::id{string_view{cand.event_id}}, std::nothrow
+		};
+
+		if(!event.valid)
+			continue;
+
+		cand.valid = true;
+		cand.power = powers(json::get<"sender"_>(event));
+		cand.depth = json::get<"depth"_>(event);
+		cand.ts = json::get<"origin_server_ts"_>(event);
+	}
+
+	const auto it
+	{
+		std::max_element(begin(cands), end(cands), []
+		(const candidate &a, const candidate &b)
+		{
+			return std::make_tuple(a.valid, a.power, a.depth, a.ts, b.event_id) <
+			       std::make_tuple(b.valid, b.power, b.depth, b.ts, a.event_id);
+		})
+	};
+
+	// When none of the candidates could be fetched there is no basis for
+	// a decision and the base value stands.
+	if(it == end(cands) || !it->valid)
+		return {};
+
+	return string_view{it->event_id};
+}
+
+ircd::m::state::powers::powers(const string_view &levels,
+                               const string_view &creator)
+:creator{creator}
+,users_default
+{
+	!empty(levels)? json::object{levels}.get("users_default", "0") : string_view{}
+}
+,users{[&levels]
+{
+	const json::object users
+	{
+		!empty(levels)? json::object{levels}.get("users") : string_view{}
+	};
+
+	return !empty(users)?
+		json::object::index{users}:
+		json::object::index{};
+}()}
+,levels
+{
+	!empty(levels)
+}
+{
+}
+
+int64_t
+ircd::m::state::powers::operator()(const string_view &user_id)
+const
+{
+	if(!levels)
+		return user_id == creator? 100 : 0;
+
+	const string_view level
+	{
+		unquote(users.get(user_id, users_default))
+	};
+
+	return try_lex_cast<int64_t>(level)?
+		lex_cast<int64_t>(level):
+		0L;
+}
+
+/// State which decides the authority of other state is resolved first.
+bool
+ircd::m::state::_resolve_power_event(const json::array &key)
+{
+	const string_view type
+	{
+		unquote(key.at(0))
+	};
+
+	// v2 also counts kicks and bans; telling those apart from other member
+	// events requires each candidate to be fetched first, so all member
+	// events are resolved with the rest under the resolved power levels.
+	// resolve() documents this deviation.
+	return type == "m.room.create" ||
+	       type == "m.room.power_levels" ||
+	       type == "m.room.join_rules";
+}
+
 namespace ircd::m::state
 {
 	size_t _count_recurse(const node &, const json::array &key, const json::array &dom);
@@ -418,7 +934,7 @@ ircd::m::state::insert(db::txn &txn,
 	node::rep push;
 	int8_t height{0};
 	string_view root{rootin};
-	get_node(root, [&](const node &node)
+	get_node(txn, root, [&](const node &node)
 	{
 		root = _insert(height, txn, key, event_id, node, rootout, push);
 	});
@@ -468,7 +984,7 @@ ircd::m::state::_insert(int8_t &height,
 	string_view child;
 
 	// Recurse
-	get_node(node.child(pos), [&](const auto &node)
+	get_node(txn, node.child(pos), [&](const auto &node)
 	{
 		child = _insert(height, txn, key, val, node, idbuf, pushed);
 	});
@@ -784,6 +1300,26 @@ ircd::m::state::get_node(const string_view &node_id,
 		};
 }
 
+/// View a node by ID which may be pending in the txn, i.e written by an
+/// earlier insert() into the same txn; otherwise this is a DB query.
+void
+ircd::m::state::get_node(const db::txn &txn,
+                         const string_view &node_id,
+                         const node_closure &closure)
+{
+	const bool pending
+	{
+		txn.get(db::op::SET, string_view{db::name(dbs::state_node)}, node_id, [&closure]
+		(const string_view &node)
+		{
+			closure(json::object{node});
+		})
+	};
+
+	if(!pending)
+		get_node(node_id, closure);
+}
+
 /// View a node by ID. This makes a DB query and may yield ircd::ctx.
 bool
 ircd::m::state::get_node(const std::nothrow_t,
@@ -2392,6 +2392,13 @@ ircd::net::dns::cache::min_ttl
 	{ "default",   900L                        },
 };
 
+decltype(ircd::net::dns::aaaa_grace)
+ircd::net::dns::aaaa_grace
+{
+	{ "name",     "ircd.net.dns.aaaa_grace" },
+	{ "default",   50L                      },
+};
+
 decltype(ircd::net::dns::prefetch_ipport)
 ircd::net::dns::prefetch_ipport{[]
 (std::exception_ptr, const auto &hostport, const auto &record)
@@ -2413,6 +2420,13 @@ ircd::net::dns::prefetch_A{[]
 	// Do nothing; cache already updated if necessary
 }};
 
+decltype(ircd::net::dns::prefetch_AAAA)
+ircd::net::dns::prefetch_AAAA{[]
+(std::exception_ptr, const auto &hostport, const auto &record)
+{
+	// Do nothing; cache already updated if necessary
+}};
+
 /// Convenience composition with a single ipport callback. This is the result of
 /// an automatic chain of queries such as SRV and A/AAAA based on the input and
 /// intermediate results.
@@ -2421,42 +2435,18 @@ ircd::net::dns::operator()(const hostport &hp,
                            const opts &opts,
                            callback_ipport_one callback)
 {
-	//TODO: ip6
-	auto calluser{[callback(std::move(callback))]
-	(std::exception_ptr eptr, const hostport &hp, const uint32_t &ip)
-	{
-		if(eptr)
-			return callback(std::move(eptr), hp, {});
-
-		if(!ip)
-		{
-			static const net::not_found no_record
-			{
-				"Host has no A record"
-			};
-
-			return callback(std::make_exception_ptr(no_record), hp, {});
-		}
-
-		const ipport ipport{ip, port(hp)};
-		callback(std::move(eptr), hp, ipport);
-	}};
-
 	if(!hp.service)
-		return operator()(hp, opts, [calluser(std::move(calluser))]
-		(std::exception_ptr eptr, const hostport &hp, const rfc1035::record::A &record)
-		{
-			calluser(std::move(eptr), hp, record.ip4);
-		});
+		return resolve_ip(hp, opts, std::move(callback));
 
 	auto srv_opts{opts};
+	srv_opts.qtype = 33;
 	srv_opts.nxdomain_exceptions = false;
-	operator()(hp, srv_opts, [opts(opts), calluser(std::move(calluser))]
+	operator()(hp, srv_opts, [opts(opts), callback(std::move(callback))]
 	(std::exception_ptr eptr, hostport hp, const rfc1035::record::SRV &record)
 	mutable
 	{
 		if(eptr)
-			return calluser(std::move(eptr), hp, 0);
+			return callback(std::move(eptr), hp, {});
 
 		if(record.port != 0)
 			hp.port = record.port;
@@ -2468,10 +2458,120 @@ ircd::net::dns::operator()(const hostport &hp,
 		opts.srv = {};
 		opts.proto = {};
 
-		net::dns(hp, opts, [calluser(std::move(calluser))]
-		(std::exception_ptr eptr, const hostport &hp, const rfc1035::record::A &record)
+		resolve_ip(hp, opts, std::move(callback));
+	});
+}
+
+/// Makes the A and AAAA queries for a host concurrently. An IPv4 result is
+/// preferred and is given to the user as soon as it arrives. When the IPv6
+/// result arrives first it is held for up to aaaa_grace waiting on the A
+/// query, then given to the user. An error is only reported when neither
+/// query produced an address.
+void
+ircd::net::dns::resolve_ip(const hostport &hp,
+                           const opts &opts,
+                           callback_ipport_one callback)
+{
+	struct state
+	{
+		callback_ipport_one callback;
+		std::exception_ptr eptr;
+		uint128_t ip6 {0};
+		size_t remain {2};
+		bool done {false};
+		std::unique_ptr<asio::steady_timer> grace;
+		std::string host, service;                 // owned copy for the timer
+		uint16_t port {0};
+	};
+
+	const auto state
+	{
+		std::make_shared<struct state>()
+	};
+
+	state->callback = std::move(callback);
+	const auto finish{[state]
+	(const hostport &hp, const ipport &ipport)
+	{
+		assert(!state->done);
+		state->done = true;
+		if(state->grace)
+			state->grace->cancel();
+
+		if(ipport)
+			return state->callback({}, hp, ipport);
+
+		if(state->eptr)
+			return state->callback(state->eptr, hp, {});
+
+		static const net::not_found no_record
+		{
+			"Host has no A or AAAA record"
+		};
+
+		state->callback(std::make_exception_ptr(no_record), hp, {});
+	}};
+
+	auto opts_A{opts};
+	opts_A.qtype = 1;
+	net::dns(hp, opts_A, [state, finish]
+	(std::exception_ptr eptr, const hostport &hp, const rfc1035::record::A &record)
+	{
+		--state->remain;
+		if(state->done)
+			return;
+
+		if(!eptr && record.ip4)
+			return finish(hp, ipport{record.ip4, port(hp)});
+
+		if(eptr && !state->eptr)
+			state->eptr = std::move(eptr);
+
+		// No IPv4; whatever AAAA has (or will have) is the answer.
+		if(state->ip6 || !state->remain)
+			return finish(hp, state->ip6? ipport{state->ip6, port(hp)} : ipport{});
+	});
+
+	auto opts_AAAA{opts};
+	opts_AAAA.qtype = 28;
+	net::dns(hp, opts_AAAA, [state, finish]
+	(std::exception_ptr eptr, const hostport &hp, const rfc1035::record::AAAA &record)
+	{
+		--state->remain;
+		if(state->done)
+			return;
+
+		if(eptr && !state->eptr)
+			state->eptr = std::move(eptr);
+
+		state->ip6 = !eptr? record.ip6 : 0;
+		if(!state->remain)
+			return finish(hp, state->ip6? ipport{state->ip6, port(hp)} : ipport{});
+
+		// The A query is outstanding; don't let it hold up a usable answer
+		// for longer than the grace period.
+		if(!state->ip6)
+			return;
+
+		// The hostport given here views the resolver's tag which is gone
+		// by the time the timer fires.
+		state->host = std::string{hp.host};
+		state->service = std::string{hp.service};
+		state->port = hp.port;
+		state->grace = std::make_unique<asio::steady_timer>(*ircd::ios);
+		state->grace->expires_after(milliseconds(aaaa_grace));
+		state->grace->async_wait([state, finish]
+		(const boost::system::error_code &ec)
 		{
-			calluser(std::move(eptr), hp, record.ip4);
+			if(ec || state->done)
+				return;
+
+			const hostport hp
+			{
+				string_view{state->host}, string_view{state->service}, state->port
+			};
+
+			finish(hp, ipport{state->ip6, port(hp)});
 		});
 	});
 }
@@ -2538,6 +2638,37 @@ ircd::net::dns::operator()(const hostport &hp,
 	});
 }
 
+/// Convenience callback with a single AAAA record which was selected from
+/// the vector randomly.
+void
+ircd::net::dns::operator()(const hostport &hp,
+                           const opts &opts,
+                           callback_AAAA_one callback)
+{
+	assert(bool(ircd::net::dns::resolver));
+	operator()(hp, opts, [callback(std::move(callback))]
+	(std::exception_ptr eptr, const hostport &hp, const vector_view<const rfc1035::record *> &rrs)
+	{
+		static const rfc1035::record::AAAA empty;
+
+		if(eptr)
+			return callback(std::move(eptr), hp, empty);
+
+		//TODO: prng plz
+		for(size_t i(0); i < rrs.size(); ++i)
+		{
+			const auto &rr{*rrs.at(i)};
+			if(rr.type != 28)
+				continue;
+
+			const auto &record(rr.as<const rfc1035::record::AAAA>());
+			return callback(std::move(eptr), hp, record);
+		}
+
+		return callback(std::move(eptr), hp, empty);
+	});
+}
+
 /// Fundamental callback with a vector of abstract resource records.
 void
 ircd::net::dns::operator()(const hostport &hostport,
@@ -2625,6 +2756,27 @@ ircd::net::dns::cache::put_error(const rfc1035::question &question,
 			return &it->second;
 		}
 
+		case 28: // AAAA
+		{
+			auto &map{AAAA};
+			auto pit
+			{
+				map.equal_range(host)
+			};
+
+			auto it
+			{
+				pit.first != pit.second?
+					map.erase(pit.first, pit.second):
+					pit.first
+			};
+
+			rfc1035::record::AAAA record;
+			record.ttl = ircd::time() + seconds(cache::clear_nxdomain).count(); //TODO: code
+			it = map.emplace_hint(it, host, record);
+			return &it->second;
+		}
+
 		case 33: // SRV
 		{
 			auto &map{SRV};
@@ -2688,6 +2840,32 @@ ircd::net::dns::cache::put(const rfc1035::question &question,
 			return &iit->second;
 		}
 
+		case 28: // AAAA
+		{
+			auto &map{AAAA};
+			auto pit
+			{
+				map.equal_range(host)
+			};
+
+			auto it(pit.first);
+			while(it != pit.second)
+			{
+				const auto &rr{it->second};
+				if(rr == answer)
+					it = map.erase(it);
+				else
+					++it;
+			}
+
+			const auto &iit
+			{
+				map.emplace_hint(it, host, answer)
+			};
+
+			return &iit->second;
+		}
+
 		case 33: // SRV
 		{
 			auto &map{SRV};
@@ -2741,7 +2919,15 @@ ircd::net::dns::cache::get(const hostport &hp,
 	size_t count{0};
 
 	//TODO: Better deduction
-	if(hp.service || opts.srv) // deduced SRV query
+	const auto qtype
+	{
+		opts.qtype?:
+		hp.service || opts.srv?
+			uint16_t(33):
+			uint16_t(1)
+	};
+
+	if(qtype == 33) // SRV query
 	{
 		assert(!empty(host(hp)));
 		thread_local char srvbuf[512];
@@ -2786,7 +2972,49 @@ ircd::net::dns::cache::get(const hostport &hp,
 			++it;
 		}
 	}
-	else // Deduced A query (for now)
+	else if(qtype == 28) // AAAA query
+	{
+		auto &map{AAAA};
+		const auto &key{rstrip(host(hp), '.')};
+		if(unlikely(empty(key)))
+			return false;
+
+		const auto pit{map.equal_range(key)};
+		if(pit.first == pit.second)
+			return false;
+
+		const auto &now{ircd::time()};
+		for(auto it(pit.first); it != pit.second; )
+		{
+			const auto &rr{it->second};
+
+			// Cached entry is too old, ignore and erase
+			if(rr.ttl < now)
+			{
+				it = map.erase(it);
+				continue;
+			}
+
+			// Cached entry is a cached error, we set the eptr, but also
+			// include the record and increment the count like normal.
+			if(!rr.ip6 && !eptr)
+			{
+				//TODO: we don't cache what the error was, assuming it's
+				//TODO: NXDomain can be incorrect and in bad ways downstream...
+				static const auto rcode{3}; //NXDomain
+				eptr = std::make_exception_ptr(rfc1035::error
+				{
+					"protocol error #%u (cached) :%s", rcode, rfc1035::rcode.at(rcode)
+				});
+			}
+
+			if(count < record.size())
+				record.at(count++) = &rr;
+
+			++it;
+		}
+	}
+	else // A query
 	{
 		auto &map{A};
 		const auto &key{rstrip(host(hp), '.')};
@@ -2871,6 +3099,15 @@ ircd::net::dns::resolver::retry_max
 	{ "default",   4L                               },
 };
 
+/// Number of nameservers which are sent the same query at once. The first
+/// reply wins and the others are discarded.
+decltype(ircd::net::dns::resolver::send_parallel)
+ircd::net::dns::resolver::send_parallel
+{
+	{ "name",     "ircd.net.dns.resolver.send_parallel" },
+	{ "default",   2L                                   },
+};
+
 ircd::net::dns::resolver::resolver()
 :ns{*ircd::ios}
 ,reply
@@ -2899,6 +3136,7 @@ noexcept
 	sendq_context.interrupt();
 	timeout_context.interrupt();
 	assert(tags.empty());
+	assert(pending.empty());
 }
 
 __attribute__((noreturn))
@@ -2975,9 +3213,11 @@ ircd::net::dns::resolver::check_timeouts(const milliseconds &timeout)
 		const auto &id(it->first);
 		auto &tag(it->second);
 		if(check_timeout(id, tag, cutoff))
+		{
+			unindex(tag);
 			it = tags.erase(it);
-		else
-			++it;
+		}
+		else ++it;
 	}
 }
 
@@ -3004,9 +3244,12 @@ ircd::net::dns::resolver::check_timeout(const uint16_t &id,
 		return false;
 	}
 
-	if(!tag.cb)
+	if(!tag.cb && tag.waiters.empty())
 		return true;
 
+	// No further lookups can join this tag; they'll make a fresh query.
+	unindex(tag);
+
 	// Callback gets a fresh stack off this timeout worker ctx's stack.
 	ircd::post([this, id, &tag]
 	{
@@ -3027,7 +3270,7 @@ ircd::net::dns::resolver::check_timeout(const uint16_t &id,
 			log, "DNS timeout id:%u", id
 		};
 
-		tag.cb(std::make_exception_ptr(system_error{ec}), tag.hp, {});
+		call_user(tag, std::make_exception_ptr(system_error{ec}), {});
 		const auto erased(tags.erase(tag.id));
 		assert(erased == 1);
 	});
@@ -3049,20 +3292,120 @@ ircd::net::dns::resolver::operator()(const hostport &hp,
 	// Escape trunk
 	const unwind::exceptional untag{[this, &tag]
 	{
+		unindex(tag);
 		tags.erase(tag.id);
 	}};
 
 	tag.question = make_query(tag.qbuf, tag);
+
+	// When the same question is already in flight the lookup is merged into
+	// that tag and this one is discarded without anything being sent.
+	if(coalesce(tag))
+	{
+		tags.erase(tag.id);
+		return;
+	}
+
 	submit(tag);
 }
 
+/// The coalescing key for a tag is its question section; this is the query
+/// after the header, so it contains the name and type but not the id.
+ircd::string_view
+ircd::net::dns::resolver::key(const tag &tag)
+{
+	if(size(tag.question) <= sizeof(header))
+		return {};
+
+	return string_view
+	{
+		data(tag.question) + sizeof(header), size(tag.question) - sizeof(header)
+	};
+}
+
+/// Attaches the lookup in a fresh tag to an identical query which is already
+/// in flight. Returns true if the tag was merged and must be discarded by the
+/// caller. Otherwise the tag is indexed so subsequent lookups can join it.
+bool
+ircd::net::dns::resolver::coalesce(tag &tag)
+{
+	const auto key
+	{
+		resolver::key(tag)
+	};
+
+	auto it{pending.lower_bound(key)};
+	if(it == end(pending) || it->first != key)
+	{
+		pending.emplace_hint(it, key, tag.id);
+		return false;
+	}
+
+	auto &existing
+	{
+		tags.at(it->second)
+	};
+
+	// The callback semantics have to be identical for the waiters to share
+	// a reply; otherwise this lookup gets its own query.
+	if(existing.opts.cache_result != tag.opts.cache_result ||
+	   existing.opts.nxdomain_exceptions != tag.opts.nxdomain_exceptions)
+		return false;
+
+	hostport hp{tag.hp};
+	hp.host = existing.hp.host;
+	existing.waiters.emplace_back(hp, std::move(tag.cb));
+	tag.cb = {};
+	++coalesced;
+	return true;
+}
+
+void
+ircd::net::dns::resolver::unindex(const tag &tag)
+{
+	const auto it
+	{
+		pending.find(key(tag))
+	};
+
+	if(it != end(pending) && it->second == tag.id)
+		pending.erase(it);
+}
+
+/// Calls back every lookup waiting on this tag. The callbacks are consumed
+/// so nobody is called twice for a tag.
+void
+ircd::net::dns::resolver::call_user(tag &tag,
+                                    std::exception_ptr eptr,
+                                    const vector_view<const rfc1035::record *> &records)
+{
+	auto cb{std::move(tag.cb)};
+	auto waiters{std::move(tag.waiters)};
+	tag.cb = {};
+	tag.waiters.clear();
+
+	if(cb)
+		cb(eptr, tag.hp, records);
+
+	for(auto &waiter : waiters) try
+	{
+		waiter.second(eptr, waiter.first, records);
+	}
+	catch(const std::exception &e)
+	{
+		log.error("resolver tag:%u waiter: %s",
+		          tag.id,
+		          e.what());
+	}
+}
+
 ircd::const_buffer
 ircd::net::dns::resolver::make_query(const mutable_buffer &buf,
                                      const tag &tag)
 const
 {
 	//TODO: Better deduction
-	if(tag.hp.service || tag.opts.srv)
+	if(tag.opts.qtype == 33 || (!tag.opts.qtype && (tag.hp.service || tag.opts.srv)))
 	{
 		thread_local char srvbuf[512];
 		const string_view srvhost
@@ -3074,7 +3417,11 @@ const
 		return rfc1035::make_query(buf, tag.id, question);
 	}
 
-	const rfc1035::question question{host(tag.hp), "A"};
+	const rfc1035::question question
+	{
+		host(tag.hp), tag.opts.qtype?: uint16_t(1)
+	};
+
 	return rfc1035::make_query(buf, tag.id, question);
 }
 
@@ -3123,25 +3470,43 @@ ircd::net::dns::resolver::submit(tag &tag)
 		queue_query(tag);
 }
 
+/// Sends the query to the next send_parallel servers in the rotation. The
+/// first reply to arrive completes the tag; the rest are dropped as unknown.
 void
 ircd::net::dns::resolver::send_query(tag &tag)
-try
 {
-	assert(!server.empty());
-	++server_next %= server.size();
-	const auto &ep
+	if(unlikely(server.empty()))
+		throw error
+		{
+			"No DNS servers available for query"
+		};
+
+	const size_t count
 	{
-		server.at(server_next)
+		std::max(std::min(server.size(), size_t(send_parallel)), 1UL)
 	};
 
-	send_query(ep, tag);
-}
-catch(const std::out_of_range &)
-{
-	throw error
+	size_t sent(0);
+	std::exception_ptr eptr;
+	for(size_t i(0); i < count; ++i) try
 	{
-		"No DNS servers available for query"
-	};
+		++server_next %= server.size();
+		send_query(server.at(server_next), tag);
+		++sent;
+	}
+	catch(const std::exception &e)
+	{
+		eptr = std::current_exception();
+		log.derror("resolver tag:%u send to server #%zu: %s",
+		           tag.id,
+		           server_next,
+		           e.what());
+	}
+
+	if(!sent && eptr)
+		std::rethrow_exception(eptr);
+
+	tag.tries++;
 }
 
 void
@@ -3154,7 +3519,6 @@ ircd::net::dns::resolver::send_query(const ip::udp::endpoint &ep,
 	ns.send_to(asio::const_buffers_1(buf), ep);
 	send_last = now<steady_point>();
 	tag.last = send_last;
-	tag.tries++;
 }
 
 void
@@ -3227,15 +3591,30 @@ try
 {
 	const auto &id{header.id};
 	const auto it{tags.find(id)};
+
+	// Replies from the other nameservers queried in parallel arrive here
+	// after the first one already completed the tag; this is expected.
 	if(it == end(tags))
-		throw error
-		{
-			"DNS reply from %s for unrecognized tag id:%u",
-			string(reply_from),
-			id
-		};
+	{
+		log.debug("DNS reply from %s for unrecognized tag id:%u",
+		          string(reply_from),
+		          id);
+		return;
+	}
 
 	auto &tag{it->second};
+
+	// A belated reply to an earlier query can land on a recycled id; the
+	// question section has to match what this tag actually asked.
+	if(!startswith(body, key(tag)))
+	{
+		log.debug("DNS reply from %s for tag id:%u question mismatch",
+		          string(reply_from),
+		          id);
+		return;
+	}
+
+	unindex(tag);
 	const unwind untag{[this, &it]
 	{
 		tags.erase(it);
@@ -3329,6 +3708,19 @@ try
 			continue;
 		}
 
+		case 28: // AAAA records are inserted into cache
+		{
+			if(!tag.opts.cache_result)
+			{
+				record[i] = new (pos) rfc1035::record::AAAA(an[i]);
+				pos += sizeof(rfc1035::record::AAAA);
+				continue;
+			}
+
+			record[i] = cache.put(qd.at(0), an[i]);
+			continue;
+		}
+
 		case 5:
 		{
 			record[i] = new (pos) rfc1035::record::CNAME(an[i]);
@@ -3361,11 +3753,8 @@ try
 	if(!header.ancount && tag.opts.cache_result)
 		cache.put_error(qd.at(0), header.rcode);
 
-	if(tag.cb)
-	{
-		const vector_view<const rfc1035::record *> records(record, i);
-		tag.cb(std::exception_ptr{}, tag.hp, records);
-	}
+	const vector_view<const rfc1035::record *> records(record, i);
+	call_user(tag, std::exception_ptr{}, records);
 }
 catch(const std::exception &e)
 {
@@ -3376,11 +3765,8 @@ catch(const std::exception &e)
 		          tag.id,
 		          e.what());
 
-	if(tag.cb)
-	{
-		assert(header.rcode != 3 || tag.opts.nxdomain_exceptions);
-		tag.cb(std::current_exception(), tag.hp, {});
-	}
+	assert(header.rcode != 3 || tag.opts.nxdomain_exceptions || (!tag.cb && tag.waiters.empty()));
+	call_user(tag, std::current_exception(), {});
 }
 
 bool
@@ -3404,14 +3790,13 @@ ircd::net::dns::resolver::handle_error(const header &header,
 			};
 
 			// When the user doesn't want an eptr for nxdomain we just make
-			// their callback here and then null the cb pointer so it's not
-			// called again. It is done here because we have a reference to
-			// the cached error record readily accessible.
-			if(!tag.opts.nxdomain_exceptions && tag.cb)
+			// their callback here; call_user() consumes the callbacks so
+			// they're not called again. It is done here because we have a
+			// reference to the cached error record readily accessible.
+			if(!tag.opts.nxdomain_exceptions)
 			{
 				assert(record);
-				tag.cb({}, tag.hp, vector_view<const rfc1035::record *>(&record, 1));
-				tag.cb = {};
+				call_user(tag, {}, vector_view<const rfc1035::record *>(&record, 1));
 			}
 
 			return false;
@@ -12,78 +12,170 @@ decltype(ircd::resource::resources)
 ircd::resource::resources
 {};
 
+decltype(ircd::resource::tree)
+ircd::resource::tree
+{};
+
+namespace ircd
+{
+	static void route_add(resource::node &, const string_view &path, resource &);
+	static bool route_del(resource::node &, const string_view &path, const resource &);
+}
+
+/// Route the path to its resource. The parv buffer supplied by the caller is
+/// filled with the parameters and resized to their count; any which don't
+/// fit are dropped. No allocation is made.
 ircd::resource &
-ircd::resource::find(const string_view &path_)
+ircd::resource::find(const string_view &path,
+                     vector_view<string_view> &parv)
 {
-	const string_view path
-	{
-		rstrip(path_, '/')
-	};
+	const node *n{&tree};
+	const node *dir{nullptr};
+	size_t parc{0}, dir_parc{0};
+	string_view rem{path}, dir_rem;
+	while(n)
+	{
+		// Remember the deepest directory for when the rest doesn't match.
+		if(n->target && n->target->flags & DIRECTORY)
+		{
+			dir = n;
+			dir_parc = parc;
+			dir_rem = rem;
+		}
 
-	auto it
-	{
-		resources.lower_bound(path)
-	};
+		rem = lstrip(rem, '/');
+		if(empty(rem))
+			break;
 
-	if(it == end(resources)) try
-	{
-		--it;
-		if(it == begin(resources) || !startswith(path, it->first))
-			return *resources.at("/");
+		const auto seg
+		{
+			split(rem, '/')
+		};
+
+		const auto it
+		{
+			n->child.find(seg.first)
+		};
+
+		if(it != end(n->child))
+			n = it->second.get();
+		else if(n->param && parc < parv.size())
+		{
+			parv[parc++] = seg.first;
+			n = n->param.get();
+		}
+		else n = nullptr;
+
+		rem = seg.second;
 	}
-	catch(const std::out_of_range &e)
+
+	// Exact match of the whole path
+	if(n && n->target)
 	{
+		parv = vector_view<string_view>
+		{
+			parv.data(), parc
+		};
+
+		return *n->target;
+	}
+
+	if(!dir)
 		throw http::error
 		{
 			http::code::NOT_FOUND
 		};
-	}
 
-	auto rpath{it->first};
-	//assert(!endswith(rpath, '/'));
+	// The directory handles everything under it; the rest of the path is
+	// appended to whatever it captured.
+	const auto stop
+	{
+		tokens(dir_rem, '/', parv.begin() + dir_parc, parv.end())
+	};
 
-	// Exact file or directory match
-	if(path == rpath)
-		return *it->second;
+	parv = vector_view<string_view>
+	{
+		parv.data(), stop
+	};
 
-	// Directories handle all paths under them.
-	if(!startswith(path, rpath))
+	return *dir->target;
+}
+
+void
+ircd::route_add(resource::node &root,
+                const string_view &path,
+                resource &resource)
+{
+	auto *n{&root};
+	tokens(path, '/', [&n]
+	(const string_view &seg)
 	{
-		// Walk the iterator back to find if there is a directory prefixing this path.
-		if(it == begin(resources))
-			throw http::error
-			{
-				http::code::NOT_FOUND
-			};
+		auto &next
+		{
+			startswith(seg, ':')?
+				n->param:
+				n->child[std::string(seg)]
+		};
 
-		--it;
-		rpath = it->first;
-		if(!startswith(path, rpath))
-			throw http::error
-			{
-				http::code::NOT_FOUND
-			};
-	}
+		if(!next)
+			next = std::make_unique<resource::node>();
 
-	// Check if the resource is a directory; if not, it can only
-	// handle exact path matches.
-	if(~it->second->flags & it->second->DIRECTORY && path != rpath)
-		throw http::error
+		n = next.get();
+	});
+
+	if(n->target)
+		throw resource::error
 		{
-			http::code::NOT_FOUND
+			"resource \"%s\" conflicts with \"%s\"",
+			resource.path,
+			n->target->path
 		};
 
-	if(it->second->flags & it->second->DIRECTORY)
+	n->target = &resource;
+}
+
+/// Clear the resource from its node and prune every node left with nothing
+/// under it. Returns true when the node itself can be pruned by the caller.
+bool
+ircd::route_del(resource::node &n,
+                const string_view &path,
+                const resource &resource)
+{
+	const auto rem
 	{
-		const auto rem(lstrip(path, rpath));
-		if(!empty(rem) && !startswith(rem, '/'))
-			throw http::error
+		lstrip(path, '/')
+	};
+
+	if(empty(rem))
+	{
+		if(n.target == &resource)
+			n.target = nullptr;
+	}
+	else
+	{
+		const auto seg
+		{
+			split(rem, '/')
+		};
+
+		if(startswith(seg.first, ':'))
+		{
+			if(n.param && route_del(*n.param, seg.second, resource))
+				n.param.reset();
+		}
+		else
+		{
+			const auto it
 			{
-				http::code::NOT_FOUND
+				n.child.find(seg.first)
 			};
+
+			if(it != end(n.child) && route_del(*it->second, seg.second, resource))
+				n.child.erase(it);
+		}
 	}
 
-	return *it->second;
+	return !n.target && !n.param && n.child.empty();
 }
 
 //
@@ -125,6 +217,7 @@ ircd::resource::resource(const string_view &path,
 	};
 }()}
 {
+	route_add(tree, this->path, *this);
 	log::debug
 	{
 		"Registered resource \"%s\"", path.empty()? string_view{"/"} : this->path
@@ -134,6 +227,7 @@ ircd::resource::resource(const string_view &path,
 ircd::resource::~resource()
 noexcept
 {
+	route_del(tree, path, *this);
 	log::debug
 	{
 		"Unregistered resource \"%s\"", path.empty()? string_view{"/"} : path
@@ -152,6 +246,11 @@ ircd::authenticate(client &client,
                    resource::method &method,
                    resource::request &request)
 {
+	const trace::span span
+	{
+		"auth"
+	};
+
 	request.access_token =
 	{
 		request.query["access_token"]
@@ -175,15 +274,40 @@ ircd::authenticate(client &client,
 			"Credentials for this method are required but missing."
 		};
 
-	return m::user::tokens.get(std::nothrow, "ircd.access_token", request.access_token, [&request]
+	if(m::user::token_cache.get(request.access_token, [&request]
+	(const m::user::id &user_id)
+	{
+		request.user_id = user_id;
+	}))
+		return true;
+
+	// The lookup yields; a logout meanwhile must not be undone by the set().
+	const auto epoch
+	{
+		m::user::token_cache.epoch
+	};
+
+	bool found{false};
+	m::user::tokens.get(std::nothrow, "ircd.access_token", request.access_token, [&request, &found]
 	(const m::event &event)
 	{
+		// A logged out token is replaced in the state by a tombstone.
+		if(json::get<"content"_>(event).get<bool>("revoked"))
+			return;
+
 		// The user sent this access token to the tokens room
 		request.user_id = m::user::id
 		{
 			at<"sender"_>(event)
 		};
+
+		found = true;
 	});
+
+	if(found)
+		m::user::token_cache.set(request.access_token, request.user_id, epoch);
+
+	return found;
 }
 
 bool
@@ -192,6 +316,11 @@ ircd::verify_origin(client &client,
                     resource::request &request)
 try
 {
+	const trace::span span
+	{
+		"origin"
+	};
+
 	const m::request::x_matrix x_matrix
 	{
 		request.head.authorization
@@ -228,6 +357,15 @@ catch(const std::exception &e)
 	};
 }
 
+/// Longest a request waits behind the queue of its class before its handler
+/// runs anyway; see ctx::pool::requeue().
+ircd::conf::item<ircd::milliseconds>
+requeue_timeout
+{
+	{ "name",     "ircd.resource.requeue.timeout" },
+	{ "default",  2000L                           },
+};
+
 ircd::conf::item<ircd::seconds>
 cache_warmup_time
 {
@@ -265,7 +403,8 @@ catch(const std::exception &e)
 void
 ircd::resource::operator()(client &client,
                            const http::request::head &head,
-                           const string_view &content_partial)
+                           const string_view &content_partial,
+                           const vector_view<string_view> &parv)
 {
 	// Find the method or METHOD_NOT_ALLOWED
 	auto &method
@@ -273,6 +412,36 @@ ircd::resource::operator()(client &client,
 		operator[](head.method)
 	};
 
+	// The request was dispatched before its method was known. If it belongs
+	// to a lower class it now waits behind the work queued ahead of that
+	// class before the handler runs, for a bounded time and only while
+	// another context is free to reach it; see handle_client_ready().
+	const auto prio
+	{
+		method.opts.flags & method.PRIORITY_HIGH? ctx::pool::HIGH:
+		method.opts.flags & method.PRIORITY_BULK? ctx::pool::BULK:
+		                                          ctx::pool::NORMAL
+	};
+
+	if(prio > client.prio)
+		client::context.requeue(prio, requeue_timeout);
+
+	client.prio = prio;
+
+	// Content-Encoding for the response, if the client accepts one we have
+	// and neither the method nor the conf has compression disabled.
+	const int64_t level
+	{
+		method.opts.compress?
+			int64_t(method.opts.compress):
+			int64_t(response::compress_level)
+	};
+
+	client.encoding_level = std::min(level, 127L);
+	client.encoding = level > 0?
+		compress::negotiate(head.accept_encoding):
+		compress::NONE;
+
 	// Bail out if the method limited the amount of content and it was exceeded.
 	if(head.content_length > method.opts.payload_max)
 		throw http::error
@@ -377,16 +546,19 @@ ircd::resource::operator()(client &client,
 	const unwind clear_request{[&client]
 	{
 		client.request = {};
+		client.encoding = compress::NONE;
 	}};
 
-	const auto pathparm
+	// The parameters were captured while routing; see resource::find().
+	const size_t parc
 	{
-		lstrip(head.path, this->path)
+		std::min(parv.size(), sizeof(client.request.param) / sizeof(string_view))
 	};
 
+	std::copy(parv.begin(), parv.begin() + parc, client.request.param);
 	client.request.parv =
 	{
-		client.request.param, tokens(pathparm, '/', client.request.param)
+		client.request.param, parc
 	};
 
 	if(method.opts.flags & method.REQUIRES_AUTH)
@@ -414,6 +586,12 @@ ircd::resource::operator()(client &client,
 		cache_warm_origin(client.request.origin);
 	}
 
+	++method.stats->requests;
+	const unwind record{[&method, &client]
+	{
+		method.stats->time(client.timer.at<microseconds>().count());
+	}};
+
 	handle_request(client, method, client.request);
 }
 
@@ -520,6 +698,7 @@ ircd::resource::method::method(struct resource &resource,
 ,resource{&resource}
 ,function{handler}
 ,opts{opts}
+,stats{std::make_unique<struct stats>(*this)}
 ,methods_it{[this, &name]
 {
 	const auto iit
@@ -547,6 +726,27 @@ noexcept
 {
 }
 
+//
+// resource::method::stats
+//
+
+ircd::resource::method::stats::stats(const method &m)
+:name
+{
+	fmt::snstringf{256, "ircd.resource.%s.%s.requests", m.resource->path, m.name},
+	fmt::snstringf{256, "ircd.resource.%s.%s.time_us", m.resource->path, m.name},
+}
+,requests
+{
+	string_view{name[0]}, "Requests routed to this method."
+}
+,time
+{
+	string_view{name[1]}, "Microseconds from receipt of a request to the end of its handler."
+}
+{
+}
+
 ircd::resource::response
 ircd::resource::method::operator()(client &client,
                                    request &request)
@@ -566,9 +766,19 @@ catch(const std::bad_function_call &e)
 // resource::response::chunked
 //
 
+namespace ircd
+{
+	static bool compressible(const string_view &content_type);
+	static compress::type encoding(const client &, const string_view &content_type, const size_t &content_length);
+	static void write_encoding(window_buffer &, const compress::type &);
+	static void write_headers(window_buffer &, const string_view &headers, const compress::type &);
+	static size_t write_chunk(client &, const vector_view<const const_buffer> &);
+}
+
 ircd::resource::response::chunked::chunked(chunked &&other)
 noexcept
 :c{std::move(other.c)}
+,deflater{std::move(other.deflater)}
 {
 	other.c = nullptr;
 }
@@ -600,11 +810,23 @@ ircd::resource::response::chunked::chunked(client &client,
 {
 	assert(!empty(content_type));
 
+	const auto encoding
+	{
+		ircd::encoding(client, content_type, size_t(-1))
+	};
+
+	if(encoding != compress::NONE)
+		deflater = compress::deflater
+		{
+			encoding, client.encoding_level
+		};
+
 	thread_local char buffer[4_KiB];
 	window_buffer sb{buffer};
 	{
 		const critical_assertion ca;
 		http::write(sb, headers);
+		write_encoding(sb, encoding);
 	}
 
 	response
@@ -619,9 +841,36 @@ ircd::resource::response::chunked::chunked(client &client,
                                            const string_view &headers)
 :c{&client}
 {
+	const auto encoding
+	{
+		ircd::encoding(client, content_type, size_t(-1))
+	};
+
+	if(encoding == compress::NONE)
+	{
+		response
+		{
+			client, code, content_type, size_t(-1), headers
+		};
+
+		return;
+	}
+
+	deflater = compress::deflater
+	{
+		encoding, client.encoding_level
+	};
+
+	thread_local char buffer[4_KiB];
+	window_buffer sb{buffer};
+	{
+		const critical_assertion ca;
+		write_headers(sb, headers, encoding);
+	}
+
 	response
 	{
-		client, code, content_type, size_t(-1), headers
+		client, code, content_type, size_t(-1), string_view{sb.completed()}
 	};
 }
 
@@ -652,8 +901,19 @@ ircd::resource::response::chunked::finish()
 	return true;
 }
 
+/// An empty chunk terminates the response. When the response is compressed
+/// the chunk is fed to the deflater instead, and only what it produces is
+/// written; this may be nothing until enough input has accumulated.
 size_t
 ircd::resource::response::chunked::write(const const_buffer &chunk)
+{
+	return write(vector_view<const const_buffer>(&chunk, 1));
+}
+
+/// Write several buffers as one chunk without first copying them together;
+/// the chunk is terminal if they're all empty.
+size_t
+ircd::resource::response::chunked::write(const vector_view<const const_buffer> &chunk)
 try
 {
 	size_t ret{0};
@@ -661,11 +921,33 @@ try
 	if(!c)
 		return ret;
 
-	//TODO: bring iov from net::socket -> net::write_() -> client::write_()
-	char headbuf[32];
-	ret += c->write_all(http::writechunk(headbuf, size(chunk)));
-	ret += size(chunk)? c->write_all(chunk) : 0UL;
-	ret += c->write_all("\r\n"_sv);
+	if(deflater.type == compress::NONE)
+		return write_chunk(*c, chunk);
+
+	const auto sink{[this, &ret]
+	(const const_buffer &buf)
+	{
+		ret += write_chunk(*c, vector_view<const const_buffer>(&buf, 1));
+	}};
+
+	const auto out_before(deflater.out);
+	for(const auto &buf : chunk)
+		if(!empty(buf))
+			deflater(buf, sink);
+
+	const size_t in
+	{
+		buffer::size(chunk)
+	};
+
+	if(!in)
+		deflater.finish(sink);
+
+	compress_in += in;
+	compress_out += deflater.out - out_before;
+	if(!in)
+		ret += write_chunk(*c, {});
+
 	return ret;
 }
 catch(...)
@@ -674,10 +956,157 @@ catch(...)
 	throw;
 }
 
+/// The chunk size line, the chunk and its terminator are given to the socket
+/// in one gather write.
+size_t
+ircd::write_chunk(client &client,
+                  const vector_view<const const_buffer> &chunk)
+{
+	static constexpr const size_t GATHER_MAX {14};
+	const size_t chunk_size
+	{
+		buffer::size(chunk)
+	};
+
+	char headbuf[32];
+	const const_buffer head
+	{
+		http::writechunk(headbuf, chunk_size)
+	};
+
+	if(chunk.size() > GATHER_MAX)
+	{
+		size_t ret{0};
+		ret += client.write_all(head);
+		ret += client.write_all(chunk);
+		ret += client.write_all("\r\n"_sv);
+		return ret;
+	}
+
+	const_buffer iov[GATHER_MAX + 2];
+	size_t n(0);
+	iov[n++] = head;
+	for(const auto &buf : chunk)
+		if(!empty(buf))
+			iov[n++] = buf;
+
+	iov[n++] = "\r\n"_sv;
+	return client.write_all(vector_view<const const_buffer>{iov, n});
+}
+
 //
 // resource::response
 //
 
+decltype(ircd::resource::response::compress_threshold)
+ircd::resource::response::compress_threshold
+{
+	{ "name",     "ircd.resource.compress.threshold" },
+	{ "default",  long(8_KiB)                        },
+};
+
+decltype(ircd::resource::response::compress_level)
+ircd::resource::response::compress_level
+{
+	{ "name",     "ircd.resource.compress.level" },
+	{ "default",  3L                             },
+};
+
+decltype(ircd::resource::response::compress_in)
+ircd::resource::response::compress_in
+{
+	"ircd.resource.compress.in",
+	"Response content bytes given to the compressor.",
+};
+
+decltype(ircd::resource::response::compress_out)
+ircd::resource::response::compress_out
+{
+	"ircd.resource.compress.out",
+	"Compressed response content bytes sent.",
+};
+
+/// Content-Encoding to use for a response to the client's current request.
+/// A content_length of -1 is a chunked response of unknown length; these are
+/// large by nature so the threshold doesn't apply.
+ircd::compress::type
+ircd::encoding(const client &client,
+               const string_view &content_type,
+               const size_t &content_length)
+{
+	if(client.encoding == compress::NONE)
+		return compress::NONE;
+
+	if(content_length < size_t(resource::response::compress_threshold))
+		return compress::NONE;
+
+	if(!compressible(content_type))
+		return compress::NONE;
+
+	return client.encoding;
+}
+
+/// Media is already compressed (or isn't worth it); only text-like content
+/// which makes up the API is.
+bool
+ircd::compressible(const string_view &content_type)
+{
+	const auto &mime
+	{
+		split(split(content_type, ';').first, '/')
+	};
+
+	return mime.first == "text" ||
+	       mime.second == "json" ||
+	       mime.second == "javascript" ||
+	       mime.second == "xml";
+}
+
+void
+ircd::write_encoding(window_buffer &sb,
+                     const compress::type &encoding)
+{
+	if(encoding == compress::NONE)
+		return;
+
+	const http::header headers[]
+	{
+		{ "Content-Encoding",  compress::reflect(encoding) },
+		{ "Vary",              "Accept-Encoding"            },
+	};
+
+	if(unlikely(http::serialized(vector_view<const http::header>(headers)) > sb.remaining()))
+		throw resource::error
+		{
+			"No room for the %s content encoding headers", compress::reflect(encoding)
+		};
+
+	http::write(sb, vector_view<const http::header>(headers));
+}
+
+/// Copies the already serialized headers and appends those for the encoding.
+/// Throws rather than truncate when sb is too small.
+void
+ircd::write_headers(window_buffer &sb,
+                    const string_view &headers,
+                    const compress::type &encoding)
+{
+	if(unlikely(size(headers) > sb.remaining()))
+		throw resource::error
+		{
+			"%zu bytes of headers exceed the %zu bytes available",
+			size(headers),
+			sb.remaining()
+		};
+
+	sb([&headers](const mutable_buffer &buf)
+	{
+		return copy(buf, headers);
+	});
+
+	write_encoding(sb, encoding);
+}
+
 ircd::resource::response::response(client &client,
                                    const http::code &code)
 :response{client, json::object{json::empty_object}, code}
@@ -710,27 +1139,25 @@ ircd::resource::response::response(client &client,
                                    const json::value &value)
 try
 {
-	const auto size
-	{
-		serialized(value)
-	};
-
-	const unique_buffer<mutable_buffer> buffer
+	unique_buffer<mutable_buffer> buffer;
+	string_view str;
 	{
-		size
-	};
+		const trace::span span{"json"};
+		buffer = unique_buffer<mutable_buffer>{serialized(value)};
+		str = stringify(mutable_buffer{buffer}, value);
+	}
 
 	switch(type(value))
 	{
 		case json::ARRAY:
 		{
-			response(client, json::array{stringify(mutable_buffer{buffer}, value)}, code);
+			response(client, json::array{str}, code);
 			return;
 		}
 
 		case json::OBJECT:
 		{
-			response(client, json::object{stringify(mutable_buffer{buffer}, value)}, code);
+			response(client, json::object{str}, code);
 			return;
 		}
 
@@ -753,20 +1180,13 @@ ircd::resource::response::response(client &client,
                                    const json::members &members)
 try
 {
-	const auto size
+	unique_buffer<mutable_buffer> buffer;
+	json::object object;
 	{
-		serialized(members)
-	};
-
-	const unique_buffer<mutable_buffer> buffer
-	{
-		size
-	};
-
-	const json::object object
-	{
-		stringify(mutable_buffer{buffer}, members)
-	};
+		const trace::span span{"json"};
+		buffer = unique_buffer<mutable_buffer>{serialized(members)};
+		object = json::object{stringify(mutable_buffer{buffer}, members)};
+	}
 
 	response(client, object, code);
 }
@@ -783,20 +1203,13 @@ ircd::resource::response::response(client &client,
                                    const http::code &code)
 try
 {
-	const auto size
+	unique_buffer<mutable_buffer> buffer;
+	json::object object;
 	{
-		serialized(members)
-	};
-
-	const unique_buffer<mutable_buffer> buffer
-	{
-		size
-	};
-
-	const json::object object
-	{
-		stringify(mutable_buffer{buffer}, members)
-	};
+		const trace::span span{"json"};
+		buffer = unique_buffer<mutable_buffer>{serialized(members)};
+		object = json::object{stringify(mutable_buffer{buffer}, members)};
+	}
 
 	response(client, object, code);
 }
@@ -865,34 +1278,64 @@ ircd::resource::response::response(client &client,
 {
 	assert(empty(content) || !empty(content_type));
 
-	// Head gets sent
-	response
+	const auto encoding
 	{
-		client, code, content_type, size(content), headers
+		ircd::encoding(client, content_type, size(content))
 	};
 
-	// All content gets sent
-	const size_t written
+	if(encoding != compress::NONE)
 	{
-		client.write_all(content)
-	};
+		const unique_buffer<mutable_buffer> buf
+		{
+			compress::bound(encoding, size(content))
+		};
+
+		const string_view compressed
+		{
+			compress::deflate(buf, content, encoding, client.encoding_level)
+		};
+
+		compress_in += size(content);
+		compress_out += size(compressed);
 
-	assert(written == size(content));
+		thread_local char buffer[4_KiB];
+		window_buffer sb{buffer};
+		{
+			const critical_assertion ca;
+			write_headers(sb, headers, encoding);
+		}
+
+		response
+		{
+			client, code, content_type, size(compressed), string_view{sb.completed()}, compressed
+		};
+
+		return;
+	}
+
+	// Head and all content get sent together
+	response
+	{
+		client, code, content_type, size(content), headers, content
+	};
 }
 
 ircd::resource::response::response(client &client,
                                    const http::code &code,
                                    const string_view &content_type,
                                    const size_t &content_length,
-                                   const string_view &headers)
+                                   const string_view &headers,
+                                   const const_buffer &content)
 {
 	assert(!content_length || !empty(content_type));
+	assert(empty(content) || size(content) == content_length);
 
 	const auto request_time
 	{
 		client.timer.at<microseconds>().count()
 	};
 
+	client::stats::request_time(request_time);
 	const fmt::bsprintf<64> rtime
 	{
 		"%zd$us", request_time
@@ -923,9 +1366,16 @@ ircd::resource::response::response(client &client,
 			"HTTP headers too large for buffer of %zu", sizeof(head_buf)
 		};
 
+	// Any content is given to the socket with the head in one gather write
+	// rather than staged behind it in a buffer.
+	const const_buffer iov[]
+	{
+		head.completed(), content
+	};
+
 	const size_t written
 	{
-		client.write_all(head.completed())
+		client.write_all(vector_view<const const_buffer>(iov))
 	};
 
 	#ifdef RB_DEBUG
@@ -955,5 +1405,5 @@ ircd::resource::response::response(client &client,
 	};
 	#endif
 
-	assert(written == size(head.completed()));
+	assert(written == size(head.completed()) + size(content));
 }
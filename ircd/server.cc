@@ -33,6 +33,48 @@ ircd::server::log
 	"server", 'S'
 };
 
+//
+// stats
+//
+
+decltype(ircd::server::stats::read_bytes)
+ircd::server::stats::read_bytes
+{
+	"ircd.server.read_bytes",
+	"Bytes received from all peers.",
+};
+
+decltype(ircd::server::stats::write_bytes)
+ircd::server::stats::write_bytes
+{
+	"ircd.server.write_bytes",
+	"Bytes sent to all peers.",
+};
+
+decltype(ircd::server::stats::peers)
+ircd::server::stats::peers
+{
+	"ircd.server.peers",
+	"Peers known.",
+	[] { return int64_t(peer_count()); }
+};
+
+decltype(ircd::server::stats::links)
+ircd::server::stats::links
+{
+	"ircd.server.links",
+	"Links to all peers.",
+	[] { return int64_t(link_count()); }
+};
+
+decltype(ircd::server::stats::tags)
+ircd::server::stats::tags
+{
+	"ircd.server.tags",
+	"Requests queued or in flight on all links.",
+	[] { return int64_t(tag_count()); }
+};
+
 ircd::conf::item<ircd::seconds>
 close_all_timeout
 {
@@ -340,6 +382,7 @@ ircd::server::submit(const hostport &hostport,
 
 	assert(request.tag == nullptr);
 	auto &peer(server::get(hostport));
+	request.submitted = now<steady_point>();
 	peer.submit(request);
 }
 
@@ -1462,6 +1505,7 @@ ircd::server::link::process_write_next(const const_buffer &buffer)
 
 	assert(peer);
 	peer->write_bytes += bytes;
+	stats::write_bytes += bytes;
 	return written;
 }
 
@@ -1670,6 +1714,7 @@ ircd::server::link::read(const mutable_buffer &buf)
 
 	assert(peer);
 	peer->read_bytes += received;
+	stats::read_bytes += received;
 
 	assert(received);
 	return const_buffer
@@ -1699,6 +1744,7 @@ ircd::server::link::discard_read()
 
 	assert(peer);
 	peer->read_bytes += discarded;
+	stats::read_bytes += discarded;
 
 	// Shouldn't ever be hit because the read() within discard() throws
 	// the pending error like an eof.
@@ -2314,6 +2360,18 @@ ircd::server::tag::read_head(const const_buffer &buffer,
 	state.status = http::status(head.status);
 	state.content_length = head.content_length;
 
+	// The content is received as-is and decoded once complete; see
+	// tag::inflate_content().
+	if(head.content_encoding && !iequals(head.content_encoding, "identity"_sv))
+	{
+		state.encoding = compress::find(head.content_encoding);
+		if(state.encoding == compress::NONE)
+			throw error
+			{
+				"Unsupported content-encoding '%s'", head.content_encoding
+			};
+	}
+
 	// Proffer the HTTP head to the peer instance which owns the link working
 	// this tag so it can learn from any header data.
 	assert(link.peer);
@@ -3185,6 +3243,16 @@ ircd::server::tag::set_value(args&&... a)
 		std::forward<args>(a)...
 	};
 
+	if(state.encoding != compress::NONE) try
+	{
+		inflate_content();
+	}
+	catch(...)
+	{
+		set_exception(std::current_exception());
+		return;
+	}
+
 	assert(request->opt);
 	if(request->opt->http_exceptions && code >= http::code(300))
 	{
@@ -3200,6 +3268,77 @@ ircd::server::tag::set_value(args&&... a)
 	p.set_value(code);
 }
 
+/// Undo the Content-Encoding of the completed response. The result replaces
+/// in.dynamic and in.content is pointed at it, whether or not the user had
+/// supplied their own content buffer. Discontiguous chunks are fed through
+/// in order and the result is contiguous. The output is written straight
+/// into the buffer which becomes in.dynamic; it starts at a guess from the
+/// encoded size and doubles when full, up to content_length_maxalloc.
+void
+ircd::server::tag::inflate_content()
+{
+	assert(request);
+	assert(request->opt);
+	auto &in(request->in);
+	const size_t &max
+	{
+		request->opt->content_length_maxalloc
+	};
+
+	size_t encoded(size(in.content));
+	for(const auto &chunk : in.chunks)
+		encoded += size(chunk);
+
+	unique_buffer<mutable_buffer> buf
+	{
+		std::min(std::max(encoded * 4, size_t(4_KiB)), max)
+	};
+
+	size_t len(0);
+	compress::inflater inflater
+	{
+		state.encoding
+	};
+
+	const auto sink{[&buf, &len, &max]
+	(const const_buffer &out)
+	{
+		if(unlikely(len + size(out) > max))
+			throw error
+			{
+				"Decoded content exceeds the maximum of %zu bytes", max
+			};
+
+		if(len + size(out) > size(buf))
+		{
+			unique_buffer<mutable_buffer> next
+			{
+				std::min(std::max(size(buf) * 2, len + size(out)), max)
+			};
+
+			copy(next, const_buffer{data(buf), len});
+			buf = std::move(next);
+		}
+
+		len += copy(mutable_buffer{data(buf) + len, size(buf) - len}, out);
+	}};
+
+	if(!in.chunks.empty())
+		for(const auto &chunk : in.chunks)
+			inflater(chunk, sink);
+	else
+		inflater(in.content, sink);
+
+	in.chunks.clear();
+	in.dynamic = std::move(buf);
+	in.content = mutable_buffer
+	{
+		data(in.dynamic), len
+	};
+
+	state.encoding = compress::NONE;
+}
+
 template<class... args>
 void
 ircd::server::tag::set_exception(args&&... a)
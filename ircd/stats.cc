@@ -0,0 +1,312 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::stats
+{
+	static string_view metric_name(const mutable_buffer &, const string_view &);
+	static void prometheus(std::ostream &, const string_view &, const counter &);
+	static void prometheus(std::ostream &, const string_view &, const gauge &);
+	static void prometheus(std::ostream &, const string_view &, const histogram &);
+}
+
+/// Linkage for the list of all metrics. This unit is near the front of the
+/// static initialization order so items anywhere else can register.
+template<>
+decltype(ircd::instance_list<ircd::stats::item>::list)
+ircd::instance_list<ircd::stats::item>::list
+{};
+
+ircd::stats::item &
+ircd::stats::get(const string_view &name)
+{
+	auto *const ret
+	{
+		find(name)
+	};
+
+	if(!ret)
+		throw not_found
+		{
+			"No stats item named '%s'", name
+		};
+
+	return *ret;
+}
+
+ircd::stats::item *
+ircd::stats::find(const string_view &name)
+noexcept
+{
+	const auto &list
+	{
+		item::list
+	};
+
+	const auto it
+	{
+		std::find_if(begin(list), end(list), [&name]
+		(const item *const &ptr)
+		{
+			return ptr->name == name;
+		})
+	};
+
+	return it != end(list)? *it : nullptr;
+}
+
+ircd::string_view
+ircd::stats::reflect(const type &type)
+{
+	switch(type)
+	{
+		case type::COUNTER:     return "counter";
+		case type::GAUGE:       return "gauge";
+		case type::HISTOGRAM:   return "histogram";
+	}
+
+	return "untyped";
+}
+
+//
+// export
+//
+
+/// Render every registered item in the Prometheus text exposition format
+/// (version 0.0.4).
+std::ostream &
+ircd::stats::prometheus(std::ostream &s)
+{
+	for(const auto *const &ptr : item::list)
+	{
+		char buf[128];
+		const string_view name
+		{
+			metric_name(buf, ptr->name)
+		};
+
+		if(ptr->help)
+			s << "# HELP " << name << ' ' << ptr->help << '\n';
+
+		s << "# TYPE " << name << ' ' << reflect(ptr->type) << '\n';
+		switch(ptr->type)
+		{
+			case type::COUNTER:
+				prometheus(s, name, dynamic_cast<const counter &>(*ptr));
+				continue;
+
+			case type::GAUGE:
+				prometheus(s, name, dynamic_cast<const gauge &>(*ptr));
+				continue;
+
+			case type::HISTOGRAM:
+				prometheus(s, name, dynamic_cast<const histogram &>(*ptr));
+				continue;
+		}
+	}
+
+	return s;
+}
+
+void
+ircd::stats::prometheus(std::ostream &s,
+                        const string_view &name,
+                        const counter &item)
+{
+	s << name << ' ' << item.get() << '\n';
+}
+
+void
+ircd::stats::prometheus(std::ostream &s,
+                        const string_view &name,
+                        const gauge &item)
+{
+	s << name << ' ' << item.get() << '\n';
+}
+
+/// Buckets are cumulative in this format. Buckets above the highest one with
+/// any observations are elided save for the mandatory +Inf.
+void
+ircd::stats::prometheus(std::ostream &s,
+                        const string_view &name,
+                        const histogram &item)
+{
+	size_t top(0);
+	for(size_t i(0); i < item.BUCKETS; ++i)
+		if(item.bucket[i].load(std::memory_order_relaxed))
+			top = i;
+
+	uint64_t cumulative(0);
+	for(size_t i(0); i <= top && i < item.BUCKETS - 1; ++i)
+	{
+		cumulative += item.bucket[i].load(std::memory_order_relaxed);
+		s << name << "_bucket{le=\"" << item.upper(i) << "\"} " << cumulative << '\n';
+	}
+
+	s << name << "_bucket{le=\"+Inf\"} " << item.count.load(std::memory_order_relaxed) << '\n';
+	s << name << "_sum " << item.sum.load(std::memory_order_relaxed) << '\n';
+	s << name << "_count " << item.count.load(std::memory_order_relaxed) << '\n';
+}
+
+/// Condensed listing for the console, optionally of items with names
+/// starting with prefix.
+std::ostream &
+ircd::stats::pretty(std::ostream &s,
+                    const string_view &prefix)
+{
+	for(const auto *const &ptr : item::list)
+	{
+		if(!startswith(ptr->name, prefix))
+			continue;
+
+		s << std::left << std::setw(48) << ptr->name
+		  << ' ' << std::setw(9) << reflect(ptr->type)
+		  << ' ';
+
+		switch(ptr->type)
+		{
+			case type::COUNTER:
+				s << dynamic_cast<const counter &>(*ptr).get();
+				break;
+
+			case type::GAUGE:
+				s << dynamic_cast<const gauge &>(*ptr).get();
+				break;
+
+			case type::HISTOGRAM:
+			{
+				const auto &h(dynamic_cast<const histogram &>(*ptr));
+				const auto count(h.count.load(std::memory_order_relaxed));
+				s << "count " << count
+				  << " mean " << (count? h.sum.load(std::memory_order_relaxed) / count : 0UL)
+				  << " p50 " << h.percentile(0.50)
+				  << " p99 " << h.percentile(0.99);
+				break;
+			}
+		}
+
+		s << '\n';
+	}
+
+	return s;
+}
+
+/// Prometheus metric names are restricted to [a-zA-Z0-9_:]
+ircd::string_view
+ircd::stats::metric_name(const mutable_buffer &buf,
+                         const string_view &name)
+{
+	const size_t len
+	{
+		std::min(size(name), size(buf))
+	};
+
+	std::transform(begin(name), begin(name) + len, begin(buf), []
+	(const char &c)
+	{
+		return std::isalnum(c) || c == ':'? c : '_';
+	});
+
+	return { data(buf), len };
+}
+
+//
+// item
+//
+
+ircd::stats::item::item(const enum type &type,
+                        const string_view &name,
+                        const string_view &help)
+:name{name}
+,help{help}
+,type{type}
+{
+	assert(!name.empty());
+}
+
+ircd::stats::item::~item()
+noexcept
+{
+}
+
+//
+// counter
+//
+
+ircd::stats::counter::counter(const string_view &name,
+                              const string_view &help)
+:item{type::COUNTER, name, help}
+{
+}
+
+ircd::stats::counter::counter(const string_view &name,
+                              const string_view &help,
+                              closure fetch)
+:item{type::COUNTER, name, help}
+,fetch{std::move(fetch)}
+{
+}
+
+//
+// gauge
+//
+
+ircd::stats::gauge::gauge(const string_view &name,
+                          const string_view &help)
+:item{type::GAUGE, name, help}
+{
+}
+
+ircd::stats::gauge::gauge(const string_view &name,
+                          const string_view &help,
+                          closure fetch)
+:item{type::GAUGE, name, help}
+,fetch{std::move(fetch)}
+{
+}
+
+//
+// histogram
+//
+
+ircd::stats::histogram::histogram(const string_view &name,
+                                  const string_view &help)
+:item{type::HISTOGRAM, name, help}
+{
+}
+
+/// Estimate of the value at the given quantile [0.0, 1.0]; the result is the
+/// upper bound of the bucket containing that rank.
+uint64_t
+ircd::stats::histogram::percentile(const double &p)
+const
+{
+	const uint64_t total
+	{
+		count.load(std::memory_order_relaxed)
+	};
+
+	if(!total)
+		return 0;
+
+	const uint64_t rank
+	{
+		std::max(uint64_t(std::ceil(p * total)), 1UL)
+	};
+
+	uint64_t cumulative(0);
+	for(size_t i(0); i < BUCKETS; ++i)
+	{
+		cumulative += bucket[i].load(std::memory_order_relaxed);
+		if(cumulative >= rank)
+			return upper(i);
+	}
+
+	return upper(BUCKETS - 1);
+}
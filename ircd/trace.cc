@@ -0,0 +1,181 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+namespace ircd::trace
+{
+	static void retain(const sample &);
+
+	extern stats::counter slow_requests;
+}
+
+decltype(ircd::trace::slow)
+ircd::trace::slow
+{
+	{ "name",     "ircd.trace.slow" },
+	{ "default",  250L              },
+};
+
+decltype(ircd::trace::slow_max)
+ircd::trace::slow_max
+{
+	{ "name",     "ircd.trace.slow_max" },
+	{ "default",  32L                   },
+};
+
+decltype(ircd::trace::slows)
+ircd::trace::slows
+{};
+
+decltype(ircd::trace::slow_requests)
+ircd::trace::slow_requests
+{
+	"ircd.trace.slow_requests",
+	"Requests exceeding ircd.trace.slow retained for inspection.",
+};
+
+/// Accumulate a measurement taken elsewhere into the request attached to
+/// the current ctx (if any). This is for sections which can't be scoped
+/// with a span on the stack.
+void
+ircd::trace::add(const string_view &name,
+                 const nanoseconds &time,
+                 const uint64_t &yields)
+{
+	auto *const req
+	{
+		current()
+	};
+
+	if(!req)
+		return;
+
+	auto *const total
+	{
+		req->get(name)
+	};
+
+	if(unlikely(!total))
+	{
+		++req->dropped;
+		return;
+	}
+
+	total->count++;
+	total->yields += yields;
+	total->time += time;
+	total->max = std::max(total->max, time);
+}
+
+void
+ircd::trace::retain(const sample &sample)
+{
+	while(!slows.empty() && slows.size() >= size_t(slow_max))
+		slows.pop_front();
+
+	if(size_t(slow_max))
+		slows.emplace_back(sample);
+
+	++slow_requests;
+}
+
+//
+// span
+//
+
+ircd::trace::span::span(const string_view &name)
+:name{name}
+{
+	if(!req)
+		return;
+
+	start = now<steady_point>();
+	yields_start = ctx::yields(ctx::cur());
+}
+
+ircd::trace::span::~span()
+noexcept
+{
+	if(!req)
+		return;
+
+	// The request attached to this ctx must still be the one we started
+	// with; spans are scoped strictly within their request.
+	assert(current() == req);
+	add(name, now<steady_point>() - start, ctx::yields(ctx::cur()) - yields_start);
+}
+
+//
+// request
+//
+
+ircd::trace::request::request(const string_view &label,
+                              const uint64_t &id)
+:start{now<steady_point>()}
+{
+	assert(ctx);
+	strlcpy(this->label, label, sizeof(this->label));
+	this->id = id;
+	this->started = ircd::time();
+	yields_start = ctx::yields(*ctx);
+	prev = attached(*ctx);
+	attached(*ctx) = this;
+}
+
+ircd::trace::request::~request()
+noexcept
+{
+	assert(attached(*ctx) == this);
+	attached(*ctx) = prev;
+
+	time = now<steady_point>() - start;
+	yields = ctx::yields(*ctx) - yields_start;
+	if(time >= milliseconds(slow))
+		retain(*this);
+}
+
+//
+// sample
+//
+
+ircd::trace::total *
+ircd::trace::sample::get(const string_view &name)
+{
+	const string_view key
+	{
+		trunc(name, total::NAME_MAX)
+	};
+
+	for(size_t i(0); i < used; ++i)
+		if(string_view{totals[i].name} == key)
+			return &totals[i];
+
+	if(used >= totals.size())
+		return nullptr;
+
+	auto &ret(totals[used++]);
+	strlcpy(ret.name, key, sizeof(ret.name));
+	return &ret;
+}
+
+const ircd::trace::total *
+ircd::trace::sample::find(const string_view &name)
+const
+{
+	const string_view key
+	{
+		trunc(name, total::NAME_MAX)
+	};
+
+	for(size_t i(0); i < used; ++i)
+		if(string_view{totals[i].name} == key)
+			return &totals[i];
+
+	return nullptr;
+}
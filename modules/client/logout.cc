@@ -34,6 +34,16 @@ post__logout(client &client, const resource::request &request)
 		request.access_token
 	};
 
+	// The token's state is replaced by a tombstone before it leaves the
+	// cache; a concurrent authenticate() missing the cache now finds the
+	// tombstone rather than bringing the live token back.
+	m::send(m::user::tokens, request.user_id, "ircd.access_token", access_token,
+	{
+		{ "revoked",  true  },
+	});
+
+	m::user::token_cache.del(access_token);
+
 	return resource::response
 	{
 		client, http::OK
@@ -48,3 +58,31 @@ post_method
 		post_method.REQUIRES_AUTH
 	}
 };
+
+static void
+handle_token_redaction(const m::event &event)
+{
+	const m::event::fetch target
+	{
+		at<"redacts"_>(event), std::nothrow
+	};
+
+	if(!target.valid)
+		return;
+
+	if(json::get<"type"_>(target) != "ircd.access_token")
+		return;
+
+	m::user::token_cache.del(at<"state_key"_>(target));
+}
+
+const m::hook<>
+token_redaction_hook
+{
+	handle_token_redaction,
+	{
+		{ "_site",     "vm.notify"                  },
+		{ "room_id",   m::user::tokens.room_id      },
+		{ "type",      "m.room.redaction"           },
+	}
+};
@@ -122,7 +122,8 @@ method_put
 {
 	rooms_resource, "PUT", put_rooms,
 	{
-		method_put.REQUIRES_AUTH
+		method_put.REQUIRES_AUTH |
+		method_put.PRIORITY_HIGH
 	}
 };
 
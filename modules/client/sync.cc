@@ -53,6 +53,12 @@ get_sync
 	{
 		get_sync.REQUIRES_AUTH,
 		-1s,
+		128_KiB,
+		{},
+
+		// The client is waiting; spend as little time compressing as
+		// possible for what is the bulk of the benefit.
+		1,
 	}
 };
 
@@ -548,7 +554,7 @@ update_sync(client &client,
 		m::user::id{request.user_id}
 	};
 
-	std::vector<json::value> presents;
+	std::vector<json::value, allocator::arena::allocator<json::value>> presents;
 	ur.get(std::nothrow, "ircd.presence", [&]
 	(const m::event &event)
 	{
@@ -43,5 +43,8 @@ get_versions(client &client,
 resource::method
 getter
 {
-	versions_resource, "GET", get_versions
+	versions_resource, "GET", get_versions,
+	{
+		getter.PRIORITY_HIGH
+	}
 };
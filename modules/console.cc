@@ -479,6 +479,16 @@ console_cmd__log__mark(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__log__dropped(opt &out, const string_view &line)
+{
+	out << log::dropped.load() << " log messages dropped; writer is "
+	    << (log::async? "asynchronous" : "synchronous")
+	    << std::endl;
+
+	return true;
+}
+
 bool
 console_cmd__mark(opt &out, const string_view &line)
 {
@@ -500,6 +510,96 @@ console_cmd__info(opt &out, const string_view &line)
 	return true;
 }
 
+//
+// stats
+//
+
+bool
+console_cmd__stats(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"prefix"
+	}};
+
+	stats::pretty(out, param[0]);
+	return true;
+}
+
+bool
+console_cmd__stats__prometheus(opt &out, const string_view &line)
+{
+	stats::prometheus(out);
+	return true;
+}
+
+//
+// trace
+//
+
+bool
+console_cmd__trace(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"limit"
+	}};
+
+	const auto limit
+	{
+		param.at<size_t>(0, 16)
+	};
+
+	const auto &slows
+	{
+		trace::slows
+	};
+
+	const auto start
+	{
+		slows.size() - std::min(slows.size(), limit)
+	};
+
+	for(auto it(begin(slows) + start); it != end(slows); ++it)
+	{
+		const auto &sample{*it};
+		char tbuf[64];
+		out << timef(tbuf, sample.started, ircd::localtime)
+		    << " client:" << sample.id
+		    << " " << duration_cast<milliseconds>(sample.time).count() << "ms"
+		    << " yields:" << sample.yields
+		    << " " << string_view{sample.label}
+		    << std::endl;
+
+		for(size_t i(0); i < sample.used; ++i)
+		{
+			const auto &total{sample.totals[i]};
+			out << "    "
+			    << std::setw(24) << std::left << string_view{total.name}
+			    << " " << std::setw(6) << std::right << total.count
+			    << " " << std::setw(6) << std::right << total.yields << " yields"
+			    << " " << std::setw(9) << std::right << duration_cast<microseconds>(total.time).count() << "us"
+			    << " max " << duration_cast<microseconds>(total.max).count() << "us"
+			    << std::endl;
+		}
+
+		if(sample.dropped)
+			out << "    (" << sample.dropped << " spans not accounted)" << std::endl;
+
+		out << std::endl;
+	}
+
+	return true;
+}
+
+bool
+console_cmd__trace__clear(opt &out, const string_view &line)
+{
+	out << "Cleared " << trace::slows.size() << " samples." << std::endl;
+	trace::slows.clear();
+	return true;
+}
+
 //
 // conf
 //
@@ -874,6 +974,27 @@ console_cmd__ctx__list(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__ctx__stack(opt &out, const string_view &line)
+{
+	out << "page size:   " << ctx::stack::page_size << std::endl
+	    << "mapped:      " << ctx::stack::mapped() << " bytes" << std::endl
+	    << "pooled:      " << ctx::stack::pooled()
+	    << " of " << size_t(ctx::stack::pool_max) << std::endl
+	    << "trim:        " << size_t(ctx::stack::trim) << " bytes" << std::endl;
+
+	return true;
+}
+
+bool
+console_cmd__ctx__stack__clear(opt &out, const string_view &line)
+{
+	out << "Unmapped " << ctx::stack::clear() << " pooled stacks."
+	    << std::endl;
+
+	return true;
+}
+
 bool
 console_cmd__ctx(opt &out, const string_view &line)
 {
@@ -1057,6 +1178,89 @@ catch(const std::out_of_range &e)
 	return true;
 }
 
+bool
+console_cmd__db__dict(opt &out, const string_view &line)
+try
+{
+	const params param{line, " ",
+	{
+		"dbname", "colname", "[retrain]"
+	}};
+
+	const auto dbname
+	{
+		param.at(0)
+	};
+
+	const auto colname
+	{
+		param.at(1)
+	};
+
+	const bool retrain
+	{
+		param[2] == "retrain"
+	};
+
+	auto &database
+	{
+		*db::database::dbs.at(dbname)
+	};
+
+	db::column column
+	{
+		database, colname
+	};
+
+	if(retrain)
+		db::recompress(column);
+
+	for(const auto &key : {"compression"_sv, "compression.dict.size"_sv, "compression.dict.train"_sv})
+	{
+		char buf[256];
+		const fmt::snstringf name
+		{
+			256, "ircd.db.%s.%s.%s", dbname, colname, key
+		};
+
+		out << std::left << std::setw(32) << key
+		    << " " << conf::get(string_view{name}, buf)
+		    << std::endl;
+	}
+
+	out << std::endl;
+
+	size_t files(0), raw(0), stored(0);
+	db::for_each_compression(column, [&]
+	(const string_view &file, const string_view &compression, const size_t &_raw, const size_t &_stored)
+	{
+		out << std::left << std::setw(56) << file
+		    << " " << std::setw(20) << compression
+		    << " " << std::right << std::setw(12) << _raw
+		    << " " << std::setw(12) << _stored
+		    << " " << std::setw(6) << std::fixed << std::setprecision(2)
+		    << (_stored? double(_raw) / _stored : 0.0)
+		    << std::endl;
+
+		++files;
+		raw += _raw;
+		stored += _stored;
+		return true;
+	});
+
+	out << "-- " << files << " files; "
+	    << raw << " raw bytes stored in " << stored
+	    << " (" << std::fixed << std::setprecision(2) << (stored? double(raw) / stored : 0.0) << "x)"
+	    << std::endl;
+
+	return true;
+}
+catch(const std::out_of_range &e)
+{
+	out << "No open database by that name" << std::endl;
+	return true;
+}
+
 bool
 console_cmd__db__ticker(opt &out, const string_view &line)
 try
@@ -1366,6 +1570,60 @@ console_cmd__db__stats(opt &out, const string_view &line)
 	});
 }
 
+bool
+console_cmd__db__jobs(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"[dbname]"
+	}};
+
+	const auto dbname
+	{
+		param[0]
+	};
+
+	for(const auto &pool : {"flush"_sv, "compaction"_sv})
+		out << std::left << std::setw(12) << pool
+		    << " threads: " << db::jobs::threads(pool)
+		    << " running: " << db::jobs::running(pool)
+		    << " queued: " << db::jobs::queued(pool)
+		    << std::endl;
+
+	out << std::left << std::setw(12) << "rate"
+	    << " " << db::jobs::rate() << " bytes/s"
+	    << std::endl
+	    << std::endl;
+
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	db::jobs::for_each([&](const db::jobs::job &job)
+	{
+		if(dbname && job.dbname != dbname)
+			return true;
+
+		const bool running
+		{
+			job.started != steady_point{}
+		};
+
+		out << std::right << std::setw(8) << job.id
+		    << " " << std::left << std::setw(10) << job.pool
+		    << " " << std::setw(24) << job.dbname
+		    << " " << std::setw(8) << (running? "RUNNING" : "QUEUED")
+		    << " " << std::right << std::setw(8)
+		    << duration_cast<milliseconds>(now - (running? job.started : job.queued)).count() << "ms"
+		    << std::endl;
+
+		return true;
+	});
+
+	return true;
+}
+
 bool
 console_cmd__db__set(opt &out, const string_view &line)
 try
@@ -2133,6 +2391,24 @@ console_cmd__net__host__cache__A(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__net__host__cache__AAAA(opt &out, const string_view &line)
+{
+	for(const auto &pair : net::dns::cache.AAAA)
+	{
+		const auto &host{pair.first};
+		const auto &record{pair.second};
+		const net::ipport ipp{record.ip6, 0};
+		out << std::setw(48) << std::right << host
+		    << "  =>  " << std::setw(39) << std::left << ipp
+		    << "  expires " << timestr(record.ttl, ircd::localtime)
+		    << " (" << record.ttl << ")"
+		    << std::endl;
+	}
+
+	return true;
+}
+
 bool
 console_cmd__net__host__cache__SRV(opt &out, const string_view &line)
 {
@@ -2191,6 +2467,80 @@ console_cmd__net__host__prefetch(opt &out, const string_view &line)
 	return true;
 }
 
+//
+// http
+//
+
+bool
+console_cmd__http__bench(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"count"
+	}};
+
+	const size_t count
+	{
+		param.at(0, 100000UL)
+	};
+
+	static const string_view sample
+	{
+		"GET /_matrix/federation/v1/state_ids/%21a%3Aexample.org?event_id=%24b%3Aexample.org HTTP/1.1\r\n"
+		"Host: matrix.example.org\r\n"
+		"User-Agent: Synapse/0.99.0\r\n"
+		"Accept-Encoding: gzip, deflate\r\n"
+		"Authorization: X-Matrix origin=example.org,key=\"ed25519:auto\",sig=\"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/ABCDEFGHIJKLMNOPQRSTUVWXYZabcdef\"\r\n"
+		"Content-Type: application/json\r\n"
+		"Content-Length: 0\r\n"
+		"Connection: keep-alive\r\n"
+		"\r\n"
+	};
+
+	char buf[1_KiB];
+	const auto run{[&count, &buf]
+	{
+		const util::timer timer;
+		for(size_t i(0); i < count; ++i)
+		{
+			const mutable_buffer head
+			{
+				buf, copy(mutable_buffer{buf}, sample)
+			};
+
+			parse::buffer pb{head};
+			parse::capstan pc{pb};
+			pc.read += size(head);
+			const http::request::head parsed{pc};
+			assert(parsed.content_length == 0);
+		}
+
+		return timer.at<nanoseconds>();
+	}};
+
+	char prev[32];
+	const std::string restore
+	{
+		conf::get("ircd.http.parse.fast", prev)
+	};
+
+	const unwind reset{[&restore]
+	{
+		conf::set("ircd.http.parse.fast", string_view{restore});
+	}};
+
+	conf::set("ircd.http.parse.fast", "0");
+	const auto grammar(run());
+	conf::set("ircd.http.parse.fast", "1");
+	const auto scanner(run());
+
+	out << "parsed " << count << " request heads of " << size(sample) << " bytes" << std::endl
+	    << "grammar: " << grammar.count() / std::max(count, 1UL) << " ns/head" << std::endl
+	    << "scanner: " << scanner.count() / std::max(count, 1UL) << " ns/head" << std::endl;
+
+	return true;
+}
+
 //
 // client
 //
@@ -2242,6 +2592,371 @@ console_cmd__client(opt &out, const string_view &line)
 	return true;
 }
 
+//
+// json
+//
+
+bool
+console_cmd__json__index__bench(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"members", "count"
+	}};
+
+	const size_t members
+	{
+		std::max(param.at(0, 1000UL), 1UL)
+	};
+
+	const size_t count
+	{
+		param.at(1, 100000UL)
+	};
+
+	// Shaped like the users of an m.room.power_levels in a large room.
+	std::string users("{");
+	for(size_t i(0); i < members; ++i)
+		users += fmt::snstringf
+		{
+			128, "%s\"@user%zu:example.org\":%zu", i? "," : "", i, i % 101
+		};
+
+	users += "}";
+	const json::object object
+	{
+		users
+	};
+
+	const auto key{[](const size_t &i)
+	{
+		return fmt::snstringf
+		{
+			64, "@user%zu:example.org", i
+		};
+	}};
+
+	std::vector<std::string> keys(std::min(count, members));
+	for(size_t i(0); i < keys.size(); ++i)
+		keys[i] = key(i * 7919 % members);
+
+	const auto run{[&count, &keys](auto &&get)
+	{
+		size_t ret(0);
+		const util::timer timer;
+		for(size_t i(0); i < count; ++i)
+			ret += size(get(string_view{keys[i % keys.size()]}));
+
+		return std::make_pair(timer.at<nanoseconds>(), ret);
+	}};
+
+	const auto scan{run([&object](const string_view &key)
+	{
+		return object.get(key);
+	})};
+
+	const util::timer build_timer;
+	const json::object::index index
+	{
+		object
+	};
+	const auto build(build_timer.at<nanoseconds>());
+
+	const auto indexed{run([&index](const string_view &key)
+	{
+		return index.get(key);
+	})};
+
+	assert(scan.second == indexed.second);
+	out << "looked up " << count << " keys of an object with " << members << " members" << std::endl
+	    << "object: " << scan.first.count() / std::max(count, 1UL) << " ns/lookup" << std::endl
+	    << "index:  " << indexed.first.count() / std::max(count, 1UL) << " ns/lookup"
+	    << " (+" << build.count() << " ns to build)" << std::endl;
+
+	return true;
+}
+
+//
+// id
+//
+
+bool
+console_cmd__id__bench(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"count"
+	}};
+
+	const size_t count
+	{
+		param.at(0, 1000000UL)
+	};
+
+	static const string_view sample[]
+	{
+		"@alice:example.org",
+		"$15508383800Abcde:matrix.example.org",
+		"!LMnopQRStuvWXyz:matrix.example.org:8448",
+		"#matrix-dev:a.example.org",
+	};
+
+	const auto run{[&count]
+	{
+		size_t ret(0);
+		const util::timer timer;
+		for(size_t i(0); i < count; ++i)
+		{
+			const m::id id
+			{
+				sample[i % std::extent<decltype(sample)>::value]
+			};
+
+			ret += size(id.host()) + size(id.local());
+		}
+
+		return std::make_pair(timer.at<nanoseconds>(), ret);
+	}};
+
+	char prev[32];
+	const std::string restore
+	{
+		conf::get("ircd.m.id.parse.fast", prev)
+	};
+
+	const unwind reset{[&restore]
+	{
+		conf::set("ircd.m.id.parse.fast", string_view{restore});
+	}};
+
+	conf::set("ircd.m.id.parse.fast", "0");
+	const auto grammar(run());
+	conf::set("ircd.m.id.parse.fast", "1");
+	const auto scanner(run());
+	assert(grammar.second == scanner.second);
+
+	out << "validated and split " << count << " ids" << std::endl
+	    << "grammar: " << grammar.first.count() / std::max(count, 1UL) << " ns/id" << std::endl
+	    << "scanner: " << scanner.first.count() / std::max(count, 1UL) << " ns/id" << std::endl;
+
+	return true;
+}
+
+/// The result of validating and splitting the id as a string, or the error;
+/// for comparing the fast path to the grammar.
+static std::string
+_id_result(const string_view &str)
+{
+	const bool valid
+	{
+		!str.empty() && m::is_sigil(str.front()) && m::valid(m::sigil(str), str)
+	};
+
+	try
+	{
+		const m::id id{str};
+		return fmt::snstringf
+		{
+			512, "%d|%zu|%s|%s|%s|%u",
+			int(valid),
+			size(string_view(id)),
+			id.local(),
+			id.host(),
+			id.hostname(),
+			uint(id.port()),
+		};
+	}
+	catch(const std::exception &e)
+	{
+		return fmt::snstringf
+		{
+			512, "%d|%s", int(valid), e.what()
+		};
+	}
+}
+
+bool
+console_cmd__id__check(opt &out, const string_view &line)
+{
+	static const string_view corpus[]
+	{
+		// valid
+		"@alice:example.org",
+		"@a.b=c/d_e-f:example.org:8448",
+		"@alice:localhost",
+		"@alice:EXAMPLE.org",
+		"@alice:1.2.3.4",
+		"@alice:1.2.3.4:8448",
+		"@alice:[::1]",
+		"@alice:[2001:db8::1]:8448",
+		"@alice:example.org:1",
+		"@alice:example.org:65535",
+		"@alice:a-b.c-d.example",
+		"$15508383800Abcde:matrix.example.org",
+		"$ev/ent+x=:example.org",
+		"!LMnopQRStuvWXyz:matrix.example.org:8448",
+		"#matrix-dev:a.example.org",
+		"#a:b",
+		"+group:example.org",
+		"%device:example.org",
+
+		// invalid
+		"",
+		"@",
+		"@:example.org",
+		"@alice",
+		"@alice:",
+		"@alice::",
+		"@alice:example.org:",
+		"@alice:example.org:x",
+		"@alice:example.org:65536",
+		"@alice:example.org:99999999999",
+		"@alice:example.org:-1",
+		"@alice:example..org",
+		"@alice:.example.org",
+		"@alice:example.org.",
+		"@alice:-example.org",
+		"@alice:exa_mple.org",
+		"@alice:exa mple.org",
+		"@al ice:example.org",
+		"@alice\x7f:example.org",
+		"@alice:[::1",
+		"@alice:[::1]:",
+		"@alice:[zz::1]",
+		"@alice:1.2.3.4.5",
+		"!room",
+		"!:example.org",
+		"#:example.org",
+		"&alice:example.org",
+		"alice:example.org",
+	};
+
+	char prev[32];
+	const std::string restore
+	{
+		conf::get("ircd.m.id.parse.fast", prev)
+	};
+
+	const unwind reset{[&restore]
+	{
+		conf::set("ircd.m.id.parse.fast", string_view{restore});
+	}};
+
+	// Also past the maximum size, where both must stop.
+	std::vector<std::string> ids(begin(corpus), end(corpus));
+	ids.emplace_back("@" + std::string(m::id::MAX_SIZE, 'a') + ":example.org");
+	ids.emplace_back("@alice:" + std::string(m::id::MAX_SIZE, 'a') + ".org");
+
+	size_t mismatches(0);
+	for(const auto &str : ids)
+	{
+		conf::set("ircd.m.id.parse.fast", "0");
+		const auto grammar(_id_result(string_view{str}));
+		conf::set("ircd.m.id.parse.fast", "1");
+		const auto scanner(_id_result(string_view{str}));
+		if(grammar == scanner)
+			continue;
+
+		++mismatches;
+		out << "MISMATCH '" << str << "'" << std::endl
+		    << "  grammar: " << grammar << std::endl
+		    << "  scanner: " << scanner << std::endl;
+	}
+
+	out << mismatches << " mismatches in " << ids.size() << " ids" << std::endl;
+	return true;
+}
+
+bool
+console_cmd__id__fuzz(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"count"
+	}};
+
+	const size_t count
+	{
+		param.at(0, 100000UL)
+	};
+
+	static const string_view sample[]
+	{
+		"@alice:example.org",
+		"@a.b=c/d:example.org:8448",
+		"$event:a-b.example.org",
+		"!room:1.2.3.4:8448",
+		"!room:[::1]:8448",
+		"#alias:example.org:65535",
+		"+group:x",
+		"%device:example.org",
+	};
+
+	static const std::string dict
+	{
+		rand::dict::alnum + "@$!#+%:.-_=/[] \t\x7f\x80\xff"
+	};
+
+	char prev[32];
+	const std::string restore
+	{
+		conf::get("ircd.m.id.parse.fast", prev)
+	};
+
+	const unwind reset{[&restore]
+	{
+		conf::set("ircd.m.id.parse.fast", string_view{restore});
+	}};
+
+	size_t mismatches(0);
+	for(size_t i(0); i < count; ++i)
+	{
+		std::string str
+		{
+			sample[i % std::extent<decltype(sample)>::value]
+		};
+
+		for(size_t j(rand::integer(1, 3)); j; --j)
+		{
+			const size_t pos(rand::integer(0, str.size()));
+			switch(rand::integer(0, 2))
+			{
+				case 0:
+					if(pos < str.size())
+						str[pos] = rand::character(dict);
+					break;
+
+				case 1:
+					str.insert(pos, 1, rand::character(dict));
+					break;
+
+				case 2:
+					if(pos < str.size())
+						str.erase(pos, 1);
+					break;
+			}
+		}
+
+		if(str.empty() || !m::is_sigil(str.front()))
+			continue;
+
+		conf::set("ircd.m.id.parse.fast", "0");
+		const auto grammar(_id_result(string_view{str}));
+		conf::set("ircd.m.id.parse.fast", "1");
+		const auto scanner(_id_result(string_view{str}));
+		if(grammar == scanner)
+			continue;
+
+		if(++mismatches <= 16)
+			out << "MISMATCH '" << str << "'" << std::endl
+			    << "  grammar: " << grammar << std::endl
+			    << "  scanner: " << scanner << std::endl;
+	}
+
+	out << mismatches << " mismatches in " << count << " ids" << std::endl;
+	return true;
+}
+
 //
 // key
 //
@@ -2289,6 +3004,89 @@ console_cmd__key__get(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__key__verify(opt &out, const string_view &line)
+{
+	const auto &verifier{m::request::verifier};
+	out << "cached keys: " << verifier.keys.size() << std::endl
+	    << std::endl;
+
+	for(const auto &pair : verifier.origins)
+	{
+		const auto &origin{pair.first};
+		const auto &stats{pair.second};
+		const auto avg
+		{
+			stats.count? nanoseconds(stats.time / stats.count) : 0ns
+		};
+
+		out << std::setw(40) << std::left << origin
+		    << " count: " << std::setw(8) << stats.count
+		    << " failed: " << std::setw(6) << stats.failed
+		    << " key miss: " << std::setw(6) << stats.key_miss
+		    << " total: " << std::setw(10) << duration_cast<microseconds>(stats.time).count() << "us"
+		    << " avg: " << duration_cast<microseconds>(avg).count() << "us"
+		    << std::endl;
+	}
+
+	return true;
+}
+
+//
+// intern
+//
+
+bool
+console_cmd__intern(opt &out, const string_view &line)
+{
+	const params param
+	{
+		line, " ",
+		{
+			"id|handle"
+		}
+	};
+
+	const string_view &arg
+	{
+		param.at(0)
+	};
+
+	if(try_lex_cast<uint64_t>(arg))
+	{
+		out << m::intern::get(lex_cast<uint64_t>(arg)) << std::endl;
+		return true;
+	}
+
+	out << m::intern::find(arg) << std::endl;
+	return true;
+}
+
+bool
+console_cmd__intern__set(opt &out, const string_view &line)
+{
+	const params param
+	{
+		line, " ",
+		{
+			"id"
+		}
+	};
+
+	out << m::intern::set(param.at(0)) << std::endl;
+	return true;
+}
+
+bool
+console_cmd__intern__cache(opt &out, const string_view &line)
+{
+	out << "head:    " << m::intern::head << std::endl
+	    << "cached:  " << m::intern::cached() << std::endl
+	    << "max:     " << size_t(m::intern::cache_max) << std::endl;
+
+	return true;
+}
+
 //
 // events
 //
@@ -3302,6 +4100,49 @@ console_cmd__room__origins(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__room__visible(opt &out, const string_view &line)
+{
+	const params param
+	{
+		line, " ",
+		{
+			"room_id", "user_id|node_id", "event_id"
+		}
+	};
+
+	const auto &room_id
+	{
+		m::room_id(param.at(0))
+	};
+
+	const m::room room
+	{
+		room_id, param[2]
+	};
+
+	const string_view &viewer
+	{
+		param.at(1)
+	};
+
+	const bool visible
+	{
+		startswith(viewer, m::id::USER)?
+			room.visible(m::user::id{viewer}):
+			room.visible(m::node::id{viewer})
+	};
+
+	out << viewer << " is " << (visible? "permitted" : "denied")
+	    << " to view " << room_id;
+
+	if(room.event_id)
+		out << " at " << room.event_id;
+
+	out << std::endl;
+	return true;
+}
+
 bool
 console_cmd__room__state(opt &out, const string_view &line)
 {
@@ -3903,6 +4744,19 @@ console_cmd__user__password(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__user__tokens__cache(opt &out, const string_view &line)
+{
+	const auto &cache{m::user::token_cache};
+	const auto total{cache.hits + cache.misses};
+	out << "entries: " << cache.map.size() << std::endl
+	    << "hits:    " << cache.hits << std::endl
+	    << "misses:  " << cache.misses << std::endl
+	    << "ratio:   " << (total? double(cache.hits) / total : 0.0) << std::endl;
+
+	return true;
+}
+
 bool
 console_cmd__user__active(opt &out, const string_view &line)
 {
@@ -38,7 +38,15 @@ method_get
 {
 	backfill_resource, "GET", get__backfill,
 	{
-		method_get.VERIFY_ORIGIN
+		method_get.VERIFY_ORIGIN |
+		method_get.PRIORITY_BULK,
+
+		30s,
+		128_KiB,
+		{},
+
+		// Large, highly redundant, and not latency sensitive.
+		6,
 	}
 };
 
@@ -97,7 +105,7 @@ get__backfill(client &client,
 
 	const unique_buffer<mutable_buffer> buf
 	{
-		96_KiB
+		96_KiB, allocator::scratch()
 	};
 
 	resource::response::chunked response
@@ -33,7 +33,8 @@ method_get
 {
 	get_missing_events_resource, "GET", get__missing_events,
 	{
-		method_get.VERIFY_ORIGIN
+		method_get.VERIFY_ORIGIN |
+		method_get.PRIORITY_BULK
 	}
 };
 
@@ -42,7 +43,8 @@ method_post
 {
 	get_missing_events_resource, "POST", get__missing_events,
 	{
-		method_post.VERIFY_ORIGIN
+		method_post.VERIFY_ORIGIN |
+		method_post.PRIORITY_BULK
 	}
 };
 
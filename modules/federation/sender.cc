@@ -157,8 +157,9 @@ try
 		default:                   break;
 	}
 
+	const allocator::arena::scope scratch;
 	size_t pc(0), ec(0);
-	std::vector<json::value> units(pdus + edus);
+	std::vector<json::value, allocator::arena::allocator<json::value>> units(pdus + edus);
 	for(const auto &unit : q) switch(unit->type)
 	{
 		case unit::PDU:
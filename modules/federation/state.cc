@@ -103,6 +103,14 @@ method_get
 {
 	state_resource, "GET", get__state,
 	{
-		method_get.VERIFY_ORIGIN
+		method_get.VERIFY_ORIGIN |
+		method_get.PRIORITY_BULK,
+
+		30s,
+		128_KiB,
+		{},
+
+		// Large, highly redundant, and not latency sensitive.
+		6,
 	}
 };
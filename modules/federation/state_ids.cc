@@ -91,6 +91,14 @@ method_get
 {
 	state_ids_resource, "GET", get__state_ids,
 	{
-		method_get.VERIFY_ORIGIN
+		method_get.VERIFY_ORIGIN |
+		method_get.PRIORITY_BULK,
+
+		30s,
+		128_KiB,
+		{},
+
+		// Large, highly redundant, and not latency sensitive.
+		6,
 	}
 };
@@ -43,7 +43,7 @@ try
 	opts.dynamic = true;
 	const unique_buffer<mutable_buffer> buf
 	{
-		16_KiB
+		16_KiB, allocator::scratch()
 	};
 
 	m::v1::key::query request
@@ -133,7 +133,7 @@ try
 	m::v1::key::opts opts;
 	const unique_buffer<mutable_buffer> buf
 	{
-		16_KiB
+		16_KiB, allocator::scratch()
 	};
 
 	m::v1::key::keys request
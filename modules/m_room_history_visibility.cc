@@ -32,17 +32,286 @@ _changed_visibility_hookfn
 	}
 };
 
-static void
-_event_visible(const m::event &event)
+//
+// Visibility of the room at an event to a user or a node. This is the
+// implementation of m::room::visible() and so of every m::visible(); the
+// federation /backfill handler stops at the first event not visible to the
+// requesting node.
+//
+// Whether an event is visible only depends on the state of the room at that
+// event, except for the "shared" setting which defers to the viewer's
+// present membership. What the rules need from that state is summarized
+// once per state root and shared by every viewer: the setting, and for
+// nodes the origins with a joined or invited member, which otherwise takes
+// a pass over all members. A user's own membership is a single lookup and
+// is not cached. Consecutive checks at the same state root, as a backfill
+// does, are answered from the last summary without a lookup.
+//
+
+struct summary
+{
+	std::string setting;
+	bool origins {false};                        // joined/invited are loaded
+	std::set<std::string, std::less<>> joined;
+	std::set<std::string, std::less<>> invited;
+	std::list<string_view>::iterator lru_it;
+};
+
+extern "C" bool visible__room(const m::room &, const string_view &viewer);
+static bool _visible_present(const m::room &, const string_view &viewer);
+static void _load_origins(const m::room::state &, summary &);
+static summary _load(const m::room::state &);
+static summary &_insert(const string_view &root, summary &&);
+static summary *_find(const string_view &root);
+static summary &_get(const m::room::state &, const bool &origins);
+
+conf::item<size_t>
+cache_max
+{
+	{ "name",     "ircd.m.room.history_visibility.cache.max" },
+	{ "default",   16384L                                    },
+};
+
+// state root => summary
+static std::map<std::string, summary, std::less<>> cache;
+
+// views of the cache keys, least recently used first
+static std::list<string_view> lru;
+
+// the summary last used
+static decltype(cache)::iterator last
+{
+	end(cache)
+};
+
+bool
+visible__room(const m::room &room,
+              const string_view &viewer)
 {
+	const m::room::state state
+	{
+		room
+	};
+
+	const bool user
+	{
+		startswith(viewer, m::id::USER)
+	};
+
+	const string_view host
+	{
+		!user? m::node::id{viewer}.host() : string_view{}
+	};
 
+	// What is needed from the summary is copied out before anything else
+	// can yield and evict it.
+	std::string setting;
+	bool joined{false}, invite{false};
+	const auto extract{[&](const summary &summary)
+	{
+		setting = summary.setting;
+		joined = !user && summary.joined.count(host);
+		invite = !user && summary.invited.count(host);
+	}};
+
+	// Without a state root this is the present state which has no identity
+	// to cache by.
+	if(!state.root_id)
+	{
+		summary summary
+		{
+			_load(state)
+		};
+
+		if(!user)
+			_load_origins(state, summary);
+
+		extract(summary);
+	}
+	else extract(_get(state, !user));
+
+	if(setting == "world_readable")
+		return true;
+
+	if(user)
+		state.get(std::nothrow, "m.room.member", viewer, m::event::closure{[&joined, &invite]
+		(const m::event &event)
+		{
+			joined = m::membership(event) == "join";
+			invite = m::membership(event) == "invite";
+		}});
+
+	if(joined || (invite && setting == "invited"))
+		return true;
+
+	if(setting == "shared")
+		return _visible_present(room, viewer);
+
+	return false;
 }
 
-const m::hook<>
-_event_visible_hookfn
+/// Whether the viewer is presently joined to the room. For a node this is
+/// any of its users.
+bool
+_visible_present(const m::room &room,
+                 const string_view &viewer)
+{
+	const m::room present
+	{
+		room.room_id
+	};
+
+	if(startswith(viewer, m::id::USER))
+		return present.membership(m::user::id{viewer}, "join");
+
+	const m::room::origins origins
+	{
+		present
+	};
+
+	return origins.has(m::node::id{viewer}.host());
+}
+
+summary
+_load(const m::room::state &state)
 {
-	_event_visible,
+	summary ret;
+	ret.setting = "shared";
+	state.get(std::nothrow, "m.room.history_visibility", "", m::event::closure{[&ret]
+	(const m::event &event)
 	{
-		{ "_site",    "m.event.visible"            },
+		const json::object &content
+		{
+			json::get<"content"_>(event)
+		};
+
+		const string_view &value
+		{
+			unquote(content.get("history_visibility"))
+		};
+
+		if(value)
+			ret.setting = std::string{value};
+	}});
+
+	return ret;
+}
+
+void
+_load_origins(const m::room::state &state,
+              summary &summary)
+{
+	state.for_each("m.room.member", m::event::closure{[&summary]
+	(const m::event &event)
+	{
+		const m::user::id &user_id
+		{
+			at<"state_key"_>(event)
+		};
+
+		const string_view &membership
+		{
+			m::membership(event)
+		};
+
+		if(membership == "join")
+			summary.joined.emplace(user_id.host());
+		else if(membership == "invite")
+			summary.invited.emplace(user_id.host());
+	}});
+
+	summary.origins = true;
+}
+
+/// The summary at this state, loading it if not cached. With origins the
+/// origins are loaded too if this is the first node to ask at the root.
+/// Nothing yields after this returns.
+summary &
+_get(const m::room::state &state,
+     const bool &origins)
+{
+	const string_view &root
+	{
+		state.root_id
+	};
+
+	summary *ret
+	{
+		_find(root)
+	};
+
+	if(!ret)
+		ret = &_insert(root, _load(state));
+
+	if(!origins || ret->origins)
+		return *ret;
+
+	summary loaded;
+	_load_origins(state, loaded);
+
+	// The load yielded; the summary may have been evicted meanwhile.
+	ret = _find(root);
+	if(!ret)
+		ret = &_insert(root, _load(state));
+
+	if(!ret->origins)
+	{
+		ret->origins = true;
+		ret->joined = std::move(loaded.joined);
+		ret->invited = std::move(loaded.invited);
 	}
-};
+
+	return *ret;
+}
+
+summary *
+_find(const string_view &root)
+{
+	if(last != end(cache) && last->first == root)
+		return &last->second;
+
+	const auto it
+	{
+		cache.find(root)
+	};
+
+	if(it == end(cache))
+		return nullptr;
+
+	lru.splice(end(lru), lru, it->second.lru_it);
+	last = it;
+	return &it->second;
+}
+
+summary &
+_insert(const string_view &root,
+        summary &&summary)
+{
+	// Another context may have inserted it while this one was loading.
+	if(auto *const existing{_find(root)})
+		return *existing;
+
+	while(!lru.empty() && cache.size() >= size_t(cache_max))
+	{
+		const auto victim
+		{
+			cache.find(lru.front())
+		};
+
+		assert(victim != end(cache));
+		if(victim == last)
+			last = end(cache);
+
+		lru.pop_front();
+		cache.erase(victim);
+	}
+
+	const auto it
+	{
+		cache.emplace(std::string{root}, std::move(summary)).first
+	};
+
+	it->second.lru_it = lru.emplace(end(lru), it->first);
+	last = it;
+	return it->second;
+}
@@ -53,6 +53,27 @@ affect_user_room_hookfn
 	affect_user_room
 };
 
+static void
+update_members_cache(const m::event &event)
+{
+	m::room::members::cache::update
+	(
+		at<"room_id"_>(event),
+		at<"state_key"_>(event),
+		m::membership(event)
+	);
+}
+
+const m::hook<>
+update_members_cache_hookfn
+{
+	{
+		{ "_site",          "vm.write"      },
+		{ "type",           "m.room.member" },
+	},
+	update_members_cache
+};
+
 static void
 _can_join_room(const m::event &event)
 {
@@ -143,11 +143,17 @@ get__download_local(client &client,
 static resource::method
 method_get
 {
-	download_resource, "GET", get__download
+	download_resource, "GET", get__download,
+	{
+		method_get.PRIORITY_BULK
+	}
 };
 
 static resource::method
 method_get__legacy
 {
-	download_resource__legacy, "GET", get__download
+	download_resource__legacy, "GET", get__download,
+	{
+		method_get__legacy.PRIORITY_BULK
+	}
 };
@@ -89,13 +89,19 @@ get__thumbnail(client &client,
 static resource::method
 method_get__legacy
 {
-	thumbnail_resource__legacy, "GET", get__thumbnail
+	thumbnail_resource__legacy, "GET", get__thumbnail,
+	{
+		method_get__legacy.PRIORITY_BULK
+	}
 };
 
 static resource::method
 method_get
 {
-	thumbnail_resource, "GET", get__thumbnail
+	thumbnail_resource, "GET", get__thumbnail,
+	{
+		method_get.PRIORITY_BULK
+	}
 };
 
 static resource::response
@@ -113,7 +113,8 @@ static const struct resource::method::opts
 method_post_opts
 {
 	resource::method::REQUIRES_AUTH |
-	resource::method::CONTENT_DISCRETION,
+	resource::method::CONTENT_DISCRETION |
+	resource::method::PRIORITY_BULK,
 
 	-1s, // TODO: no coarse timer
 
@@ -0,0 +1,68 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+using namespace ircd;
+
+mapi::header
+IRCD_MODULE
+{
+	"Metrics in the Prometheus text exposition format"
+};
+
+resource
+metrics_resource
+{
+	"/metrics", resource::opts
+	{
+		"Metrics from ircd::stats for a local scraper."
+	}
+};
+
+static bool
+is_loopback(const net::ipport &ipp)
+{
+	if(net::is_v4(ipp))
+		return (net::host4(ipp) >> 24) == 127;
+
+	// ::1 or an IPv4-mapped 127/8
+	const auto &ip(net::host6(ipp));
+	return ip == 1 || (uint64_t(ip >> 32) == 0xffff && ((ip >> 24) & 0xff) == 127);
+}
+
+resource::response
+get_metrics(client &client,
+            resource::request &request)
+{
+	// The registry discloses the load and activity of the server; it is only
+	// offered to a scraper on the same host (or behind a local proxy).
+	if(!is_loopback(remote(client)))
+		throw http::error
+		{
+			http::FORBIDDEN
+		};
+
+	std::stringstream ss;
+	stats::prometheus(ss);
+	const std::string str
+	{
+		ss.str()
+	};
+
+	return resource::response
+	{
+		client, string_view{str}, "text/plain; version=0.0.4"
+	};
+}
+
+resource::method
+getter
+{
+	metrics_resource, "GET", get_metrics
+};
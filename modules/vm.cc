@@ -14,6 +14,7 @@ namespace ircd::m::vm
 	extern hook<>::site commit_hook;
 	extern hook<>::site eval_hook;
 	extern hook<>::site notify_hook;
+	extern hook<>::site write_hook;
 
 	static void write_commit(eval &);
 	static fault _eval_edu(eval &, const event &);
@@ -58,6 +59,15 @@ ircd::m::vm::notify_hook
 	{ "name", "vm.notify" }
 };
 
+/// Called once an event which affects the present state is committed,
+/// before the eval yields again; in-memory indexes of the present state
+/// follow the database here. This is independent of opts.effects.
+decltype(ircd::m::vm::write_hook)
+ircd::m::vm::write_hook
+{
+	{ "name", "vm.write" }
+};
+
 //
 // init
 //
@@ -413,6 +423,10 @@ try
 	assert(eval.id);
 	assert(eval.ctx);
 
+	// Scratch memory taken during the eval is released when it's done; this
+	// nests within a request's scope (see allocator.h).
+	const allocator::arena::scope scratch;
+	const ircd::timer timer;
 	const auto &opts
 	{
 		*eval.opts
@@ -457,7 +471,10 @@ try
 	};
 
 	if(ret != fault::ACCEPT)
+	{
+		++stats::faults;
 		return ret;
+	}
 
 	vm::accepted accepted
 	{
@@ -476,10 +493,13 @@ try
 	if(opts.infolog_accept)
 		log.info("%s", pretty_oneline(event));
 
+	++stats::accepts;
+	stats::accept_time(timer.at<microseconds>().count());
 	return ret;
 }
 catch(const ctx::interrupted &e) // INTERRUPTION
 {
+	++stats::faults;
 	if(eval.opts->errorlog & fault::INTERRUPT)
 		log::error
 		{
@@ -500,6 +520,7 @@ catch(const ctx::interrupted &e) // INTERRUPTION
 }
 catch(const error &e) // VM FAULT CODE
 {
+	++stats::faults;
 	if(eval.opts->errorlog & e.code)
 		log::error
 		{
@@ -525,6 +546,7 @@ catch(const error &e) // VM FAULT CODE
 }
 catch(const m::error &e) // GENERAL MATRIX ERROR
 {
+	++stats::faults;
 	if(eval.opts->errorlog & fault::GENERAL)
 		log::error
 		{
@@ -550,6 +572,7 @@ catch(const m::error &e) // GENERAL MATRIX ERROR
 }
 catch(const std::exception &e) // ALL OTHER ERRORS
 {
+	++stats::faults;
 	if(eval.opts->errorlog & fault::GENERAL)
 		log::error
 		{
@@ -690,10 +713,67 @@ ircd::m::vm::_eval_pdu(eval &eval,
 	wopts.refs = opts.refs;
 	wopts.event_idx = eval.sequence;
 
+	// The member's ID is interned here, where yielding is allowed, so the
+	// indexers and the post-commit hooks find it in the table; a new
+	// assignment is committed with the event or not at all.
+	bool interned {false};
+	m::intern::handle member_handle {0};
+	if(opts.present && type == "m.room.member")
+		member_handle = m::intern::set(txn, at<"state_key"_>(event), interned);
+
+	const unwind::exceptional forget{[&interned, &member_handle]
+	{
+		if(interned)
+			m::intern::forget(member_handle);
+	}};
+
 	m::state::id_buffer new_root_buf;
 	wopts.root_out = new_root_buf;
 	string_view new_root;
-	if(prev_count)
+	m::state::id_buffer resolved_root_buf;
+	bool members_changed{false};
+	if(prev_count > 1)
+	{
+		// The event merges forks; the state at each of its prev_events is
+		// resolved into the state the event is applied to.
+		std::vector<m::state::id_buffer> prev_root_buf(prev_count);
+		std::vector<m::state::id> prev_root(prev_count);
+		size_t roots(0);
+		for(size_t i(0); i < prev_count; ++i) try
+		{
+			prev_root[roots] = dbs::state_root(prev_root_buf[roots], prev.prev_event(i));
+			roots += !empty(prev_root[roots]);
+		}
+		catch(const db::not_found &)
+		{
+			continue;
+		}
+
+		if(roots)
+		{
+			const vector_view<const m::state::id> roots_view
+			{
+				prev_root.data(), roots
+			};
+
+			// Member keys other than this event's may change; the in-memory
+			// index of the room's members is only kept for the event itself.
+			wopts.root_in = m::state::resolve(txn, resolved_root_buf, roots_view, [&members_changed]
+			(const json::array &key, const string_view &event_id)
+			{
+				members_changed |= unquote(key.at(0)) == "m.room.member";
+			});
+		}
+		else
+		{
+			m::room room{room_id, head};
+			m::room::state state{room};
+			wopts.root_in = state.root_id;
+		}
+
+		new_root = dbs::write(txn, event, wopts);
+	}
+	else if(prev_count)
 	{
 		m::room room{room_id, head};
 		m::room::state state{room};
@@ -706,6 +786,9 @@ ircd::m::vm::_eval_pdu(eval &eval,
 	}
 
 	write_commit(eval);
+	if(members_changed)
+		m::room::members::cache::invalidate(room_id);
+
 	return fault::ACCEPT;
 }
 
@@ -723,6 +806,10 @@ ircd::m::vm::write_commit(eval &eval)
 		};
 
 	txn();
+
+	assert(eval.event_);
+	if(eval.opts->present)
+		write_hook(*eval.event_);
 }
 
 uint64_t
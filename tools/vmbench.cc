@@ -0,0 +1,589 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2018 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+// Event ingest benchmark. IRCd is brought up without listeners against a
+// temporary database (and keys) and a set of synthetic rooms is evaluated
+// through m::vm. In the local mode events are committed by this server as
+// a client would (m::create/join/send); in the federation mode they are
+// fully formed remote events given to vm::eval directly, and the timeline
+// forks up to the given DAG width between merges. Modules are loaded from
+// the installed module path as usual. It isn't part of the default build:
+// make -C tools vmbench
+
+#include <ircd/ircd.h>
+#include <ircd/asio.h>
+#include <ftw.h>
+
+using namespace ircd;
+
+struct phase
+{
+	const char *name;
+	std::vector<nanoseconds> lat;
+	size_t bytes {0};
+};
+
+struct opts
+{
+	size_t rooms {8};
+	size_t members {32};
+	size_t state {64};
+	size_t events {1000};
+	size_t width {4};
+	bool federation {false};
+	bool keep {false};
+};
+
+static void usage(const char *const &name);
+static bool parseargs(int argc, char *const *argv, opts &);
+static std::string make_conf(const std::string &dir, const string_view &origin);
+static void report(const std::vector<phase> &, const nanoseconds &total);
+static void bench(const opts &);
+
+static const string_view remote_origin
+{
+	"remote.bench"
+};
+
+std::unique_ptr<boost::asio::io_context> bench_ios
+{
+	std::make_unique<boost::asio::io_context>()
+};
+
+int main(int argc, char *const *argv)
+try
+{
+	opts opts;
+	if(!parseargs(argc, argv, opts))
+	{
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	char dirbuf[] {"/tmp/vmbench.XXXXXX"};
+	if(!::mkdtemp(dirbuf))
+		throw std::system_error{errno, std::system_category(), "mkdtemp"};
+
+	const std::string dir
+	{
+		dirbuf
+	};
+
+	const unwind cleanup{[&opts, &dir]
+	{
+		if(opts.keep)
+		{
+			printf("kept %s\n", dir.c_str());
+			return;
+		}
+
+		::nftw(dir.c_str(), []
+		(const char *path, const struct stat *, int, struct FTW *)
+		{
+			return ::remove(path);
+		}, 16, FTW_DEPTH | FTW_PHYS);
+	}};
+
+	const std::string dbdir
+	{
+		fs::make_path({string_view{dir}, "db"})
+	};
+
+	fs::set(fs::DB, string_view{dbdir});
+	ircd::nolisten = true;
+	ircd::init(*bench_ios, make_conf(dir, "bench.localhost"));
+
+	std::exception_ptr eptr;
+	const ircd::runlevel_changed handler{[&opts, &eptr]
+	(const auto &runlevel)
+	{
+		if(runlevel != ircd::runlevel::RUN)
+			return;
+
+		ircd::context
+		{
+			"vmbench", 1_MiB, [&opts, &eptr]
+			{
+				const unwind quit{[]
+				{
+					ircd::quit();
+				}};
+
+				try
+				{
+					bench(opts);
+				}
+				catch(...)
+				{
+					eptr = std::current_exception();
+				}
+			},
+			ircd::context::flags(ircd::context::DETACH | ircd::context::POST)
+		};
+	}};
+
+	bench_ios->run();
+	if(eptr)
+		std::rethrow_exception(eptr);
+
+	return EXIT_SUCCESS;
+}
+catch(const std::exception &e)
+{
+	fprintf(stderr, "vmbench: %s\n", e.what());
+	return EXIT_FAILURE;
+}
+
+void
+usage(const char *const &name)
+{
+	fprintf(stderr,
+	        "usage: %s [-rooms N] [-members N] [-state N] [-events N] [-width N] [-federation] [-keep]\n"
+	        "  -rooms       rooms to create (8)\n"
+	        "  -members     most members joined to a room; rooms vary up to this (32)\n"
+	        "  -state       most state events in a room; rooms vary up to this (64)\n"
+	        "  -events      timeline messages per room (1000)\n"
+	        "  -width       DAG width of the timeline in federation mode (4)\n"
+	        "  -federation  evaluate remote events rather than committing local ones\n"
+	        "  -keep        keep the temporary directory afterward\n",
+	        name);
+}
+
+bool
+parseargs(int argc,
+          char *const *argv,
+          opts &opts)
+try
+{
+	for(int i(1); i < argc; ++i)
+	{
+		const string_view arg{argv[i]};
+		const auto next{[&]
+		{
+			if(++i >= argc)
+				throw ircd::error{"missing value for %s", arg};
+
+			return lex_cast<size_t>(string_view{argv[i]});
+		}};
+
+		if(arg == "-rooms")
+			opts.rooms = next();
+		else if(arg == "-members")
+			opts.members = next();
+		else if(arg == "-state")
+			opts.state = next();
+		else if(arg == "-events")
+			opts.events = next();
+		else if(arg == "-width")
+			opts.width = std::max(next(), 1UL);
+		else if(arg == "-federation")
+			opts.federation = true;
+		else if(arg == "-keep")
+			opts.keep = true;
+		else
+			return false;
+	}
+
+	return opts.rooms > 0;
+}
+catch(const std::exception &e)
+{
+	fprintf(stderr, "%s\n", e.what());
+	return false;
+}
+
+/// The least configuration to bring up an origin; its keys and certificate
+/// are generated into the temporary directory.
+std::string
+make_conf(const std::string &dir,
+          const string_view &origin)
+{
+	const std::string path
+	{
+		fs::make_path({string_view{dir}, "ircd.conf"})
+	};
+
+	const json::strung conf{json::members
+	{
+		{ "ircd", json::members
+		{
+			{ "origin", origin },
+		}},
+		{ "origin", json::members
+		{
+			{ origin, json::members
+			{
+				{ "ssl_private_key_pem_path",  fs::make_path({string_view{dir}, "tls.key"})      },
+				{ "ssl_certificate_pem_path",  fs::make_path({string_view{dir}, "tls.crt"})      },
+				{ "ed25519_private_key_path",  fs::make_path({string_view{dir}, "ed25519.key"})  },
+			}},
+		}},
+		{ "certificate", json::members
+		{
+			{ origin, json::members
+			{
+				{ "subject", json::members
+				{
+					{ "CN", origin },
+				}},
+			}},
+		}},
+	}};
+
+	fs::overwrite(string_view{path}, string_view{conf});
+	return path;
+}
+
+//
+// bench
+//
+
+namespace
+{
+	// Time one eval (or commit) into the phase.
+	template<class closure>
+	void timed(phase &phase, closure&& c)
+	{
+		const steady_point start{now<steady_point>()};
+		c();
+		phase.lat.emplace_back(now<steady_point>() - start);
+	}
+
+	// Forms and evaluates one remote event; returns its id.
+	struct remote
+	{
+		const m::room::id &room_id;
+		m::vm::opts opts;
+		size_t ctr {0};
+
+		m::event::id::buf
+		operator()(phase &phase,
+		           const m::user::id &sender,
+		           const string_view &type,
+		           const string_view &state_key,
+		           const json::members &content,
+		           const vector_view<const m::event::id::buf> &prev,
+		           const int64_t &depth);
+
+		remote(const m::room::id &room_id);
+	};
+}
+
+remote::remote(const m::room::id &room_id)
+:room_id{room_id}
+{
+	// Synthetic events carry no hashes or signatures and their origin's
+	// keys are not to be fetched; everything else is evaluated as usual.
+	opts.verify = false;
+	opts.conforming = false;
+	opts.notify = false;
+}
+
+m::event::id::buf
+remote::operator()(phase &phase,
+                   const m::user::id &sender,
+                   const string_view &type,
+                   const string_view &state_key,
+                   const json::members &content,
+                   const vector_view<const m::event::id::buf> &prev,
+                   const int64_t &depth)
+{
+	const fmt::bsprintf<64> local
+	{
+		"%s.%zu", room_id.localname(), ++ctr
+	};
+
+	const m::event::id::buf event_id
+	{
+		local, remote_origin
+	};
+
+	std::vector<std::array<json::value, 2>> refs(prev.size());
+	std::vector<json::value> prevs(prev.size());
+	for(size_t i(0); i < prev.size(); ++i)
+	{
+		refs[i][0] = json::value{prev[i], json::STRING};
+		refs[i][1] = json::value{json::empty_object, json::OBJECT};
+		prevs[i] = json::value{refs[i].data(), refs[i].size()};
+	}
+
+	const json::value prev_events
+	{
+		prevs.data(), prevs.size()
+	};
+
+	json::iov event;
+	const json::iov::push push[]
+	{
+		{ event, { "auth_events",       json::empty_array                      }},
+		{ event, { "content",           content                                }},
+		{ event, { "depth",             depth                                  }},
+		{ event, { "event_id",          event_id                               }},
+		{ event, { "hashes",            json::empty_object                     }},
+		{ event, { "origin",            remote_origin                          }},
+		{ event, { "origin_server_ts",  ircd::time<milliseconds>()             }},
+		{ event, { "prev_events",       prev_events                            }},
+		{ event, { "room_id",           room_id                                }},
+		{ event, { "sender",            sender                                 }},
+		{ event, { "signatures",        json::empty_object                     }},
+		{ event, { "type",              type                                   }},
+	};
+
+	const json::iov::add_if _state_key
+	{
+		event, bool(state_key), { "state_key", state_key }
+	};
+
+	const json::strung strung
+	{
+		event
+	};
+
+	const m::event ev
+	{
+		json::object{strung}
+	};
+
+	phase.bytes += size(string_view{strung});
+	timed(phase, [&ev, this]
+	{
+		m::vm::eval
+		{
+			ev, opts
+		};
+	});
+
+	return event_id;
+}
+
+void
+bench(const opts &opts)
+{
+	auto &events(*m::dbs::events);
+	const auto ticker{[&events](const string_view &name)
+	{
+		return db::ticker(events, name);
+	}};
+
+	// Bring the database to a quiescent state before the counters are
+	// sampled so the bootstrap isn't counted.
+	db::sort(events, true);
+	const uint64_t written_before(ticker("rocksdb.bytes.written"));
+	const uint64_t wal_before(ticker("rocksdb.wal.bytes"));
+	const uint64_t flush_before(ticker("rocksdb.flush.write.bytes"));
+	const uint64_t compact_before(ticker("rocksdb.compact.write.bytes"));
+	const size_t state_nodes_before(db::property<db::prop_int>(m::dbs::state_node, "rocksdb.estimate-num-keys"));
+	const size_t state_bytes_before(db::bytes(m::dbs::state_node));
+
+	std::vector<phase> phases
+	{
+		{ "create"   },
+		{ "member"   },
+		{ "state"    },
+		{ "timeline" },
+	};
+
+	auto &create(phases.at(0)), &member(phases.at(1)), &state(phases.at(2)), &timeline(phases.at(3));
+	const steady_point start{now<steady_point>()};
+	for(size_t r(0); r < opts.rooms; ++r)
+	{
+		// Rooms range from small to the given maximums.
+		const size_t members(std::max(opts.members * (r + 1) / opts.rooms, 1UL));
+		const size_t states(opts.state * (r + 1) / opts.rooms);
+		const string_view origin
+		{
+			opts.federation? remote_origin : m::my_host()
+		};
+
+		const fmt::bsprintf<64> room_local{"bench%zu", r};
+		const m::room::id::buf room_id{room_local, origin};
+		const m::user::id::buf creator{"bench", origin};
+		const auto user{[&origin](const size_t &i)
+		{
+			const fmt::bsprintf<64> local{"bench%zu", i};
+			return m::user::id::buf{local, origin};
+		}};
+
+		if(!opts.federation)
+		{
+			const m::room room{room_id};
+			timed(create, [&]
+			{
+				m::create(room_id, creator);
+			});
+
+			for(size_t i(1); i < members; ++i)
+				timed(member, [&]
+				{
+					m::join(room, user(i));
+				});
+
+			for(size_t i(0); i < states; ++i)
+			{
+				const fmt::bsprintf<32> state_key{"%zu", i};
+				timed(state, [&]
+				{
+					m::send(room, creator, "bench.state", state_key, json::members
+					{
+						{ "value", int64_t(i) }
+					});
+				});
+			}
+
+			for(size_t i(0); i < opts.events; ++i)
+				timed(timeline, [&]
+				{
+					m::message(room, user(i % members), "The quick brown fox jumps over the lazy dog.");
+				});
+
+			continue;
+		}
+
+		// Federation: the room is a single chain up to the timeline, which
+		// then forks up to the DAG width and periodically merges.
+		remote eval{room_id};
+		int64_t depth{0};
+		std::vector<m::event::id::buf> tips;
+		const auto chain{[&](phase &phase, const m::user::id &sender, const string_view &type, const string_view &state_key, const json::members &content)
+		{
+			auto id(eval(phase, sender, type, state_key, content, tips, ++depth));
+			tips.clear();
+			tips.emplace_back(std::move(id));
+		}};
+
+		chain(create, creator, "m.room.create", "", json::members
+		{
+			{ "creator", creator }
+		});
+
+		for(size_t i(0); i < members; ++i)
+		{
+			const auto user_id(i? user(i) : m::user::id::buf{creator});
+			chain(member, user_id, "m.room.member", user_id, json::members
+			{
+				{ "membership", "join" }
+			});
+		}
+
+		for(size_t i(0); i < states; ++i)
+		{
+			const fmt::bsprintf<32> state_key{"%zu", i};
+			chain(state, creator, "bench.state", state_key, json::members
+			{
+				{ "value", int64_t(i) }
+			});
+		}
+
+		std::vector<int64_t> depths(1, depth);
+		for(size_t i(0); i < opts.events; ++i)
+		{
+			const json::members content
+			{
+				{ "msgtype", "m.text" },
+				{ "body", "The quick brown fox jumps over the lazy dog." },
+			};
+
+			const auto sender(user(i % members));
+			if(tips.size() >= opts.width && i % opts.width == 0)
+			{
+				// Merge every tip.
+				const int64_t d(*std::max_element(begin(depths), end(depths)) + 1);
+				auto id(eval(timeline, sender, "m.room.message", {}, content, tips, d));
+				tips.assign(1, std::move(id));
+				depths.assign(1, d);
+				continue;
+			}
+
+			// Extend one tip; fork from it while below the width.
+			const size_t t(i % tips.size());
+			const int64_t d(depths.at(t) + 1);
+			auto id(eval(timeline, sender, "m.room.message", {}, content, vector_view<const m::event::id::buf>(&tips.at(t), 1), d));
+			if(tips.size() < opts.width)
+			{
+				tips.emplace_back(std::move(id));
+				depths.emplace_back(d);
+			}
+			else
+			{
+				tips.at(t) = std::move(id);
+				depths.at(t) = d;
+			}
+		}
+	}
+
+	const nanoseconds total(now<steady_point>() - start);
+	report(phases, total);
+
+	db::sort(events, true);
+	const uint64_t written(ticker("rocksdb.bytes.written") - written_before);
+	const uint64_t wal(ticker("rocksdb.wal.bytes") - wal_before);
+	const uint64_t flushed(ticker("rocksdb.flush.write.bytes") - flush_before);
+	const uint64_t compacted(ticker("rocksdb.compact.write.bytes") - compact_before);
+	const size_t state_nodes(db::property<db::prop_int>(m::dbs::state_node, "rocksdb.estimate-num-keys"));
+	const size_t state_bytes(db::bytes(m::dbs::state_node));
+
+	size_t bytes(0), evals(0);
+	for(const auto &phase : phases)
+	{
+		bytes += phase.bytes;
+		evals += phase.lat.size();
+	}
+
+	printf("\n");
+	if(bytes)
+		printf("%-22s %zu\n", "event bytes", bytes);
+
+	printf("%-22s %lu\n", "db bytes written", written);
+	printf("%-22s %lu wal, %lu flush, %lu compaction\n", "db bytes to disk", wal, flushed, compacted);
+	printf("%-22s %.2f\n", "write amplification", written? double(wal + flushed + compacted) / written : 0.0);
+	printf("%-22s %zu (+%zd)\n", "state_node keys", state_nodes, ssize_t(state_nodes - state_nodes_before));
+	printf("%-22s %zu (+%zd)\n", "state_node bytes", state_bytes, ssize_t(state_bytes - state_bytes_before));
+	printf("%-22s %.1f\n", "state_node per event", evals? double(state_nodes - state_nodes_before) / evals : 0.0);
+}
+
+void
+report(const std::vector<phase> &phases,
+       const nanoseconds &total)
+{
+	const auto pct{[](std::vector<nanoseconds> lat, const double &p)
+	{
+		if(lat.empty())
+			return 0L;
+
+		const size_t i(std::min(size_t(lat.size() * p), lat.size() - 1));
+		std::nth_element(begin(lat), begin(lat) + i, end(lat));
+		return long(duration_cast<microseconds>(lat.at(i)).count());
+	}};
+
+	printf("%-10s %10s %12s %10s %10s %10s\n", "phase", "events", "events/s", "p50 us", "p99 us", "max us");
+
+	size_t count(0);
+	for(const auto &phase : phases)
+	{
+		const nanoseconds sum
+		{
+			std::accumulate(begin(phase.lat), end(phase.lat), nanoseconds(0))
+		};
+
+		count += phase.lat.size();
+		printf("%-10s %10zu %12.1f %10ld %10ld %10ld\n",
+		       phase.name,
+		       phase.lat.size(),
+		       sum.count()? phase.lat.size() / (sum.count() / 1e9) : 0.0,
+		       pct(phase.lat, 0.50),
+		       pct(phase.lat, 0.99),
+		       pct(phase.lat, 1.00));
+	}
+
+	printf("%-10s %10zu %12.1f\n",
+	       "total",
+	       count,
+	       total.count()? count / (total.count() / 1e9) : 0.0);
+}